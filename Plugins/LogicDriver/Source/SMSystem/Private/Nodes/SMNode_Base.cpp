@@ -3,7 +3,111 @@
 #include "SMUtils.h"
 #include "SMLogging.h"
 #include "SMNodeInstance.h"
+#include "SMInstance.h"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("SMNetworkedTransaction Transactions Sent"), STAT_SMNetworkedTransaction_TransactionsSent, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SMNetworkedTransaction Bytes Sent"), STAT_SMNetworkedTransaction_BytesSent, STATGROUP_LogicDriver);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("SMNetworkedTransaction Bytes Per Transaction"), STAT_SMNetworkedTransaction_BytesPerTransaction, STATGROUP_LogicDriver);
+
+void FSMNetworkedTransaction::AssignNodeIndices(USMInstance* Instance)
+{
+	StateMachineIndex = Instance->GetNetworkNodeIndex(StateMachineGuid);
+	BaseIndex = Instance->GetNetworkNodeIndex(BaseGuid);
+}
+
+bool FSMNetworkedTransaction::ResolveNodeGuids(USMInstance* Instance)
+{
+	if (!HasNodeIndices())
+	{
+		// Full guids were replicated.
+		return true;
+	}
+
+	const FGuid* NetworkStateMachineGuid = Instance->GetNetworkNodeGuid(StateMachineIndex);
+	const FGuid* NetworkBaseGuid = Instance->GetNetworkNodeGuid(BaseIndex);
+	if (!NetworkStateMachineGuid || !NetworkBaseGuid)
+	{
+		return false;
+	}
+
+	StateMachineGuid = *NetworkStateMachineGuid;
+	BaseGuid = *NetworkBaseGuid;
+	return true;
+}
+
+bool FSMNetworkedTransaction::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// Frames are capped so the delta always fits a small packed int. Transactions expire long before this.
+	const uint32 MaxFrameDelta = 0xFFFF;
+
+	uint8 bType = TransactionType;
+	uint8 bActive = bIsActive;
+	uint8 bHasIndices = HasNodeIndices();
+	Ar.SerializeBits(&bType, 1);
+	Ar.SerializeBits(&bActive, 1);
+	Ar.SerializeBits(&bHasIndices, 1);
+
+	// Header bits.
+	int32 NumBits = 3;
+	auto GetPackedBits = [](uint32 Value)
+	{
+		int32 Bytes = 1;
+		while (Value >= 128)
+		{
+			Value >>= 7;
+			Bytes++;
+		}
+		return Bytes * 8;
+	};
+
+	if (bHasIndices)
+	{
+		uint32 PackedStateMachineIndex = (uint32)StateMachineIndex;
+		uint32 PackedBaseIndex = (uint32)BaseIndex;
+		Ar.SerializeIntPacked(PackedStateMachineIndex);
+		Ar.SerializeIntPacked(PackedBaseIndex);
+		StateMachineIndex = (int32)PackedStateMachineIndex;
+		BaseIndex = (int32)PackedBaseIndex;
+		NumBits += GetPackedBits(PackedStateMachineIndex) + GetPackedBits(PackedBaseIndex);
+	}
+	else
+	{
+		Ar << StateMachineGuid;
+		Ar << BaseGuid;
+		if (Ar.IsLoading())
+		{
+			StateMachineIndex = BaseIndex = INDEX_NONE;
+		}
+		NumBits += sizeof(FGuid) * 2 * 8;
+	}
+
+	Ar << TransactionGuid;
+	NumBits += sizeof(FGuid) * 8;
+
+	uint32 FrameDelta = 0;
+	if (Ar.IsSaving() && Frame > 0)
+	{
+		FrameDelta = (uint32)FMath::Min<uint64>(GFrameCounter - FMath::Min(Frame, GFrameCounter), MaxFrameDelta);
+	}
+	Ar.SerializeIntPacked(FrameDelta);
+	NumBits += GetPackedBits(FrameDelta);
+
+	if (Ar.IsLoading())
+	{
+		TransactionType = bType;
+		bIsActive = bActive;
+		Frame = GFrameCounter - FMath::Min<uint64>(FrameDelta, GFrameCounter);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_SMNetworkedTransaction_TransactionsSent);
+		INC_DWORD_STAT_BY(STAT_SMNetworkedTransaction_BytesSent, FMath::DivideAndRoundUp(NumBits, 8));
+		SET_FLOAT_STAT(STAT_SMNetworkedTransaction_BytesPerTransaction, NumBits / 8.f);
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
 
 FSMNode_Base::FSMNode_Base() : TimeInState(0), bIsInEndState(false), bHasUpdated(false), DuplicateId(0),
 OwnerNode(nullptr),
@@ -71,6 +175,11 @@ void FSMNode_Base::CalculatePathGuid(TMap<FString, int32>& MappedPaths)
 	USMUtils::PathToGuid(GetGuidPath(MappedPaths), &PathGuid);
 }
 
+void FSMNode_Base::SetPathGuid(const FGuid& NewGuid)
+{
+	PathGuid = NewGuid;
+}
+
 FString FSMNode_Base::GetGuidPath(TMap<FString, int32>& MappedPaths) const
 {
 	TArray<const FSMNode_Base*> Owners;
@@ -35,6 +35,11 @@ bool FSMConduit::StartState()
 {
 	const bool bResult = Super::StartState();
 
+	if (ShouldSkipStateBegin())
+	{
+		return bResult;
+	}
+	
 	ConduitEnteredGraphEvaluator.Execute();
 	
 	if(USMConduitInstance* ConduitInstance = Cast<USMConduitInstance>(GetNodeInstance()))
@@ -82,7 +87,15 @@ bool FSMConduit::GetValidTransition(TArray<TArray<FSMTransition*>>& Transitions)
 #endif
 	
 	// First check that the conduit passes.
-	Execute();
+	bool bFastPathResult = false;
+	if (GraphEvaluator.TryEvaluateFastPath(bFastPathResult))
+	{
+		bCanEnterTransition = bFastPathResult;
+	}
+	else
+	{
+		Execute();
+	}
 
 	bIsEvaluating = false;
 	
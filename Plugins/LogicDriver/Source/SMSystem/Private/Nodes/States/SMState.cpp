@@ -97,14 +97,15 @@ bool FSMState_Base::StartState()
 
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMState_Base::StartState"), STAT_SMState_Start, STATGROUP_LogicDriver);
 
-	if (CanExecuteGraphProperties(GRAPH_PROPERTY_EVAL_ON_START))
+	if (!bSkipStateBegin && CanExecuteGraphProperties(GRAPH_PROPERTY_EVAL_ON_START))
 	{
 		ExecuteGraphProperties();
 	}
 
 	SetActive(true);
 	
-	if (USMStateInstance_Base* StateInstance = Cast<USMStateInstance_Base>(NodeInstance))
+	USMStateInstance_Base* StateInstance = Cast<USMStateInstance_Base>(NodeInstance);
+	if (StateInstance && !bSkipStateBegin)
 	{
 		StateInstance->OnStateBeginEvent.Broadcast(StateInstance);
 	}
@@ -206,10 +207,11 @@ bool FSMState_Base::GetValidTransition(TArray<TArray<FSMTransition*>>& Transitio
 	
 	for(FSMTransition* Transition : OutgoingTransitions)
 	{
+		// Only allocates if the transition passes.
 		TArray<FSMTransition*> Chain;
 		if(Transition->CanTransition(Chain))
 		{
-			Transitions.Add(Chain);
+			Transitions.Add(MoveTemp(Chain));
 
 			// Check if blocking or not.
 			if (IsConduit() || !Transition->bRunParallel)
@@ -401,7 +403,7 @@ bool FSMState::StartState()
 		return false;
 	}
 
-	if (CanExecuteLogic())
+	if (CanExecuteLogic() && !ShouldSkipStateBegin())
 	{
 		Execute();
 
@@ -40,8 +40,19 @@ void FSMStateMachine::ProcessStates(float DeltaSeconds, bool bForceTransitionEva
 		return;
 	}
 
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMStateMachine::ProcessStates"), STAT_SMStateMachine_ProcessStates, STATGROUP_LogicDriver);
+	
 	bool bStateChanged = false;
-	TArray<FSMState_Base*> ActiveStatesCopy = GetActiveStates();
+
+	// States can be entered or exited while processing. Copy to the stack, most state machines only have a few active states.
+	const TSet<FSMState_Base*>& StatesToProcess = HasActiveStates() ? ActiveStates : TemporaryEntryStates;
+	TArray<FSMState_Base*, TInlineAllocator<SM_INLINE_ACTIVE_STATES>> ActiveStatesCopy;
+	ActiveStatesCopy.Reserve(StatesToProcess.Num());
+	for (FSMState_Base* State : StatesToProcess)
+	{
+		ActiveStatesCopy.Add(State);
+	}
+	
 	for (FSMState_Base* CurrentState : ActiveStatesCopy)
 	{
 		bool bStateJustStarted = false;
@@ -94,6 +105,7 @@ void FSMStateMachine::ProcessStates(float DeltaSeconds, bool bForceTransitionEva
 			}
 		}
 		
+		// Transitions found by a parallel evaluation are always checked again here with the current conditions.
 		TArray<TArray<FSMTransition*>> ParallelTransitionChains;
 		if (bCanCheckTransitions && CurrentState->GetValidTransition(ParallelTransitionChains))
 		{
@@ -165,11 +177,86 @@ void FSMStateMachine::ProcessStates(float DeltaSeconds, bool bForceTransitionEva
 	ProcessingStates.Reset();
 }
 
-bool FSMStateMachine::ProcessTransition(FSMTransition* Transition, const FSMNetworkedTransaction* Transaction, float DeltaSeconds, FDateTime* CurrentTime)
+bool FSMStateMachine::HasPendingTransitionEvent(FSMState_Base* State)
+{
+	for (FSMTransition* Transition : State->GetOutgoingTransitions())
+	{
+		if (Transition->bCanEnterTransitionFromEvent || (Transition->bEvaluateOnSignal && Transition->HasPendingSignal()))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FSMStateMachine::PreEvaluateTransitions()
+{
+	PreEvaluatedTransitions.Reset();
+
+	// References are evaluated by their own instance during the update.
+	if (ReferencedStateMachine || bWaitingForTransitionUpdate || !bCanEvaluateTransitions)
+	{
+		return;
+	}
+
+	for (FSMState_Base* CurrentState : ActiveStates)
+	{
+		// Only evaluate states which ProcessStates would evaluate during a normal update.
+		if (!CurrentState->IsActive() || CurrentState->HasBeenReenteredFromParallelState() || CurrentState->IsStateEnding() ||
+			!CurrentState->CanEvaluateTransitionsOnTick())
+		{
+			continue;
+		}
+
+		// Evaluating a transition consumes its event or signal, which would be lost if the results end up unused.
+		if (HasPendingTransitionEvent(CurrentState))
+		{
+			continue;
+		}
+
+		// Anything which could run blueprint or node instance logic is left to the game thread.
+		bool bIsThreadSafe = true;
+		for (FSMTransition* Transition : CurrentState->GetOutgoingTransitions())
+		{
+			if (!Transition->CanEvaluateOnAnyThread())
+			{
+				bIsThreadSafe = false;
+				break;
+			}
+		}
+		if (!bIsThreadSafe)
+		{
+			continue;
+		}
+
+		if (CurrentState->IsStateMachine())
+		{
+			FSMStateMachine* NestedStateMachine = (FSMStateMachine*)CurrentState;
+			NestedStateMachine->PreEvaluateTransitions();
+			if (NestedStateMachine->bWaitForEndState && !NestedStateMachine->IsInEndState())
+			{
+				continue;
+			}
+		}
+
+		// Only passing transitions are kept, a state without one is still evaluated during the update in case its conditions change.
+		TArray<TArray<FSMTransition*>> TransitionChains;
+		if (CurrentState->GetValidTransition(TransitionChains))
+		{
+			for (const TArray<FSMTransition*>& TransitionChain : TransitionChains)
+			{
+				PreEvaluatedTransitions.Add(TransitionChain[0]);
+			}
+		}
+	}
+}
+
+bool FSMStateMachine::ProcessTransition(FSMTransition* Transition, const FSMNetworkedTransaction* Transaction, float DeltaSeconds)
 {
 	if (ReferencedStateMachine)
 	{
-		return ReferencedStateMachine->GetRootStateMachine().ProcessTransition(Transition, Transaction, DeltaSeconds, CurrentTime);
+		return ReferencedStateMachine->GetRootStateMachine().ProcessTransition(Transition, Transaction, DeltaSeconds);
 	}
 
 	const bool bServerUpdate = Transaction != nullptr;
@@ -224,7 +311,7 @@ bool FSMStateMachine::ProcessTransition(FSMTransition* Transition, const FSMNetw
 	if (!bServerUpdate && IsNetworked())
 	{
 		FSMNetworkedTransaction NewTransition(GetGuid(), Transition->GetGuid());
-		NewTransition.Timestamp = CurrentTime ? *CurrentTime : FDateTime::UtcNow();
+		NewTransition.Frame = GFrameCounter;
 		
 		// Don't follow this transition a second time.
 		if (bCanTransitionNow)
@@ -248,17 +335,15 @@ bool FSMStateMachine::ProcessTransition(FSMTransition* Transition, const FSMNetw
 	return bCanTransitionNow;
 }
 
-void FSMStateMachine::CleanupPreviousTransactions(const FDateTime& CurrentTime, float PreviousTransactionTimeout)
+void FSMStateMachine::CleanupPreviousTransactions(uint64 CurrentFrame, uint64 ExpirationFrames)
 {
 	// Check for and remove expired transactions.
 	if (PreviousTransactions.Num())
 	{
 		TArray<FGuid> TransactionsToRemove;
-		const FTimespan Seconds = FTimespan::FromSeconds((double)PreviousTransactionTimeout);
 		for (const auto& PreviousTransaction : PreviousTransactions)
 		{
-			FDateTime ExpirationDate = PreviousTransaction.Value.Timestamp + Seconds;
-			if (ExpirationDate <= CurrentTime)
+			if (PreviousTransaction.Value.Frame + ExpirationFrames <= CurrentFrame)
 			{
 				TransactionsToRemove.Add(PreviousTransaction.Key);
 			}
@@ -337,7 +422,10 @@ void FSMStateMachine::AddActiveState(FSMState_Base* State, bool bReplicate)
 void FSMStateMachine::RemoveActiveState(FSMState_Base* State, bool bReplicate)
 {
 	State->EndState(0.f);
-	ActiveStates.Remove(State);
+	if (ActiveStates.Remove(State) > 0)
+	{
+		NotifyActiveStateChanged(State, false);
+	}
 
 	if (USMInstance* Instance = GetOwningInstance())
 	{
@@ -363,7 +451,10 @@ void FSMStateMachine::SetCurrentState(FSMState_Base* ToState, FSMState_Base* Fro
 	
 	if (FromState && !FromState->bStayActiveOnStateChange)
 	{
-		ActiveStates.Remove(FromState);
+		if (ActiveStates.Remove(FromState) > 0)
+		{
+			NotifyActiveStateChanged(FromState, false);
+		}
 	}
 
 	if (ToState)
@@ -377,6 +468,7 @@ void FSMStateMachine::SetCurrentState(FSMState_Base* ToState, FSMState_Base* Fro
 		else
 		{
 			ActiveStates.Add(ToState);
+			NotifyActiveStateChanged(ToState, true);
 		}
 	}
 
@@ -400,6 +492,20 @@ void FSMStateMachine::SetCurrentState(FSMState_Base* ToState, FSMState_Base* Fro
 	}
 }
 
+void FSMStateMachine::NotifyActiveStateChanged(FSMState_Base* State, bool bIsActive)
+{
+	// Active states of a reference are tracked by the referenced instance.
+	if (ReferencedStateMachine)
+	{
+		return;
+	}
+	
+	if (USMInstance* Instance = GetOwningInstance())
+	{
+		Instance->NotifyActiveStateChanged(State, bIsActive);
+	}
+}
+
 void FSMStateMachine::Initialize(UObject* Instance)
 {
 	Super::Initialize(Instance);
@@ -436,13 +542,13 @@ bool FSMStateMachine::StartState()
 
 	if(bHasAdditionalLogic)
 	{
-		if (CanExecuteLogic())
+		if (CanExecuteLogic() && !ShouldSkipStateBegin())
 		{
 			Execute();
 		}
 		
-		// The additional logic will call start on the instance.
-		if (ReferencedStateMachine)
+		// The additional logic will call start on the instance unless it was skipped.
+		if (ReferencedStateMachine && !ShouldSkipStateBegin())
 		{
 			return true;
 		}
@@ -466,7 +572,8 @@ bool FSMStateMachine::StartState()
 		}
 	}
 
-	if (USMStateMachineInstance* Instance = Cast<USMStateMachineInstance>(GetNodeInstance()))
+	USMStateMachineInstance* Instance = Cast<USMStateMachineInstance>(GetNodeInstance());
+	if (Instance && !ShouldSkipStateBegin())
 	{
 		Instance->OnStateBegin();
 	}
@@ -704,12 +811,27 @@ void FSMStateMachine::AddTemporaryInitialState(FSMState_Base* State)
 		return;
 	}
 
+	const bool bHadTemporaryEntryStates = HasTemporaryEntryStates();
 	TemporaryEntryStates.Add(State);
+
+	if (USMInstance* Instance = GetOwningInstance())
+	{
+		Instance->NotifyTemporaryEntryStatesChanged(bHadTemporaryEntryStates ? 0 : 1);
+	}
 }
 
 void FSMStateMachine::ClearTemporaryInitialStates()
 {
+	const bool bHadTemporaryEntryStates = HasTemporaryEntryStates();
 	TemporaryEntryStates.Empty();
+
+	if (bHadTemporaryEntryStates && !ReferencedStateMachine)
+	{
+		if (USMInstance* Instance = GetOwningInstance())
+		{
+			Instance->NotifyTemporaryEntryStatesChanged(-1);
+		}
+	}
 }
 
 const TSet<FSMState_Base*>& FSMStateMachine::GetEntryStates() const
@@ -44,7 +44,8 @@ FSMTransition::FSMTransition() : Super(), Priority(0), bCanEnterTransition(false
                                  bIsEvaluating(false), bCanEvaluate(true), bCanEvaluateFromEvent(true),
                                  bRunParallel(false),
                                  bEvalIfNextStateActive(true), bCanEvalWithStartState(true),
-                                 bAlwaysFalse(false), ConditionalEvaluationType(), FromState(nullptr), ToState(nullptr)
+                                 bAlwaysFalse(false), bEvaluateOnSignal(false), ConditionalEvaluationType(), FromState(nullptr), ToState(nullptr),
+                                 bHasPendingSignal(false)
 {
 }
 
@@ -60,6 +61,7 @@ void FSMTransition::Initialize(UObject* Instance)
 void FSMTransition::Reset()
 {
 	Super::Reset();
+	bHasPendingSignal = false;
 	TransitionEnteredGraphEvaluator.Reset();
 	TransitionPreEvaluateGraphEvaluator.Reset();
 	TransitionPostEvaluateGraphEvaluator.Reset();
@@ -79,6 +81,9 @@ void FSMTransition::ExecuteInitializeNodes()
 {
 	Super::ExecuteInitializeNodes();
 
+	// Always evaluate once when the state leading to this transition starts.
+	bHasPendingSignal = bEvaluateOnSignal;
+
 	if (ToState->IsConduit())
 	{
 		ToState->ExecuteInitializeNodes();
@@ -127,6 +132,14 @@ bool FSMTransition::DoesTransitionPass()
 	{
 		return false;
 	}
+
+	// Sleeping transitions don't run any graphs unless an auto-bound event has fired.
+	if (IsWaitingForSignal() && !(CanEvaluateFromEvent() && bCanEnterTransitionFromEvent))
+	{
+		bCanEnterTransition = false;
+		return false;
+	}
+	bHasPendingSignal = false;
 	
 	TransitionEvaluatorHelper Evaluator(this);	// Sets bIsEvaluating = false on destruct.
 
@@ -151,7 +164,15 @@ bool FSMTransition::DoesTransitionPass()
 		}
 		else
 		{
-			Execute();
+			bool bFastPathResult = false;
+			if (GraphEvaluator.TryEvaluateFastPath(bFastPathResult))
+			{
+				bCanEnterTransition = bFastPathResult;
+			}
+			else
+			{
+				Execute();
+			}
 		}
 	}
 	else
@@ -162,6 +183,31 @@ bool FSMTransition::DoesTransitionPass()
 	return bCanEnterTransition;
 }
 
+bool FSMTransition::CanEvaluateOnAnyThread() const
+{
+	if (TransitionPreEvaluateGraphEvaluator.IsBound() || TransitionPostEvaluateGraphEvaluator.IsBound())
+	{
+		return false;
+	}
+
+	// A conduit evaluated as a transition runs its own graph.
+	if (ToState->IsConduit() && ((FSMConduit*)ToState)->IsConfiguredAsTransition())
+	{
+		return false;
+	}
+
+	switch (ConditionalEvaluationType)
+	{
+	case ESMConditionalEvaluationType::SM_AlwaysFalse:
+	case ESMConditionalEvaluationType::SM_AlwaysTrue:
+		return true;
+	case ESMConditionalEvaluationType::SM_Graph:
+		return !CanEvaluateConditionally() || GraphEvaluator.CanEvaluateFastPath();
+	default:
+		return false;
+	}
+}
+
 bool FSMTransition::CanTransitionFromEvent()
 {
 	// An event would have signaled that it is evaluating and needs to be set to false now.
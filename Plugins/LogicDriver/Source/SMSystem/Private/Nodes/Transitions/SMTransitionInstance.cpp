@@ -6,7 +6,7 @@
 
 USMTransitionInstance::USMTransitionInstance() : Super(), PriorityOrder(0),
 bRunParallel(false), bEvalIfNextStateActive(true), bCanEvaluate(true), bCanEvaluateFromEvent(true),
-bCanEvalWithStartState(true)
+bCanEvalWithStartState(true), bEvaluateOnSignal(false)
 {
 }
 
@@ -2,12 +2,49 @@
 #include "SMBlueprintFunctions.h"
 #include "SMLogging.h"
 
+bool FSMExposedFunctionHandler::bFastPathEnabled = true;
+
+typedef TPair<TWeakObjectPtr<const UClass>, FName> FSMClassMemberKey;
+
+static TMap<FSMClassMemberKey, UFunction*>& GetCachedFunctions()
+{
+	static TMap<FSMClassMemberKey, UFunction*> Functions;
+	return Functions;
+}
+
+static TMap<FSMClassMemberKey, FProperty*>& GetCachedProperties()
+{
+	static TMap<FSMClassMemberKey, FProperty*> Properties;
+	return Properties;
+}
+
+template<typename T>
+static bool CompareFastPathValues(ESMExposedFunctionFastPath Operation, T A, T B)
+{
+	switch (Operation)
+	{
+	case ESMExposedFunctionFastPath::Equal:
+		return A == B;
+	case ESMExposedFunctionFastPath::NotEqual:
+		return A != B;
+	case ESMExposedFunctionFastPath::Less:
+		return A < B;
+	case ESMExposedFunctionFastPath::LessEqual:
+		return A <= B;
+	case ESMExposedFunctionFastPath::Greater:
+		return A > B;
+	case ESMExposedFunctionFastPath::GreaterEqual:
+		return A >= B;
+	default:
+		return false;
+	}
+}
 
 void FSMExposedFunctionHandler::Initialize(UObject* StateMachineObject)
 {
 	/* 
-	 * See FExposedValueHandler under AnimNodeBase. This handler is effectively the same thing, minus the fast path options. 
-	 * This will prepare the function setup at the entry point of this node.
+	 * See FExposedValueHandler under AnimNodeBase. This handler is effectively the same thing, with a simpler fast path that only supports
+	 * reading a property or comparing it against a constant. This will prepare the function setup at the entry point of this node.
 	 */
 
 	if (bInitialized || !StateMachineObject)
@@ -26,10 +63,21 @@ void FSMExposedFunctionHandler::Initialize(UObject* StateMachineObject)
 		{
 			// Only game thread is safe to call this on -- access shared map of the class.
 			check(IsInGameThread());
-			Function = StateMachineObject->FindFunction(BoundFunction);
+
+			// Every instance of a class binds the same functions.
+			UFunction*& CachedFunction = GetCachedFunctions().FindOrAdd(FSMClassMemberKey(StateMachineObject->GetClass(), BoundFunction));
+			if (CachedFunction == nullptr)
+			{
+				CachedFunction = StateMachineObject->FindFunction(BoundFunction);
+			}
+			
+			Function = CachedFunction;
 			check(Function);
 		}
 
+		ParmsSize = Function->ParmsSize;
+		InitializeFastPath(StateMachineObject->GetClass());
+		
 		bInitialized = true;
 	}
 	else
@@ -42,6 +90,7 @@ void FSMExposedFunctionHandler::Reset()
 {
 	bInitialized = false;
 	OwnerObject = nullptr;
+	FastPathProperty = nullptr;
 }
 
 void FSMExposedFunctionHandler::Execute(void* Parms) const
@@ -57,5 +106,100 @@ void FSMExposedFunctionHandler::Execute(void* Parms) const
 	}
 
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMBlueprintFunction::GraphEvaluation"), STAT_SMBlueprintFunctionHandler_Execute, STATGROUP_LogicDriver);
+
+	if (Parms == nullptr && ParmsSize > 0)
+	{
+		// Default parameters on the stack rather than letting the function read from null.
+		Parms = FMemory_Alloca(ParmsSize);
+		FMemory::Memzero(Parms, ParmsSize);
+	}
+	
 	OwnerObject->ProcessEvent(Function, Parms);
 }
+
+bool FSMExposedFunctionHandler::TryEvaluateFastPath(bool& bOutResult) const
+{
+	if (!FastPathProperty || !bFastPathEnabled || !bInitialized || !IsValid(OwnerObject))
+	{
+		return false;
+	}
+	
+	const void* Value = FastPathProperty->ContainerPtrToValuePtr<void>(OwnerObject);
+	if (const FBoolProperty* BoolProperty = CastField<FBoolProperty>(FastPathProperty))
+	{
+		const bool bValue = BoolProperty->GetPropertyValue(Value);
+		bOutResult = FastPath == ESMExposedFunctionFastPath::ReadBool ? bValue : CompareFastPathValues<bool>(FastPath, bValue, FastPathIntConstant != 0);
+		return true;
+	}
+
+	const FNumericProperty* NumericProperty = (const FNumericProperty*)FastPathProperty;
+	bOutResult = bFastPathFloatingPoint ? CompareFastPathValues<float>(FastPath, (float)NumericProperty->GetFloatingPointPropertyValue(Value), FastPathFloatConstant) :
+		CompareFastPathValues<int64>(FastPath, NumericProperty->GetSignedIntPropertyValue(Value), FastPathIntConstant);
+	
+	return true;
+}
+
+void FSMExposedFunctionHandler::ClearCache()
+{
+	GetCachedFunctions().Empty();
+	GetCachedProperties().Empty();
+}
+
+void FSMExposedFunctionHandler::InitializeFastPath(UClass* Class)
+{
+	FastPathProperty = nullptr;
+	
+	if (FastPath == ESMExposedFunctionFastPath::None || FastPathPropertyName == NAME_None)
+	{
+		return;
+	}
+
+	FProperty* Property = nullptr;
+	if (IsInGameThread())
+	{
+		FProperty*& CachedProperty = GetCachedProperties().FindOrAdd(FSMClassMemberKey(Class, FastPathPropertyName));
+		if (CachedProperty == nullptr)
+		{
+			CachedProperty = FindFProperty<FProperty>(Class, FastPathPropertyName);
+		}
+		Property = CachedProperty;
+	}
+	else
+	{
+		Property = FindFProperty<FProperty>(Class, FastPathPropertyName);
+	}
+
+	if (!Property || Property->ArrayDim != 1)
+	{
+		LD_LOG_WARNING(TEXT("Could not find property %s for fast path evaluation of function %s. The graph will be evaluated instead."), *FastPathPropertyName.ToString(), *BoundFunction.ToString());
+		return;
+	}
+
+	if (Property->IsA<FBoolProperty>())
+	{
+		if (FastPath == ESMExposedFunctionFastPath::ReadBool || FastPath == ESMExposedFunctionFastPath::Equal || FastPath == ESMExposedFunctionFastPath::NotEqual)
+		{
+			FastPathIntConstant = FastPathConstant.ToBool() ? 1 : 0;
+			FastPathProperty = Property;
+		}
+		return;
+	}
+
+	const FNumericProperty* NumericProperty = CastField<FNumericProperty>(Property);
+	if (!NumericProperty || NumericProperty->IsEnum() || FastPath == ESMExposedFunctionFastPath::ReadBool)
+	{
+		return;
+	}
+
+	bFastPathFloatingPoint = NumericProperty->IsFloatingPoint();
+	if (bFastPathFloatingPoint)
+	{
+		FastPathFloatConstant = (float)FCString::Atof(*FastPathConstant);
+	}
+	else
+	{
+		FastPathIntConstant = FCString::Atoi64(*FastPathConstant);
+	}
+	
+	FastPathProperty = Property;
+}
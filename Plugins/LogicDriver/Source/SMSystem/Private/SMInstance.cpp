@@ -6,6 +6,13 @@
 #include "SMLogging.h"
 #include "SMUtils.h"
 #include "SMStateMachineComponent.h"
+#include "SMUpdateScheduler.h"
+#include "SMInstanceClassLayout.h"
+#include "SMInstancePool.h"
+#include "SMInstanceSnapshot.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Algo/BinarySearch.h"
 
 #define LOCTEXT_NAMESPACE "SMInstance"
 
@@ -87,41 +94,52 @@ void USMInstance::Initialize(UObject* Context)
 {
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::Initialize"), STAT_SMInstance_Initialize, STATGROUP_LogicDriver);
 	
-	Shutdown();
+	// Tear down any previous initialization without returning to the pool, since this instance is about to be used.
+	ShutdownInternal();
 
 	// Context is what the instance will run under. This also sets the World the state machine operates in.
 	SetContext(Context);
 
-	// Locate the properties for this state machine. This could be either from a blueprint or native class.
-	TSet<FStructProperty*> Properties;
-	if (!USMUtils::TryGetStateMachinePropertiesForClass(GetClass(), Properties, RootStateMachineGuid))
+	// Instances of a class which has already been generated can be linked directly.
+	if (const FSMInstanceClassLayout* ClassLayout = FSMInstanceClassLayoutCache::Find(GetClass()))
 	{
-		return;
+		InitializeFromClassLayout(*ClassLayout);
 	}
-
-	// The RootGuid will have either been set by the compiler or when locating the parent class.
-	ensureAlways(RootStateMachineGuid.IsValid());
-	RootStateMachine.SetNodeGuid(RootStateMachineGuid);
-	RootStateMachine.SetNodeName("Root");
-	RootStateMachine.SetNodeInstanceClass(StateMachineClass);
-	
-	// Build the run-time state machine.
-	if (!USMUtils::GenerateStateMachine(this, RootStateMachine, Properties))
+	else
 	{
-		LD_LOG_ERROR(TEXT("Error generating state machine %s. Please try recompiling the blueprint."), *GetName());
-		return;
-	}
+		// Locate the properties for this state machine. This could be either from a blueprint or native class.
+		TSet<FStructProperty*> Properties;
+		if (!USMUtils::TryGetStateMachinePropertiesForClass(GetClass(), Properties, RootStateMachineGuid))
+		{
+			return;
+		}
 
-	// Initialize the graph function calls.
-	RootStateMachine.Initialize(this);
+		// The RootGuid will have either been set by the compiler or when locating the parent class.
+		ensureAlways(RootStateMachineGuid.IsValid());
+		RootStateMachine.SetNodeGuid(RootStateMachineGuid);
+		RootStateMachine.SetNodeName("Root");
+		RootStateMachine.SetNodeInstanceClass(StateMachineClass);
+		
+		// Build the run-time state machine.
+		if (!USMUtils::GenerateStateMachine(this, RootStateMachine, Properties))
+		{
+			LD_LOG_ERROR(TEXT("Error generating state machine %s. Please try recompiling the blueprint."), *GetName());
+			return;
+		}
+
+		// Initialize the graph function calls.
+		RootStateMachine.Initialize(this);
+
+		// Calculate path guids now that the instance is initialized and all node owners set.
+		TMap<FString, int32> Paths;
+		RootStateMachine.CalculatePathGuid(Paths);
 
-	// Calculate path guids now that the instance is initialized and all node owners set.
-	TMap<FString, int32> Paths;
-	RootStateMachine.CalculatePathGuid(Paths);
+		/* Build out a map of the state machine to use with node retrieval. */
+		TSet<USMInstance*> InstancesMapped;
+		BuildStateMachineMap(&RootStateMachine, InstancesMapped);
 
-	/* Build out a map of the state machine to use with node retrieval. */
-	TSet<USMInstance*> InstancesMapped;
-	BuildStateMachineMap(&RootStateMachine, InstancesMapped);
+		FSMInstanceClassLayoutCache::Record(this);
+	}
 	
 #if WITH_EDITORONLY_DATA
 	// Load debug object for this instance.
@@ -131,6 +149,9 @@ void USMInstance::Initialize(UObject* Context)
 		DebugStateMachine.UpdateRuntimeNode(KeyVal.Value);
 	}
 #endif
+
+	RebuildActiveStateTracking();
+	RebuildSignalBindings();
 	
 	bInitialized = true;
 
@@ -211,6 +232,8 @@ void USMInstance::Internal_Update(float DeltaSeconds)
 	OnStateMachineUpdate(DeltaSeconds);
 	OnStateMachineUpdatedEvent.Broadcast(this, DeltaSeconds);
 
+	CheckWatchedProperties();
+	
 	RootStateMachine.UpdateState(DeltaSeconds);
 
 	if (ServerStateMachine.GetObject() && ActiveTransactions.Num())
@@ -266,6 +289,8 @@ void USMInstance::Stop()
 	OnStateMachineStop();
 	OnStateMachineStoppedEvent.Broadcast(this);
 
+	UpdateSchedulerRegistration(false);
+
 	ReplicateStates();
 	R_bHasStarted = false;
 }
@@ -277,6 +302,26 @@ void USMInstance::Shutdown()
 		return;
 	}
 
+	ShutdownInternal();
+
+	// Recycle if pooled, unless this is being called from BeginDestroy.
+	if (USMInstancePool* Pool = OwningPool.Get())
+	{
+		if (!HasAnyFlags(RF_BeginDestroyed) && !IsPendingKillOrUnreachable())
+		{
+			OwningPool.Reset();
+			Pool->ReturnInstance(this);
+		}
+	}
+}
+
+void USMInstance::ShutdownInternal()
+{
+	if (!IsInitialized())
+	{
+		return;
+	}
+
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::Shutdown"), STAT_SMInstance_Shutdown, STATGROUP_LogicDriver);
 	
 	if (IsActive())
@@ -293,6 +338,17 @@ void USMInstance::Shutdown()
 	GuidNodeMap.Empty();
 	GuidStateMap.Empty();
 	GuidTransitionMap.Empty();
+	NetworkNodeGuids.Empty();
+	NetworkNodes.Empty();
+	NetworkNodeSignature = 0;
+
+	TrackedActiveStates.Empty();
+	ActiveStateOrder.Empty();
+	CachedActiveStates.Empty();
+	NumTemporaryEntryStateMachines = 0;
+	MarkActiveStatesChanged();
+
+	ClearSignalBindings();
 
 	bInitialized = false;
 }
@@ -309,9 +365,37 @@ void USMInstance::EvaluateTransitions()
 	
 	USMInstance* StateMachineInstance = GetMasterReferenceOwner();
 	check(StateMachineInstance);
+	StateMachineInstance->CheckWatchedProperties();
 	StateMachineInstance->GetRootStateMachine().ProcessStates(0.f, true);
 }
 
+bool USMInstance::SignalEvent(FName EventName)
+{
+	if (!CheckIsInitialized())
+	{
+		return false;
+	}
+	
+	const TArray<FSMTransition*>* Transitions = SignalEventTransitions.Find(EventName);
+	if (!Transitions)
+	{
+		return false;
+	}
+
+	bool bSignaled = false;
+	for (FSMTransition* Transition : *Transitions)
+	{
+		// Only active states receive events. Transitions always evaluate once when their state starts.
+		if (Transition->GetFromState()->IsActive())
+		{
+			Transition->Signal();
+			bSignaled = true;
+		}
+	}
+
+	return bSignaled;
+}
+
 void USMInstance::LoadFromState(const FGuid& FromGuid, bool bAllParents)
 {
 	if (!FromGuid.IsValid())
@@ -347,6 +431,29 @@ void USMInstance::LoadFromMultipleStates(const TArray<FGuid>& FromGuids)
 	}
 }
 
+bool USMInstance::SaveSnapshot(TArray<uint8>& OutData)
+{
+	if (!CheckIsInitialized())
+	{
+		return false;
+	}
+	
+	OutData.Reset();
+	FMemoryWriter Writer(OutData);
+	return FSMInstanceSnapshot::Save(this, Writer);
+}
+
+bool USMInstance::LoadSnapshot(const TArray<uint8>& Data, bool bRunStateBegin)
+{
+	if (!CheckIsInitialized())
+	{
+		return false;
+	}
+	
+	FMemoryReader Reader(Data);
+	return FSMInstanceSnapshot::Load(this, Reader, bRunStateBegin);
+}
+
 FString USMInstance::GetActiveStateName() const
 {
 	if (FSMState_Base* CurrentState = GetSingleActiveState())
@@ -449,18 +556,49 @@ FGuid USMInstance::GetSingleActiveStateGuid(bool bCheckNested) const
 
 TArray<FSMState_Base*> USMInstance::GetAllActiveStates() const
 {
-	return RootStateMachine.GetAllNestedActiveStates();
+	// A state machine without active states reports its temporary entry states instead.
+	if (!bInitialized || NumTemporaryEntryStateMachines > 0)
+	{
+		return RootStateMachine.GetAllNestedActiveStates();
+	}
+	
+	if (bActiveStatesDirty)
+	{
+		// The set has no order, so sort by hierarchy to list parents before their children the same way every time.
+		CachedActiveStates = TrackedActiveStates.Array();
+		CachedActiveStates.Sort([this](const FSMState_Base& lhs, const FSMState_Base& rhs)
+		{
+			return ActiveStateOrder.FindRef(const_cast<FSMState_Base*>(&lhs)) < ActiveStateOrder.FindRef(const_cast<FSMState_Base*>(&rhs));
+		});
+		bActiveStatesDirty = false;
+	}
+	
+	return CachedActiveStates;
 }
 
 void USMInstance::GetAllActiveStateGuids(TArray<FGuid>& ActiveGuids) const
 {
-	ActiveGuids.Reset();
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::GetAllActiveStateGuids"), STAT_SMInstance_GetAllActiveStateGuids, STATGROUP_LogicDriver);
 	
-	TArray<FSMState_Base*> CurrentStates = GetAllActiveStates();
-	for (FSMState_Base* State : CurrentStates)
+	if (bActiveStateGuidsDirty || !bInitialized)
 	{
-		ActiveGuids.AddUnique(State->GetGuid());
+		CachedActiveStateGuids.Reset();
+
+		TSet<FGuid> UniqueGuids;
+		for (FSMState_Base* State : GetAllActiveStates())
+		{
+			bool bAlreadyAdded = false;
+			UniqueGuids.Add(State->GetGuid(), &bAlreadyAdded);
+			if (!bAlreadyAdded)
+			{
+				CachedActiveStateGuids.Add(State->GetGuid());
+			}
+		}
+		
+		bActiveStateGuidsDirty = !bInitialized;
 	}
+
+	ActiveGuids = CachedActiveStateGuids;
 }
 
 TArray<FGuid> USMInstance::GetAllActiveStateGuidsCopy() const
@@ -880,6 +1018,266 @@ void USMInstance::GetAllTransitionInstances(TArray<USMTransitionInstance*>& Tran
 	}
 }
 
+void USMInstance::NotifyActiveStateChanged(FSMState_Base* State, bool bIsActive)
+{
+	if (bIsActive)
+	{
+		TrackedActiveStates.Add(State);
+	}
+	else
+	{
+		TrackedActiveStates.Remove(State);
+	}
+
+	MarkActiveStatesChanged();
+
+	// The owner reports the active states of its references.
+	if (ReferenceOwner)
+	{
+		ReferenceOwner->NotifyActiveStateChanged(State, bIsActive);
+	}
+}
+
+void USMInstance::NotifyTemporaryEntryStatesChanged(int32 StateMachineDelta)
+{
+	NumTemporaryEntryStateMachines = FMath::Max(0, NumTemporaryEntryStateMachines + StateMachineDelta);
+	MarkActiveStatesChanged();
+
+	if (ReferenceOwner)
+	{
+		ReferenceOwner->NotifyTemporaryEntryStatesChanged(StateMachineDelta);
+	}
+}
+
+void USMInstance::RebuildActiveStateTracking()
+{
+	TrackedActiveStates.Reset();
+	NumTemporaryEntryStateMachines = 0;
+
+	ActiveStateOrder.Reset();
+	{
+		int32 NextIndex = 0;
+		TSet<USMInstance*> InstancesOrdered;
+		BuildActiveStateOrder(RootStateMachine, NextIndex, InstancesOrdered);
+	}
+
+	// Visit every state machine the same way GetAllNestedActiveStates does, including references.
+	TSet<USMInstance*> InstancesVisited;
+	TArray<FSMStateMachine*> StateMachines;
+	StateMachines.Add(&RootStateMachine);
+	while (StateMachines.Num() > 0)
+	{
+		FSMStateMachine* StateMachine = StateMachines.Pop(false);
+		if (USMInstance* ReferencedInstance = StateMachine->GetInstanceReference())
+		{
+			bool bAlreadyVisited = false;
+			InstancesVisited.Add(ReferencedInstance, &bAlreadyVisited);
+			if (!bAlreadyVisited)
+			{
+				StateMachines.Add(&ReferencedInstance->GetRootStateMachine());
+			}
+			continue;
+		}
+
+		if (StateMachine->HasActiveStates())
+		{
+			TrackedActiveStates.Append(StateMachine->GetActiveStates());
+		}
+		
+		if (StateMachine->HasTemporaryEntryStates())
+		{
+			NumTemporaryEntryStateMachines++;
+		}
+
+		for (FSMState_Base* State : StateMachine->GetStates())
+		{
+			if (State->IsStateMachine())
+			{
+				StateMachines.Add((FSMStateMachine*)State);
+			}
+		}
+	}
+
+	MarkActiveStatesChanged();
+}
+
+void USMInstance::BuildActiveStateOrder(const FSMStateMachine& StateMachine, int32& NextIndex, TSet<USMInstance*>& InstancesVisited)
+{
+	if (USMInstance* ReferencedInstance = StateMachine.GetInstanceReference())
+	{
+		bool bAlreadyVisited = false;
+		InstancesVisited.Add(ReferencedInstance, &bAlreadyVisited);
+		if (!bAlreadyVisited)
+		{
+			BuildActiveStateOrder(ReferencedInstance->GetRootStateMachine(), NextIndex, InstancesVisited);
+		}
+		return;
+	}
+
+	for (FSMState_Base* State : StateMachine.GetStates())
+	{
+		ActiveStateOrder.Add(State, NextIndex++);
+	}
+
+	for (FSMState_Base* State : StateMachine.GetStates())
+	{
+		if (State->IsStateMachine())
+		{
+			BuildActiveStateOrder(*(FSMStateMachine*)State, NextIndex, InstancesVisited);
+		}
+	}
+}
+
+void USMInstance::MarkActiveStatesChanged()
+{
+	bActiveStatesDirty = true;
+	bActiveStateGuidsDirty = true;
+	ActiveStatesVersion++;
+}
+
+void USMInstance::RebuildSignalBindings()
+{
+	ClearSignalBindings();
+
+	for (const auto& KeyVal : GuidTransitionMap)
+	{
+		FSMTransition* Transition = KeyVal.Value;
+		if (!Transition->bEvaluateOnSignal)
+		{
+			continue;
+		}
+
+		for (const FName& EventName : Transition->SignalEvents)
+		{
+			SignalEventTransitions.FindOrAdd(EventName).AddUnique(Transition);
+		}
+
+		// Variables are read from the instance which owns the transition graph.
+		UObject* Owner = Transition->GetOwningInstance();
+		if (!Owner)
+		{
+			continue;
+		}
+		
+		for (const FName& PropertyName : Transition->SignalProperties)
+		{
+			FSMWatchedProperty* WatchedProperty = WatchedProperties.FindByPredicate([&](const FSMWatchedProperty& Other)
+			{
+				return Other.Owner == Owner && Other.Property->GetFName() == PropertyName;
+			});
+
+			if (!WatchedProperty)
+			{
+				FProperty* Property = FindFProperty<FProperty>(Owner->GetClass(), PropertyName);
+				if (!Property || Property->ArrayDim != 1)
+				{
+					LD_LOG_WARNING(TEXT("Transition '%s' in state machine '%s' can't watch variable '%s'. It must be a member variable of the state machine."),
+						*Transition->GetNodeName(), *Owner->GetName(), *PropertyName.ToString());
+					continue;
+				}
+				
+				WatchedProperty = &WatchedProperties.AddDefaulted_GetRef();
+				WatchedProperty->Owner = Owner;
+				WatchedProperty->Property = Property;
+				WatchedProperty->Value.SetNumZeroed(Property->GetSize());
+				Property->InitializeValue(WatchedProperty->Value.GetData());
+				Property->CopyCompleteValue(WatchedProperty->Value.GetData(), Property->ContainerPtrToValuePtr<void>(Owner));
+			}
+
+			WatchedProperty->Transitions.AddUnique(Transition);
+		}
+	}
+}
+
+void USMInstance::ClearSignalBindings()
+{
+	for (FSMWatchedProperty& WatchedProperty : WatchedProperties)
+	{
+		WatchedProperty.Property->DestroyValue(WatchedProperty.Value.GetData());
+	}
+	
+	WatchedProperties.Empty();
+	SignalEventTransitions.Empty();
+}
+
+void USMInstance::CheckWatchedProperties()
+{
+	if (WatchedProperties.Num() == 0)
+	{
+		return;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::CheckWatchedProperties"), STAT_SMInstance_CheckWatchedProperties, STATGROUP_LogicDriver);
+	
+	for (FSMWatchedProperty& WatchedProperty : WatchedProperties)
+	{
+		const void* CurrentValue = WatchedProperty.Property->ContainerPtrToValuePtr<void>(WatchedProperty.Owner);
+		if (!WatchedProperty.Property->Identical(WatchedProperty.Value.GetData(), CurrentValue))
+		{
+			WatchedProperty.Property->CopyCompleteValue(WatchedProperty.Value.GetData(), CurrentValue);
+			for (FSMTransition* Transition : WatchedProperty.Transitions)
+			{
+				Transition->Signal();
+			}
+		}
+	}
+}
+
+int32 USMInstance::GetNetworkNodeIndex(const FGuid& PathGuid)
+{
+	if (NetworkNodeGuids.Num() != GuidNodeMap.Num())
+	{
+		BuildNetworkNodeIndices();
+	}
+
+	return Algo::BinarySearch(NetworkNodeGuids, PathGuid);
+}
+
+const FGuid* USMInstance::GetNetworkNodeGuid(int32 Index)
+{
+	if (NetworkNodeGuids.Num() != GuidNodeMap.Num())
+	{
+		BuildNetworkNodeIndices();
+	}
+
+	return NetworkNodeGuids.IsValidIndex(Index) ? &NetworkNodeGuids[Index] : nullptr;
+}
+
+FSMNode_Base* USMInstance::GetNetworkNode(int32 Index)
+{
+	if (NetworkNodeGuids.Num() != GuidNodeMap.Num())
+	{
+		BuildNetworkNodeIndices();
+	}
+
+	return NetworkNodes.IsValidIndex(Index) ? NetworkNodes[Index] : nullptr;
+}
+
+uint32 USMInstance::GetNetworkNodeSignature()
+{
+	if (NetworkNodeGuids.Num() != GuidNodeMap.Num())
+	{
+		BuildNetworkNodeIndices();
+	}
+
+	return NetworkNodeSignature;
+}
+
+void USMInstance::BuildNetworkNodeIndices()
+{
+	// Path guids are deterministic per class so sorting them gives the same order on server and clients.
+	GuidNodeMap.GenerateKeyArray(NetworkNodeGuids);
+	NetworkNodeGuids.Sort();
+
+	NetworkNodes.Reset(NetworkNodeGuids.Num());
+	for (const FGuid& PathGuid : NetworkNodeGuids)
+	{
+		NetworkNodes.Add(GuidNodeMap.FindChecked(PathGuid));
+	}
+
+	NetworkNodeSignature = FCrc::MemCrc32(NetworkNodeGuids.GetData(), NetworkNodeGuids.Num() * sizeof(FGuid));
+}
+
 void USMInstance::SetServerInstance(TScriptInterface<ISMStateMachineNetworkedInterface> Server)
 {
 	ServerStateMachine = Server;
@@ -897,6 +1295,36 @@ void USMInstance::SetAllowStateLogic(bool bAllow)
 	bCanExecuteStateLogic = bAllow;
 }
 
+void USMInstance::PreEvaluateTransitions(float DeltaSeconds)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::PreEvaluateTransitions"), STAT_SMInstance_PreEvaluateTransitions, STATGROUP_LogicDriver);
+
+	if (!IsInitialized() || !CanEverTick() || !RootStateMachine.IsActive())
+	{
+		return;
+	}
+
+	// Results are only used by the update this frame, don't evaluate if the tick interval won't allow one.
+	if (TimeSinceAllowedTick + DeltaSeconds < TickInterval)
+	{
+		return;
+	}
+
+	// The update will stop the instance instead.
+	if (bStopOnEndState && RootStateMachine.IsInEndState())
+	{
+		return;
+	}
+
+	// Transitions of networked clients are decided by the server.
+	if (!bCanEvaluateTransitionsLocally)
+	{
+		return;
+	}
+	
+	RootStateMachine.PreEvaluateTransitions();
+}
+
 void USMInstance::Tick_Implementation(float DeltaTime)
 {
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::TotalTick"), STAT_SMInstance_TotalTick, STATGROUP_LogicDriver);
@@ -953,6 +1381,68 @@ void USMInstance::OnStateMachineStateChanged_Implementation(const FSMStateInfo&
 {
 }
 
+void USMInstance::InitializeFromClassLayout(const FSMInstanceClassLayout& ClassLayout)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::InitializeFromClassLayout"), STAT_SMInstance_InitializeFromClassLayout, STATGROUP_LogicDriver);
+	
+	uint8* InstanceData = (uint8*)this;
+	
+	RootStateMachineGuid = ClassLayout.RootGuid;
+	RootStateMachine.SetNodeGuid(RootStateMachineGuid);
+	RootStateMachine.SetNodeName("Root");
+	RootStateMachine.SetNodeInstanceClass(StateMachineClass);
+
+	// Link the same way GenerateStateMachine would.
+	for (const FSMInstanceClassLayout::FStateMachineLayout& StateMachineLayout : ClassLayout.StateMachines)
+	{
+		FSMStateMachine* StateMachine = (FSMStateMachine*)(InstanceData + StateMachineLayout.Offset);
+		for (const int32 StateOffset : StateMachineLayout.StateOffsets)
+		{
+			StateMachine->AddState((FSMState_Base*)(InstanceData + StateOffset));
+		}
+
+		for (const int32 StateOffset : StateMachineLayout.EntryStateOffsets)
+		{
+			StateMachine->AddInitialState((FSMState_Base*)(InstanceData + StateOffset));
+		}
+
+		for (const FSMInstanceClassLayout::FTransitionLayout& TransitionLayout : StateMachineLayout.Transitions)
+		{
+			FSMTransition* Transition = (FSMTransition*)(InstanceData + TransitionLayout.Offset);
+			Transition->SetFromState((FSMState_Base*)(InstanceData + TransitionLayout.FromStateOffset));
+			Transition->SetToState((FSMState_Base*)(InstanceData + TransitionLayout.ToStateOffset));
+			StateMachine->AddTransition(Transition);
+		}
+	}
+
+	// Initialize the graph function calls.
+	RootStateMachine.Initialize(this);
+
+	// Path guids are already known, map the nodes directly.
+	GuidNodeMap.Reserve(ClassLayout.Nodes.Num());
+	for (const FSMInstanceClassLayout::FNodeLayout& NodeLayout : ClassLayout.Nodes)
+	{
+		if (NodeLayout.Type == FSMInstanceClassLayout::ENodeType::Transition)
+		{
+			FSMTransition* Transition = (FSMTransition*)(InstanceData + NodeLayout.Offset);
+			Transition->SetPathGuid(NodeLayout.PathGuid);
+			GuidNodeMap.Add(NodeLayout.PathGuid, Transition);
+			GuidTransitionMap.Add(NodeLayout.PathGuid, Transition);
+			continue;
+		}
+
+		FSMState_Base* State = (FSMState_Base*)(InstanceData + NodeLayout.Offset);
+		State->SetPathGuid(NodeLayout.PathGuid);
+		GuidNodeMap.Add(NodeLayout.PathGuid, State);
+		GuidStateMap.Add(NodeLayout.PathGuid, State);
+		
+		if (NodeLayout.Type == FSMInstanceClassLayout::ENodeType::StateMachine)
+		{
+			StateMachineGuids.Add(NodeLayout.PathGuid);
+		}
+	}
+}
+
 void USMInstance::BuildStateMachineMap(FSMStateMachine* StateMachine, TSet<USMInstance*>& InstancesMapped)
 {
 	InstancesMapped.Add(this);
@@ -1053,9 +1543,10 @@ void USMInstance::UpdateTime()
 
 void USMInstance::ReplicateStates()
 {
-	if (ServerStateMachine.GetObject() && ServerStateMachine->ShouldReplicateStates())
+	if (ReplicatedActiveStatesVersion != ActiveStatesVersion && ServerStateMachine.GetObject() && ServerStateMachine->ShouldReplicateStates())
 	{
 		GetAllActiveStateGuids(R_ActiveStates);
+		ReplicatedActiveStatesVersion = ActiveStatesVersion;
 	}
 }
 
@@ -1074,9 +1565,35 @@ void USMInstance::DoStart()
 	RootStateMachine.StartState();
 	UpdateTime();
 
+	UpdateSchedulerRegistration(true);
+
 	ReplicateStates();
 }
 
+void USMInstance::UpdateSchedulerRegistration(bool bRegister)
+{
+	if (!bEvaluateTransitionsInParallel)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	USMUpdateScheduler* Scheduler = World ? World->GetSubsystem<USMUpdateScheduler>() : nullptr;
+	if (!Scheduler)
+	{
+		return;
+	}
+
+	if (bRegister)
+	{
+		Scheduler->RegisterInstance(this);
+	}
+	else
+	{
+		Scheduler->UnregisterInstance(this);
+	}
+}
+
 void USMInstance::REP_StartChanged()
 {
 	if (IsInitialized())
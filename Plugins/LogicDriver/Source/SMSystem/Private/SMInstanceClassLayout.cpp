@@ -0,0 +1,122 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#include "SMInstanceClassLayout.h"
+#include "SMInstance.h"
+
+bool FSMInstanceClassLayoutCache::bEnabled = true;
+
+TMap<TWeakObjectPtr<const UClass>, FSMInstanceClassLayout>& FSMInstanceClassLayoutCache::GetLayouts()
+{
+	static TMap<TWeakObjectPtr<const UClass>, FSMInstanceClassLayout> Layouts;
+	return Layouts;
+}
+
+const FSMInstanceClassLayout* FSMInstanceClassLayoutCache::Find(const UClass* Class)
+{
+	if (!bEnabled || !IsInGameThread())
+	{
+		return nullptr;
+	}
+
+	const FSMInstanceClassLayout* Layout = GetLayouts().Find(Class);
+	if (Layout && (Layout->PropertyLink != Class->PropertyLink || Layout->PropertiesSize != Class->GetPropertiesSize()))
+	{
+		GetLayouts().Remove(Class);
+		return nullptr;
+	}
+
+	return Layout;
+}
+
+void FSMInstanceClassLayoutCache::Record(USMInstance* Instance)
+{
+	if (!bEnabled || !IsInGameThread())
+	{
+		return;
+	}
+
+	const UClass* Class = Instance->GetClass();
+	const uint8* InstanceData = (const uint8*)Instance;
+
+	FSMInstanceClassLayout Layout;
+	Layout.RootGuid = Instance->RootStateMachineGuid;
+	Layout.PropertyLink = Class->PropertyLink;
+	Layout.PropertiesSize = Class->GetPropertiesSize();
+
+	bool bIsValid = true;
+	auto GetOffset = [&](const void* Node)
+	{
+		const int32 Offset = (int32)((const uint8*)Node - InstanceData);
+		if (Offset < 0 || Offset >= Layout.PropertiesSize)
+		{
+			bIsValid = false;
+		}
+		return Offset;
+	};
+
+	TArray<FSMStateMachine*> StateMachines;
+	StateMachines.Add(&Instance->GetRootStateMachine());
+	for (int32 Idx = 0; Idx < StateMachines.Num(); ++Idx)
+	{
+		FSMStateMachine* StateMachine = StateMachines[Idx];
+
+		// References are instantiated per instance.
+		if (StateMachine->GetClassReference() || StateMachine->GetInstanceReference())
+		{
+			return;
+		}
+
+		FSMInstanceClassLayout::FStateMachineLayout& StateMachineLayout = Layout.StateMachines.AddDefaulted_GetRef();
+		StateMachineLayout.Offset = GetOffset(StateMachine);
+		
+		for (FSMState_Base* State : StateMachine->GetStates())
+		{
+			StateMachineLayout.StateOffsets.Add(GetOffset(State));
+			if (State->IsStateMachine())
+			{
+				StateMachines.Add((FSMStateMachine*)State);
+			}
+		}
+
+		for (FSMState_Base* State : StateMachine->GetEntryStates())
+		{
+			StateMachineLayout.EntryStateOffsets.Add(GetOffset(State));
+		}
+
+		// Order is kept so outgoing transitions are added to states in the same order.
+		for (FSMTransition* Transition : StateMachine->GetTransitions())
+		{
+			StateMachineLayout.Transitions.Add({ GetOffset(Transition), GetOffset(Transition->GetFromState()), GetOffset(Transition->GetToState()) });
+		}
+	}
+
+	const TMap<FGuid, FSMState_Base*>& StateMap = Instance->GetStateMap();
+	Layout.Nodes.Reserve(Instance->GetNodeMap().Num());
+	for (const auto& KeyVal : Instance->GetNodeMap())
+	{
+		FSMInstanceClassLayout::ENodeType NodeType = FSMInstanceClassLayout::ENodeType::Transition;
+		if (FSMState_Base* const* State = StateMap.Find(KeyVal.Key))
+		{
+			NodeType = (*State)->IsStateMachine() ? FSMInstanceClassLayout::ENodeType::StateMachine : FSMInstanceClassLayout::ENodeType::State;
+		}
+		Layout.Nodes.Add({ KeyVal.Key, GetOffset(KeyVal.Value), NodeType });
+	}
+
+	if (bIsValid)
+	{
+		GetLayouts().Add(Class, MoveTemp(Layout));
+	}
+}
+
+void FSMInstanceClassLayoutCache::Clear()
+{
+	GetLayouts().Empty();
+}
+
+void FSMInstanceClassLayoutCache::SetEnabled(bool bValue)
+{
+	bEnabled = bValue;
+	if (!bEnabled)
+	{
+		Clear();
+	}
+}
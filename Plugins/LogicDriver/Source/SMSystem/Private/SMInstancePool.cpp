@@ -0,0 +1,106 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#include "SMInstancePool.h"
+#include "SMInstance.h"
+#include "SMUtils.h"
+#include "SMLogging.h"
+
+/** Copy blueprint variables from the class default object so a reused instance matches a newly created one. */
+static void ResetBlueprintVariables(USMInstance* Instance)
+{
+	const UObject* DefaultObject = Instance->GetClass()->GetDefaultObject();
+	for (TFieldIterator<FProperty> It(Instance->GetClass()); It; ++It)
+	{
+		FProperty* Property = *It;
+
+		// Compiler generated node properties aren't blueprint visible. Instanced objects would need to be duplicated instead.
+		if (!Property->HasAnyPropertyFlags(CPF_BlueprintVisible) || Property->HasAnyPropertyFlags(CPF_InstancedReference | CPF_ContainsInstancedReference) ||
+			Property->GetOwnerClass()->HasAnyClassFlags(CLASS_Native))
+		{
+			continue;
+		}
+
+		Property->CopyCompleteValue_InContainer(Instance, DefaultObject);
+	}
+}
+
+USMInstancePool::USMInstancePool() : MaxInstancesPerClass(64)
+{
+}
+
+void USMInstancePool::Deinitialize()
+{
+	EmptyPool();
+	Super::Deinitialize();
+}
+
+USMInstance* USMInstancePool::AcquireInstance(TSubclassOf<USMInstance> StateMachineClass, UObject* Context)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstancePool::AcquireInstance"), STAT_SMInstancePool_AcquireInstance, STATGROUP_LogicDriver);
+	
+	USMInstance* Instance = nullptr;
+	if (FSMPooledInstances* Pooled = PooledInstances.Find(StateMachineClass.Get()))
+	{
+		while (!Instance && Pooled->Instances.Num() > 0)
+		{
+			Instance = Pooled->Instances.Pop(false);
+			if (Instance && Instance->IsPendingKillOrUnreachable())
+			{
+				Instance = nullptr;
+			}
+		}
+	}
+
+	if (Instance)
+	{
+		// Move under the new context so it is outered the same as a newly created instance.
+		if (Context && Instance->GetOuter() != Context)
+		{
+			Instance->Rename(*MakeUniqueObjectName(Context, Instance->GetClass()).ToString(), Context, REN_DontCreateRedirectors | REN_ForceNoResetLoaders | REN_DoNotDirty | REN_NonTransactional);
+		}
+		Instance->Initialize(Context);
+	}
+	else
+	{
+		Instance = USMBlueprintUtils::CreateStateMachineInstance(StateMachineClass, Context);
+	}
+
+	if (Instance)
+	{
+		Instance->SetOwningPool(this);
+	}
+	
+	return Instance;
+}
+
+void USMInstancePool::ReturnInstance(USMInstance* Instance)
+{
+	if (!Instance || Instance->IsInitialized())
+	{
+		LD_LOG_WARNING(TEXT("Only shutdown state machine instances can be returned to the pool."));
+		return;
+	}
+
+	FSMPooledInstances& Pooled = PooledInstances.FindOrAdd(Instance->GetClass());
+	if (Pooled.Instances.Num() >= MaxInstancesPerClass)
+	{
+		return;
+	}
+
+	// Release the context so it isn't kept alive by the pool.
+	Instance->SetContext(nullptr);
+	ResetBlueprintVariables(Instance);
+	Instance->Rename(*MakeUniqueObjectName(this, Instance->GetClass()).ToString(), this, REN_DontCreateRedirectors | REN_ForceNoResetLoaders | REN_DoNotDirty | REN_NonTransactional);
+	
+	Pooled.Instances.Add(Instance);
+}
+
+int32 USMInstancePool::GetNumPooledInstances(TSubclassOf<USMInstance> StateMachineClass) const
+{
+	const FSMPooledInstances* Pooled = PooledInstances.Find(StateMachineClass.Get());
+	return Pooled ? Pooled->Instances.Num() : 0;
+}
+
+void USMInstancePool::EmptyPool()
+{
+	PooledInstances.Empty();
+}
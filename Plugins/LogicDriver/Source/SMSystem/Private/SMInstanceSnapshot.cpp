@@ -0,0 +1,340 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#include "SMInstanceSnapshot.h"
+#include "SMInstance.h"
+#include "SMLogging.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("SMInstanceSnapshot Instances Saved"), STAT_SMInstanceSnapshot_InstancesSaved, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SMInstanceSnapshot Instances Loaded"), STAT_SMInstanceSnapshot_InstancesLoaded, STATGROUP_LogicDriver);
+
+struct FSMSnapshotActiveState
+{
+	FSMState_Base* State;
+	float TimeInState;
+};
+
+static TMap<TWeakObjectPtr<const UClass>, TPair<const FProperty*, bool>>& GetCachedClasses()
+{
+	static TMap<TWeakObjectPtr<const UClass>, TPair<const FProperty*, bool>> Classes;
+	return Classes;
+}
+
+/** If a record of DataSize bytes starting at the current position fits in the archive. */
+static bool IsRecordInBounds(FArchive& Ar, int32 DataSize)
+{
+	const int64 TotalSize = Ar.TotalSize();
+	return DataSize >= 0 && (TotalSize < 0 || Ar.Tell() + DataSize <= TotalSize);
+}
+
+bool FSMInstanceSnapshot::Save(USMInstance* Instance, FArchive& Ar)
+{
+	check(Ar.IsSaving());
+
+	if (!Instance || !Instance->IsInitialized())
+	{
+		return false;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstanceSnapshot::Save"), STAT_SMInstanceSnapshot_Save, STATGROUP_LogicDriver);
+	INC_DWORD_STAT(STAT_SMInstanceSnapshot_InstancesSaved);
+
+	uint8 Version = Latest;
+	Ar << Version;
+
+	uint32 Signature = Instance->GetNetworkNodeSignature();
+	Ar << Signature;
+
+	// Active states, temporary entry states are reported while the instance isn't running.
+	TArray<FSMState_Base*> ActiveStates;
+	if (Instance->IsActive())
+	{
+		ActiveStates = Instance->GetAllActiveStates();
+	}
+
+	uint32 NumActiveStates = ActiveStates.Num();
+	Ar.SerializeIntPacked(NumActiveStates);
+	for (FSMState_Base* State : ActiveStates)
+	{
+		uint32 NodeIndex = (uint32)Instance->GetNetworkNodeIndex(State->GetGuid());
+		Ar.SerializeIntPacked(NodeIndex);
+
+		float TimeInState = State->GetActiveTime();
+		Ar << TimeInState;
+	}
+
+	// Node instance variables which have opted in with SaveGame.
+	const int32 NumNodes = Instance->GetNodeMap().Num();
+	TArray<int32, TInlineAllocator<16>> SavedNodeIndices;
+	for (int32 NodeIndex = 0; NodeIndex < NumNodes; ++NodeIndex)
+	{
+		FSMNode_Base* Node = Instance->GetNetworkNode(NodeIndex);
+		USMNodeInstance* NodeInstance = Node ? Node->GetNodeInstance() : nullptr;
+		if (NodeInstance && HasSaveGameProperties(NodeInstance->GetClass()))
+		{
+			SavedNodeIndices.Add(NodeIndex);
+		}
+	}
+
+	uint32 NumSavedNodes = SavedNodeIndices.Num();
+	Ar.SerializeIntPacked(NumSavedNodes);
+
+	FObjectAndNameAsStringProxyArchive PropertyAr(Ar, false);
+	PropertyAr.ArIsSaveGame = true;
+	for (const int32 NodeIndex : SavedNodeIndices)
+	{
+		uint32 PackedIndex = (uint32)NodeIndex;
+		Ar.SerializeIntPacked(PackedIndex);
+
+		// Record the size so data of a changed node class can be skipped.
+		const int64 SizePosition = Ar.Tell();
+		int32 DataSize = 0;
+		Ar << DataSize;
+
+		USMNodeInstance* NodeInstance = Instance->GetNetworkNode(NodeIndex)->GetNodeInstance();
+		NodeInstance->GetClass()->SerializeBin(PropertyAr, NodeInstance);
+
+		const int64 EndPosition = Ar.Tell();
+		DataSize = (int32)(EndPosition - SizePosition - sizeof(int32));
+		Ar.Seek(SizePosition);
+		Ar << DataSize;
+		Ar.Seek(EndPosition);
+	}
+
+	return !Ar.IsError();
+}
+
+bool FSMInstanceSnapshot::Load(USMInstance* Instance, FArchive& Ar, bool bRunStateBegin)
+{
+	check(Ar.IsLoading());
+
+	if (!Instance || !Instance->IsInitialized())
+	{
+		return false;
+	}
+
+	if (Instance->IsActive())
+	{
+		LD_LOG_WARNING(TEXT("Attempted to load a snapshot into State Machine Instance %s when it was already running."), *Instance->GetName());
+		return false;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstanceSnapshot::Load"), STAT_SMInstanceSnapshot_Load, STATGROUP_LogicDriver);
+
+	uint8 Version = 0;
+	Ar << Version;
+	if (Version == 0 || Version > Latest)
+	{
+		LD_LOG_ERROR(TEXT("Snapshot for State Machine Instance %s has unsupported version %d."), *Instance->GetName(), Version);
+		return false;
+	}
+
+	uint32 Signature = 0;
+	Ar << Signature;
+	if (Signature != Instance->GetNetworkNodeSignature())
+	{
+		LD_LOG_ERROR(TEXT("Snapshot for State Machine Instance %s was saved from a different state machine class or version."), *Instance->GetName());
+		return false;
+	}
+
+	uint32 NumActiveStates = 0;
+	Ar.SerializeIntPacked(NumActiveStates);
+
+	TArray<FSMSnapshotActiveState, TInlineAllocator<16>> ActiveStates;
+	for (uint32 Idx = 0; Idx < NumActiveStates && !Ar.IsError(); ++Idx)
+	{
+		uint32 NodeIndex = 0;
+		Ar.SerializeIntPacked(NodeIndex);
+
+		float TimeInState = 0.f;
+		Ar << TimeInState;
+
+		FSMNode_Base* Node = Instance->GetNetworkNode((int32)NodeIndex);
+		FSMState_Base* State = Node ? Instance->GetStateByGuid(Node->GetGuid()) : nullptr;
+		if (State != Node)
+		{
+			LD_LOG_ERROR(TEXT("Snapshot for State Machine Instance %s contains an invalid state index %d."), *Instance->GetName(), NodeIndex);
+			return false;
+		}
+
+		ActiveStates.Add({ State, TimeInState });
+	}
+
+	uint32 NumSavedNodes = 0;
+	Ar.SerializeIntPacked(NumSavedNodes);
+
+	// Node instance variables are restored first so begin logic can use them.
+	FObjectAndNameAsStringProxyArchive PropertyAr(Ar, true);
+	PropertyAr.ArIsSaveGame = true;
+	for (uint32 Idx = 0; Idx < NumSavedNodes && !Ar.IsError(); ++Idx)
+	{
+		uint32 NodeIndex = 0;
+		Ar.SerializeIntPacked(NodeIndex);
+
+		int32 DataSize = 0;
+		Ar << DataSize;
+		if (Ar.IsError() || !IsRecordInBounds(Ar, DataSize))
+		{
+			LD_LOG_ERROR(TEXT("Snapshot for State Machine Instance %s is corrupt."), *Instance->GetName());
+			return false;
+		}
+		const int64 EndPosition = Ar.Tell() + DataSize;
+
+		FSMNode_Base* Node = Instance->GetNetworkNode((int32)NodeIndex);
+		USMNodeInstance* NodeInstance = Node ? Node->GetNodeInstance() : nullptr;
+		if (NodeInstance && HasSaveGameProperties(NodeInstance->GetClass()))
+		{
+			NodeInstance->GetClass()->SerializeBin(PropertyAr, NodeInstance);
+		}
+
+		if (Ar.Tell() != EndPosition)
+		{
+			LD_LOG_WARNING(TEXT("Snapshot variables of node index %d in State Machine Instance %s don't match the node class and may not be restored correctly."),
+				NodeIndex, *Instance->GetName());
+			Ar.Seek(EndPosition);
+		}
+	}
+
+	if (Ar.IsError())
+	{
+		LD_LOG_ERROR(TEXT("Snapshot for State Machine Instance %s is corrupt."), *Instance->GetName());
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_SMInstanceSnapshot_InstancesLoaded);
+
+	if (ActiveStates.Num() == 0)
+	{
+		return true;
+	}
+
+	for (const FSMSnapshotActiveState& ActiveState : ActiveStates)
+	{
+		FSMStateMachine* ParentStateMachine = (FSMStateMachine*)ActiveState.State->GetOwnerNode();
+
+		// Don't set when the parent is a reference as it will just be forwarded back to this state.
+		if (ParentStateMachine && ParentStateMachine->GetInstanceReference() == nullptr)
+		{
+			ParentStateMachine->AddTemporaryInitialState(ActiveState.State);
+		}
+
+		ActiveState.State->SetSkipStateBegin(!bRunStateBegin);
+	}
+
+	Instance->Start();
+
+	for (const FSMSnapshotActiveState& ActiveState : ActiveStates)
+	{
+		ActiveState.State->SetSkipStateBegin(false);
+		if (ActiveState.State->IsActive())
+		{
+			ActiveState.State->TimeInState = ActiveState.TimeInState;
+		}
+	}
+
+	return true;
+}
+
+void FSMInstanceSnapshot::SaveInstances(const TArray<USMInstance*>& Instances, TArray<uint8>& OutData)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstanceSnapshot::SaveInstances"), STAT_SMInstanceSnapshot_SaveInstances, STATGROUP_LogicDriver);
+
+	OutData.Reset();
+	FMemoryWriter Writer(OutData);
+
+	uint32 NumInstances = Instances.Num();
+	Writer.SerializeIntPacked(NumInstances);
+
+	for (USMInstance* Instance : Instances)
+	{
+		// Record the size so instances which fail to save or load can be skipped.
+		const int64 SizePosition = Writer.Tell();
+		int32 DataSize = 0;
+		Writer << DataSize;
+
+		Save(Instance, Writer);
+
+		const int64 EndPosition = Writer.Tell();
+		DataSize = (int32)(EndPosition - SizePosition - sizeof(int32));
+		Writer.Seek(SizePosition);
+		Writer << DataSize;
+		Writer.Seek(EndPosition);
+	}
+}
+
+int32 FSMInstanceSnapshot::LoadInstances(const TArray<USMInstance*>& Instances, const TArray<uint8>& Data, bool bRunStateBegin)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstanceSnapshot::LoadInstances"), STAT_SMInstanceSnapshot_LoadInstances, STATGROUP_LogicDriver);
+
+	FMemoryReader Reader(Data);
+
+	uint32 NumInstances = 0;
+	Reader.SerializeIntPacked(NumInstances);
+	if (NumInstances != (uint32)Instances.Num())
+	{
+		LD_LOG_WARNING(TEXT("Loading %d State Machine Instances from snapshots of %d instances."), Instances.Num(), NumInstances);
+	}
+
+	int32 NumLoaded = 0;
+	const int32 NumToLoad = FMath::Min((int32)NumInstances, Instances.Num());
+	for (int32 Idx = 0; Idx < NumToLoad && !Reader.IsError(); ++Idx)
+	{
+		int32 DataSize = 0;
+		Reader << DataSize;
+
+		// The next record can't be found without a valid size.
+		if (Reader.IsError() || !IsRecordInBounds(Reader, DataSize))
+		{
+			LD_LOG_ERROR(TEXT("State Machine snapshot data is truncated or corrupt, stopped loading after %d of %d instances."), Idx, NumToLoad);
+			break;
+		}
+		const int64 EndPosition = Reader.Tell() + DataSize;
+
+		if (DataSize > 0 && Load(Instances[Idx], Reader, bRunStateBegin))
+		{
+			NumLoaded++;
+		}
+
+		Reader.Seek(EndPosition);
+	}
+
+	return NumLoaded;
+}
+
+bool FSMInstanceSnapshot::HasSaveGameProperties(const UClass* Class)
+{
+	auto FindSaveGameProperty = [](const UClass* InClass)
+	{
+		for (TFieldIterator<FProperty> It(InClass); It; ++It)
+		{
+			if (It->HasAnyPropertyFlags(CPF_SaveGame))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	};
+
+	if (!IsInGameThread())
+	{
+		return FindSaveGameProperty(Class);
+	}
+
+	TMap<TWeakObjectPtr<const UClass>, TPair<const FProperty*, bool>>& CachedClasses = GetCachedClasses();
+
+	// Recompiling relinks the class properties which invalidates the result.
+	TPair<const FProperty*, bool>* CachedResult = CachedClasses.Find(Class);
+	if (!CachedResult || CachedResult->Key != Class->PropertyLink)
+	{
+		CachedResult = &CachedClasses.Add(Class, TPair<const FProperty*, bool>(Class->PropertyLink, FindSaveGameProperty(Class)));
+	}
+
+	return CachedResult->Value;
+}
+
+void FSMInstanceSnapshot::ClearCache()
+{
+	GetCachedClasses().Empty();
+}
@@ -3,6 +3,8 @@
 #include "SMStateMachineComponent.h"
 #include "UObject/PropertyPortFlags.h"
 #include "Engine/Engine.h"
+#include "UnrealEngine.h"
+#include "Misc/App.h"
 #include "SMUtils.h"
 #include "SMLogging.h"
 
@@ -11,6 +13,8 @@
 USMStateMachineComponent::USMStateMachineComponent(class FObjectInitializer const & ObjectInitializer)
 {
 	R_Instance = nullptr;
+	R_NetworkNodeSignature = 0;
+	bSendFullNetworkNodeGuids = false;
 	R_bShuttingDown = false;
 	bAutoActivate = true;
 	bInitializeOnBeginPlay = true;
@@ -20,6 +24,7 @@ USMStateMachineComponent::USMStateMachineComponent(class FObjectInitializer cons
 	NetworkTransitionConfiguration = SM_Client;
 	NetworkStateConfiguration = SM_ClientAndServer;
 	TransitionResetTimeSeconds = 2.f;
+	TransitionResetMinFrames = 30;
 	bReplicateStatesOnLoad = true;
 	bTakeTransitionsFromServerOnly = false;
 	bDiscardTransitionsBeforeInitialize = false;
@@ -44,6 +49,7 @@ void USMStateMachineComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProper
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
 	DOREPLIFETIME(USMStateMachineComponent, R_Instance);
+	DOREPLIFETIME(USMStateMachineComponent, R_NetworkNodeSignature);
 	DOREPLIFETIME(USMStateMachineComponent, R_bShuttingDown);
 	DOREPLIFETIME(USMStateMachineComponent, R_NetworkedTransactions);
 }
@@ -534,6 +540,15 @@ void USMStateMachineComponent::ProcessTransaction(const TArray<FSMNetworkedTrans
 		return;
 	}
 
+	// Const cast necessary -- the args must be const, but node indices replicate smaller than guids.
+	if (HasMatchingNetworkNodeSignature())
+	{
+		for (FSMNetworkedTransaction& Transaction : const_cast<TArray<FSMNetworkedTransaction>&>(Transactions))
+		{
+			Transaction.AssignNodeIndices(R_Instance);
+		}
+	}
+
 	SERVER_ProcessTransaction(Transactions);
 }
 
@@ -644,6 +659,8 @@ void USMStateMachineComponent::DoInitialize(UObject* Context)
 		bCanInstanceNetworkTick = R_Instance->CanEverTick();
 		R_Instance->SetRegisterTick(bLetInstanceManageTick);
 		R_Instance->ComponentOwner = this;
+		R_NetworkNodeSignature = R_Instance->GetNetworkNodeSignature();
+		bSendFullNetworkNodeGuids = false;
 		
 		PostInitialize();
 	}
@@ -706,9 +723,24 @@ void USMStateMachineComponent::DoProcessTransactions(const TArray<FSMNetworkedTr
 	const TMap<FGuid, FSMTransition*>& TransitionMap = R_Instance->GetTransitionMap();
 	const TMap<FGuid, FSMState_Base*>& StateMap = R_Instance->GetStateMap();
 	
-	FDateTime CurrentTime = FDateTime::UtcNow();
+	const uint64 CurrentFrame = GFrameCounter;
+	const uint64 ExpirationFrames = GetTransactionExpirationFrames();
 	for (const FSMNetworkedTransaction& NetworkedTransaction : Transactions)
 	{
+		// Indices from an instance with different network nodes would resolve to the wrong node.
+		if (NetworkedTransaction.HasNodeIndices() && !HasMatchingNetworkNodeSignature())
+		{
+			LD_LOG_ERROR(TEXT("Networked transaction for state machine %s uses node indices but the server instance has different network nodes."), *R_Instance->GetName());
+			continue;
+		}
+		
+		// Replicated transactions may only contain node indices.
+		if (!const_cast<FSMNetworkedTransaction&>(NetworkedTransaction).ResolveNodeGuids(R_Instance))
+		{
+			LD_LOG_WARNING(TEXT("Could not resolve networked transaction for state machine %s."), *R_Instance->GetName());
+			continue;
+		}
+
 		if (FSMStateMachine* OwningStateMachine = (FSMStateMachine*)StateMap.FindRef(NetworkedTransaction.StateMachineGuid))
 		{
 			if (NetworkedTransaction.IsTransition())
@@ -717,7 +749,7 @@ void USMStateMachineComponent::DoProcessTransactions(const TArray<FSMNetworkedTr
 				// TODO: See about refactoring out previous transaction checks from the FSM to the component, similar to state transactions.
 				if (FSMTransition* Transition = (FSMTransition*)TransitionMap.FindRef(NetworkedTransaction.BaseGuid))
 				{
-					if (OwningStateMachine->ProcessTransition(Transition, &NetworkedTransaction, 0.f, &CurrentTime))
+					if (OwningStateMachine->ProcessTransition(Transition, &NetworkedTransaction, 0.f))
 					{
 						OwningStateMachine->ProcessStates(0.f);
 					}
@@ -745,36 +777,46 @@ void USMStateMachineComponent::DoProcessTransactions(const TArray<FSMNetworkedTr
 				}
 			}
 			
-			OwningStateMachine->CleanupPreviousTransactions(CurrentTime, TransitionResetTimeSeconds);
+			OwningStateMachine->CleanupPreviousTransactions(CurrentFrame, ExpirationFrames);
 		}
 	}
 }
 
 void USMStateMachineComponent::SendTransactionsToClients(const TArray<FSMNetworkedTransaction>& Transactions)
 {
-	const FDateTime CurrentTime = FDateTime::UtcNow();
-	RemoveExpiredTransactions(CurrentTime);
+	const uint64 CurrentFrame = GFrameCounter;
+	RemoveExpiredTransactions(CurrentFrame);
 
-	// Record the current time. Const cast necessary -- SERVER_ call args must be const, but we want to record the time stamp for the server only.
+	// Record the current frame. Const cast necessary -- SERVER_ call args must be const, but we want to record the frame for the server only.
 	for (FSMNetworkedTransaction& Transaction : const_cast<TArray<FSMNetworkedTransaction>&>(Transactions))
 	{
-		Transaction.Timestamp = CurrentTime;
+		Transaction.Frame = CurrentFrame;
+		if (R_Instance && Transaction.ResolveNodeGuids(R_Instance))
+		{
+			// Every client must resolve the indices, send full guids once one has reported different network nodes.
+			if (bSendFullNetworkNodeGuids)
+			{
+				Transaction.ClearNodeIndices();
+			}
+			else
+			{
+				Transaction.AssignNodeIndices(R_Instance);
+			}
+		}
 	}
 	
 	R_NetworkedTransactions.Append(Transactions);
 }
 
-void USMStateMachineComponent::RemoveExpiredTransactions(const FDateTime& CurrentTime)
+void USMStateMachineComponent::RemoveExpiredTransactions(uint64 CurrentFrame)
 {
-	const FTimespan Seconds = FTimespan::FromSeconds((double)TransitionResetTimeSeconds);
+	const uint64 ExpirationFrames = GetTransactionExpirationFrames();
 
 	int32 RemoveThroughIndex = -1;
 	for (int32 Idx = R_NetworkedTransactions.Num() - 1; Idx >= 0; --Idx)
 	{
 		const FSMNetworkedTransaction& Transaction = R_NetworkedTransactions[Idx];
-		FDateTime ExpirationDate = Transaction.Timestamp + Seconds;
-
-		if (ExpirationDate <= CurrentTime)
+		if (Transaction.Frame + ExpirationFrames <= CurrentFrame)
 		{
 			RemoveThroughIndex = Idx;
 			break;
@@ -787,6 +829,19 @@ void USMStateMachineComponent::RemoveExpiredTransactions(const FDateTime& Curren
 	}
 }
 
+uint64 USMStateMachineComponent::GetTransactionExpirationFrames() const
+{
+	// Use the fixed or averaged frame rate rather than this frame's delta, so a single long frame can't expire transactions early.
+	const double FrameRate = FApp::UseFixedTimeStep() ? 1.0 / FMath::Max(FApp::GetFixedDeltaTime(), (double)SMALL_NUMBER) : (double)GAverageFPS;
+	const int32 RateFrames = FMath::CeilToInt((float)(TransitionResetTimeSeconds * FrameRate));
+	return (uint64)FMath::Max3(1, TransitionResetMinFrames, RateFrames);
+}
+
+bool USMStateMachineComponent::HasMatchingNetworkNodeSignature() const
+{
+	return R_Instance && R_NetworkNodeSignature != 0 && R_Instance->GetNetworkNodeSignature() == R_NetworkNodeSignature;
+}
+
 bool USMStateMachineComponent::SERVER_Initialize_Validate(UObject* Context)
 {
 	return true;
@@ -849,6 +904,22 @@ void USMStateMachineComponent::SERVER_ProcessTransaction_Implementation(const TA
 	DoProcessTransactions(Transactions);
 }
 
+bool USMStateMachineComponent::SERVER_ReportNetworkNodeSignatureMismatch_Validate()
+{
+	return true;
+}
+
+void USMStateMachineComponent::SERVER_ReportNetworkNodeSignatureMismatch_Implementation()
+{
+	bSendFullNetworkNodeGuids = true;
+
+	// Transactions still replicating may have been sent with indices.
+	for (FSMNetworkedTransaction& Transaction : R_NetworkedTransactions)
+	{
+		Transaction.ClearNodeIndices();
+	}
+}
+
 void USMStateMachineComponent::REP_OnInstanceLoaded()
 {
 	if (R_Instance)
@@ -859,6 +930,13 @@ void USMStateMachineComponent::REP_OnInstanceLoaded()
 		// Initialize the replicated instance with proper function calls and context.
 		R_Instance->Initialize(R_Instance->GetContext());
 
+		// A different build of the state machine class can't use the server's node indices.
+		if (!HasMatchingNetworkNodeSignature())
+		{
+			LD_LOG_WARNING(TEXT("State machine %s has different network nodes than the server instance, transactions will replicate full guids."), *R_Instance->GetName());
+			SERVER_ReportNetworkNodeSignatureMismatch();
+		}
+
 		PostInitialize();
 
 		if (bReplicateStatesOnLoad)
@@ -0,0 +1,84 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#include "SMUpdateScheduler.h"
+#include "SMInstance.h"
+#include "SMLogging.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("SMUpdateScheduler::PreEvaluateInstances"), STAT_SMUpdateScheduler_PreEvaluateInstances, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SMUpdateScheduler Scheduled Instances"), STAT_SMUpdateScheduler_ScheduledInstances, STATGROUP_LogicDriver);
+
+void USMUpdateScheduler::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(this, &USMUpdateScheduler::OnWorldPreActorTick);
+}
+
+void USMUpdateScheduler::Deinitialize()
+{
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+	PreActorTickHandle.Reset();
+	RegisteredInstances.Empty();
+	ScheduledInstances.Empty();
+	
+	Super::Deinitialize();
+}
+
+void USMUpdateScheduler::RegisterInstance(USMInstance* Instance)
+{
+	check(IsInGameThread());
+	if (Instance)
+	{
+		RegisteredInstances.AddUnique(Instance);
+	}
+}
+
+void USMUpdateScheduler::UnregisterInstance(USMInstance* Instance)
+{
+	check(IsInGameThread());
+	RegisteredInstances.RemoveSingleSwap(Instance);
+}
+
+void USMUpdateScheduler::PreEvaluateInstances(const TArray<USMInstance*>& Instances, float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SMUpdateScheduler_PreEvaluateInstances);
+	INC_DWORD_STAT_BY(STAT_SMUpdateScheduler_ScheduledInstances, Instances.Num());
+	
+	ParallelFor(Instances.Num(), [&Instances, DeltaSeconds](int32 Index)
+	{
+		Instances[Index]->PreEvaluateTransitions(DeltaSeconds);
+	});
+}
+
+void USMUpdateScheduler::OnWorldPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld() || TickType == LEVELTICK_TimeOnly)
+	{
+		return;
+	}
+
+	const bool bIsPaused = InWorld->IsPaused();
+	
+	ScheduledInstances.Reset();
+	for (int32 Idx = RegisteredInstances.Num() - 1; Idx >= 0; --Idx)
+	{
+		USMInstance* Instance = RegisteredInstances[Idx].Get();
+		if (!Instance || Instance->IsPendingKillOrUnreachable())
+		{
+			RegisteredInstances.RemoveAtSwap(Idx);
+			continue;
+		}
+
+		if (!Instance->IsActive() || !Instance->CanEverTick() || (bIsPaused && !Instance->IsTickableWhenPaused()))
+		{
+			continue;
+		}
+		
+		ScheduledInstances.Add(Instance);
+	}
+
+	if (ScheduledInstances.Num() > 0)
+	{
+		PreEvaluateInstances(ScheduledInstances, DeltaSeconds);
+	}
+}
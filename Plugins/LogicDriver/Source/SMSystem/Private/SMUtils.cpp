@@ -4,6 +4,7 @@
 #include "Blueprints/SMBlueprintGeneratedClass.h"
 #include "Engine/World.h"
 #include "SMLogging.h"
+#include "SMInstanceSnapshot.h"
 
 
 USMInstance* USMBlueprintUtils::CreateStateMachineInstance(TSubclassOf<class USMInstance> StateMachineClass, UObject* Context)
@@ -17,6 +18,16 @@ USMInstance* USMBlueprintUtils::CreateStateMachineInstanceFromTemplate(TSubclass
 	return CreateStateMachineInstanceInternal(StateMachineClass, Context, Template);
 }
 
+void USMBlueprintUtils::SaveStateMachineSnapshots(const TArray<USMInstance*>& Instances, TArray<uint8>& OutData)
+{
+	FSMInstanceSnapshot::SaveInstances(Instances, OutData);
+}
+
+int32 USMBlueprintUtils::LoadStateMachineSnapshots(const TArray<USMInstance*>& Instances, const TArray<uint8>& Data, bool bRunStateBegin)
+{
+	return FSMInstanceSnapshot::LoadInstances(Instances, Data, bRunStateBegin);
+}
+
 USMInstance* USMBlueprintUtils::CreateStateMachineInstanceInternal(TSubclassOf<USMInstance> StateMachineClass,
 	UObject* Context, USMInstance* Template)
 {
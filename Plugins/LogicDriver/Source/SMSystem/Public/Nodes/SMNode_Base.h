@@ -25,7 +25,8 @@ public:
 	FSMNetworkedTransaction() : FSMNetworkedTransaction(FGuid(), FGuid()) {}
 	
 	FSMNetworkedTransaction(const FGuid& SMGuid, const FGuid& TGuid, ESMTransactionType Type = ESMTransactionType::SM_Transition) :
-	StateMachineGuid(SMGuid), BaseGuid(TGuid), TransactionGuid(FGuid::NewGuid()), Timestamp(0), TransactionType((int32)Type), bIsActive(false) {}
+	StateMachineGuid(SMGuid), BaseGuid(TGuid), TransactionGuid(FGuid::NewGuid()), Frame(0), StateMachineIndex(INDEX_NONE), BaseIndex(INDEX_NONE),
+	TransactionType((int32)Type), bIsActive(false) {}
 
 	/** The owning state machine. */
 	UPROPERTY()
@@ -35,13 +36,18 @@ public:
 	UPROPERTY()
 	FGuid BaseGuid;
 
-	/** Unique to this transaction. */
+	/** Unique to this transaction. Always replicated in full, since a collision would silently drop a transition. */
 	UPROPERTY(meta = (IgnoreForMemberInitializationTest))
 	FGuid TransactionGuid;
 
-	/** A UTC timestamp. Should be set manually. */
-	UPROPERTY()
-	FDateTime Timestamp;
+	/** The local GFrameCounter the transaction was recorded. Replicated as the number of frames since then. */
+	uint64 Frame;
+
+	/** Index of StateMachineGuid from USMInstance::GetNetworkNodeIndex. Replicated instead of the guid when set. */
+	int32 StateMachineIndex;
+
+	/** Index of BaseGuid from USMInstance::GetNetworkNodeIndex. Replicated instead of the guid when set. */
+	int32 BaseIndex;
 
 	/** ESMTransactionType. */
 	UPROPERTY()
@@ -53,6 +59,30 @@ public:
 
 	bool IsTransition() const { return (ESMTransactionType)TransactionType == ESMTransactionType::SM_Transition; }
 	bool IsState() const { return (ESMTransactionType)TransactionType == ESMTransactionType::SM_State; }
+
+	/** Set node indices from the instance so the transaction can be replicated without full guids. */
+	void AssignNodeIndices(USMInstance* Instance);
+
+	/** Replicate full guids instead of node indices. */
+	void ClearNodeIndices() { StateMachineIndex = BaseIndex = INDEX_NONE; }
+
+	/** If node indices are set instead of full guids. */
+	bool HasNodeIndices() const { return StateMachineIndex != INDEX_NONE && BaseIndex != INDEX_NONE; }
+
+	/** Set node guids from replicated node indices. Returns false if the indices aren't valid for the instance. */
+	bool ResolveNodeGuids(USMInstance* Instance);
+
+	/** Compact replication. Node guids are sent as indices when assigned and the timestamp as a frame delta. */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FSMNetworkedTransaction> : public TStructOpsTypeTraitsBase2<FSMNetworkedTransaction>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
 };
 
 /**
@@ -119,6 +149,8 @@ public:
 	const FGuid& GetGuid() const;
 	/** Calculate the value returned from GetGuid(). Gets all owner nodes and builds a path to this node. Hashes the path and sets PathGuid. */
 	virtual void CalculatePathGuid(TMap<FString, int32>& MappedPaths);
+	/** Set the value returned from GetGuid() when it is already known, such as from a cached class layout. */
+	void SetPathGuid(const FGuid& NewGuid);
 	/** Unhashed string format of the guid path. MappedPaths are used to adjust for collisions. */
 	FString GetGuidPath(TMap<FString, int32>& MappedPaths) const;
 	
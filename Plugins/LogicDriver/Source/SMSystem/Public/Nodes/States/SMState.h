@@ -134,6 +134,12 @@ public:
 	/** If this state is allowed to execute logic. */
 	bool CanExecuteLogic() const { return bCanExecuteLogic; }
 
+	/** Skip begin logic when this state starts, such as when it is restored from a snapshot. Must be reset once started. */
+	void SetSkipStateBegin(bool bValue) { bSkipStateBegin = bValue; }
+
+	/** If begin logic should be skipped when this state starts. */
+	bool ShouldSkipStateBegin() const { return bSkipStateBegin; }
+
 	/**
 	 * Checks if the instance is allowed to execute properties automatically.
 	 * @param OnEvent 0 - Start, 1 - Update, 2 - End, 3 - RootSMStart
@@ -178,6 +184,7 @@ protected:
 	/** True only when already active and entered from a parallel state. */
 	bool bReenteredByParallelState;
 	bool bCanExecuteLogic = true;
+	bool bSkipStateBegin = false;
 
 	/** True while the state is ending and graph execution is occurring. Prevents restarting this state when it triggers transitions while ending. */
 	bool bIsStateEnding = false;
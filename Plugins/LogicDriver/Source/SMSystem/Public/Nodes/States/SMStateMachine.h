@@ -5,6 +5,8 @@
 #include "SMTransition.h"
 #include "SMStateMachine.generated.h"
 
+/** Active states processed each update without a heap allocation. */
+#define SM_INLINE_ACTIVE_STATES 8
 
 /**
  * State machines contain states and transitions. When a transition succeeds the current state advances to the next.
@@ -145,17 +147,27 @@ public:
 	 */
 	void ProcessStates(float DeltaSeconds, bool bForceTransitionEvaluationOnly = false);
 
+	/**
+	 * Evaluate the transitions of all active states, including local nested state machines, without taking them.
+	 * This only finds passing transitions early. ProcessStates always evaluates transitions again with the current conditions,
+	 * so the results never change which transition is taken or when.
+	 * Only states whose transitions can all evaluate on any thread are included, so this may be called from a worker thread.
+	 */
+	void PreEvaluateTransitions();
+
+	/** The first transition of each passing chain found by the last PreEvaluateTransitions call. */
+	const TArray<FSMTransition*>& GetPreEvaluatedTransitions() const { return PreEvaluatedTransitions; }
+
 	/**
 	 * Attempt to take a transition. Returns true if successful.
 	 * @param Transition The transition to process.
 	 * @param Transaction A network transaction if one exists. May be null.
 	 * @param DeltaSeconds The time in seconds since the last update.
-	 * @param CurrentTime The current UTC time. Only utilized in networked environments when checking for expired previous transitions.
 	 */
-	bool ProcessTransition(FSMTransition* Transition, const FSMNetworkedTransaction* Transaction, float DeltaSeconds, FDateTime* CurrentTime = nullptr);
+	bool ProcessTransition(FSMTransition* Transition, const FSMNetworkedTransaction* Transaction, float DeltaSeconds);
 
-	/** Check for and remove expired transactions. */
-	void CleanupPreviousTransactions(const FDateTime& CurrentTime, float PreviousTransactionTimeout);
+	/** Check for and remove transactions recorded more than ExpirationFrames before CurrentFrame. */
+	void CleanupPreviousTransactions(uint64 CurrentFrame, uint64 ExpirationFrames);
 	
 	/** State Machine is currently waiting for a transition update from the server. */
 	bool IsWaitingForUpdate() const { return bWaitingForTransitionUpdate; }
@@ -215,6 +227,12 @@ protected:
 	 * @param FromState: The state we are switching from. If not null it will be removed from the active list if bStayActiveOnStateChange is false.
 	 */
 	void SetCurrentState(FSMState_Base* ToState, FSMState_Base* FromState);
+
+	/** Keep the owning instance's active state tracking in sync with ActiveStates. */
+	void NotifyActiveStateChanged(FSMState_Base* State, bool bIsActive);
+
+	/** If an outgoing transition of the state has an event or signal which evaluating it would consume. */
+	static bool HasPendingTransitionEvent(FSMState_Base* State);
 	
 protected:
 	TArray<FSMState_Base*> States;
@@ -234,8 +252,14 @@ protected:
 	/** In most cases this should be of size 0 or 1. Greater than 1 implies the sm is configured for multiple active states */
 	TSet<FSMState_Base*> ActiveStates;
 
-	/** Keeps track of states currently processing. Helps with possible infinite recursion when using multiple states that can re-enter each other. */
+	/**
+	 * Keeps track of states currently processing. Helps with possible infinite recursion when using multiple states that can re-enter each other.
+	 * Only reset between updates so the allocation is kept.
+	 */
 	TSet<FSMState_Base*> ProcessingStates;
+
+	/** Passing transitions found by PreEvaluateTransitions. Only reset between calls so the allocation is kept. */
+	TArray<FSMTransition*> PreEvaluatedTransitions;
 	
 	UPROPERTY()
 	UClass* ReferencedStateMachineClass;
@@ -83,6 +83,21 @@ public:
 	UPROPERTY()
 	uint32 bAlwaysFalse: 1;
 
+	/**
+	 * Only evaluate conditionally when the state leading to this transition starts or when signaled,
+	 * instead of every tick. The transition is signaled by SignalEvents or changes to SignalProperties.
+	 */
+	UPROPERTY()
+	uint32 bEvaluateOnSignal: 1;
+
+	/** Events raised through USMInstance::SignalEvent which wake this transition while its state is active. */
+	UPROPERTY()
+	TArray<FName> SignalEvents;
+
+	/** Variables of the owning state machine instance which wake this transition when changed. */
+	UPROPERTY()
+	TArray<FName> SignalProperties;
+
 	/** Guid to the state this transition is from. Kismet compiler will convert this into a state link. */
 	UPROPERTY()
 	FGuid FromGuid;
@@ -140,6 +155,21 @@ public:
 	/* If the transition is allowed to evaluate from an event. **/
 	bool CanEvaluateFromEvent() const;
 
+	/** Wake this transition so it evaluates the next time its state processes transitions. */
+	void Signal() { bHasPendingSignal = true; }
+
+	/** If this transition has been signaled and hasn't evaluated since. */
+	bool HasPendingSignal() const { return bHasPendingSignal; }
+	
+	/** If this transition evaluates on signal and is sleeping. */
+	bool IsWaitingForSignal() const { return bEvaluateOnSignal && !bHasPendingSignal; }
+
+	/**
+	 * If evaluating this transition is safe from a worker thread. Only transitions which never execute blueprint graphs or node instance
+	 * logic qualify, such as conditions the compiler reduced to a fast path and transitions without pre or post evaluate logic.
+	 */
+	bool CanEvaluateOnAnyThread() const;
+
 	FORCEINLINE FSMState_Base* GetFromState() const { return FromState; }
 	FORCEINLINE FSMState_Base* GetToState() const { return ToState; }
 
@@ -165,4 +195,7 @@ public:
 private:
 	FSMState_Base* FromState;
 	FSMState_Base* ToState;
+
+	/** Set when signaled and cleared once evaluated. */
+	bool bHasPendingSignal;
 };
\ No newline at end of file
@@ -109,6 +109,22 @@ public:
 	UPROPERTY(EditDefaultsOnly, AdvancedDisplay, Category = Transition, meta = (NoResetToDefault))
 	bool bCanEvalWithStartState;
 
+	/**
+	 * Instead of evaluating every tick, only evaluate when the state leading to this transition starts and when signaled
+	 * by one of the Signal Events or a change to one of the Signal Properties. Auto-bound events still evaluate as normal.
+	 * Not supported on transitions leaving a conduit which is evaluated with transitions, since the conduit is never active.
+	 */
+	UPROPERTY(EditDefaultsOnly, AdvancedDisplay, Category = "Evaluate On Signal")
+	bool bEvaluateOnSignal;
+
+	/** Events raised from the state machine instance with SignalEvent which wake this transition. */
+	UPROPERTY(EditDefaultsOnly, AdvancedDisplay, Category = "Evaluate On Signal", meta = (EditCondition = "bEvaluateOnSignal"))
+	TArray<FName> SignalEvents;
+
+	/** Member variables of the state machine blueprint which wake this transition when their value changes. Checked once per update and validated on compile. */
+	UPROPERTY(EditDefaultsOnly, AdvancedDisplay, Category = "Evaluate On Signal", meta = (EditCondition = "bEvaluateOnSignal"))
+	TArray<FName> SignalProperties;
+
 	/** Called when this transition has been entered from the previous state. */
 	UPROPERTY(BlueprintAssignable, Category = "Logic Driver|Node Instance")
 	FOnTransitionEnteredSignature OnTransitionEnteredEvent;
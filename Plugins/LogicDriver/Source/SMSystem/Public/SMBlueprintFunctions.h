@@ -5,6 +5,23 @@
 #include "SMBlueprintFunctions.generated.h"
 
 
+/** Simple conditions the compiler can evaluate by reading a property directly instead of calling the graph function. */
+UENUM()
+enum class ESMExposedFunctionFastPath : uint8
+{
+	/** The graph function is always executed. */
+	None,
+	/** The result is a boolean property. */
+	ReadBool,
+	/** The result compares a boolean or numeric property against a constant. */
+	Equal,
+	NotEqual,
+	Less,
+	LessEqual,
+	Greater,
+	GreaterEqual
+};
+
 USTRUCT(BlueprintInternalUseOnly)
 struct SMSYSTEM_API FSMExposedFunctionHandler
 {
@@ -12,8 +29,11 @@ struct SMSYSTEM_API FSMExposedFunctionHandler
 
 	FSMExposedFunctionHandler()
 		: BoundFunction(NAME_None)
+		  , FastPath(ESMExposedFunctionFastPath::None)
+		  , FastPathPropertyName(NAME_None)
 		  , Function(nullptr)
-		  , OwnerObject(nullptr), bInitialized(false)
+		  , OwnerObject(nullptr), bInitialized(false), ParmsSize(0)
+		  , FastPathProperty(nullptr), FastPathIntConstant(0), FastPathFloatConstant(0.f), bFastPathFloatingPoint(false)
 	{
 	}
 
@@ -21,6 +41,18 @@ struct SMSYSTEM_API FSMExposedFunctionHandler
 	UPROPERTY()
 	FName BoundFunction;
 
+	/** Set by the compiler when the graph only reads a property or compares it against a constant. */
+	UPROPERTY()
+	ESMExposedFunctionFastPath FastPath;
+
+	/** The member property of the owner object the fast path reads. */
+	UPROPERTY()
+	FName FastPathPropertyName;
+
+	/** The constant the property is compared against as exported text. */
+	UPROPERTY()
+	FString FastPathConstant;
+
 	/** Lookup the UFunction by the function name. */
 	void Initialize(UObject* StateMachineObject);
 	void Reset();
@@ -28,7 +60,30 @@ struct SMSYSTEM_API FSMExposedFunctionHandler
 	/** Execute the function. */
 	void Execute(void* Parms = nullptr) const;
 
+	/**
+	 * Evaluate the condition by reading the property directly if a fast path was compiled.
+	 * @param bOutResult The result of the condition. Only set if this returns true.
+	 * @return False if the graph function needs to be executed instead.
+	 */
+	bool TryEvaluateFastPath(bool& bOutResult) const;
+
+	/** If a graph function is bound to this handler. */
+	bool IsBound() const { return BoundFunction != NAME_None; }
+
+	/** If TryEvaluateFastPath will succeed without executing the graph function. */
+	bool CanEvaluateFastPath() const { return FastPathProperty && bFastPathEnabled && bInitialized; }
+
+	/** When disabled conditions always execute the graph function. */
+	static void SetFastPathEnabled(bool bValue) { bFastPathEnabled = bValue; }
+	static bool IsFastPathEnabled() { return bFastPathEnabled; }
+
+	/** Remove cached function and property lookups. Required when a class is recompiled. */
+	static void ClearCache();
+
 private:
+	/** Resolve the fast path property and constant. Leaves FastPathProperty null if it can't be used. */
+	void InitializeFastPath(UClass* Class);
+	
 	UPROPERTY()
 	UFunction* Function;
 
@@ -36,4 +91,15 @@ private:
 	UObject* OwnerObject;
 
 	bool bInitialized;
-};
\ No newline at end of file
+
+	/** Size of the parameters Function expects. */
+	int32 ParmsSize;
+	
+	FProperty* FastPathProperty;
+	int64 FastPathIntConstant;
+	/** Blueprint float comparisons operate on floats, so the constant is stored and compared at that precision. */
+	float FastPathFloatConstant;
+	bool bFastPathFloatingPoint;
+
+	static bool bFastPathEnabled;
+};
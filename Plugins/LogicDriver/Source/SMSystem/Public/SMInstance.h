@@ -10,6 +10,8 @@
 #include "SMNode_Info.h"
 #include "SMInstance.generated.h"
 
+struct FSMInstanceClassLayout;
+class USMInstancePool;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnStateMachineInitializedSignature, class USMInstance*, Instance);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnStateMachineStartedSignature, class USMInstance*, Instance);
@@ -18,6 +20,19 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnStateMachineStoppedSignature, cla
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnStateMachineTransitionTakenSignature, class USMInstance*, Instance, struct FSMTransitionInfo, Transition);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnStateMachineStateChangedSignature, class USMInstance*, Instance, struct FSMStateInfo, NewState, struct FSMStateInfo, PreviousState);
 
+/** A variable watched by transitions which evaluate on signal. */
+struct FSMWatchedProperty
+{
+	/** The instance containing the variable. Either the watching instance or one of its references. */
+	UObject* Owner = nullptr;
+	FProperty* Property = nullptr;
+
+	/** The value as of the last check. */
+	TArray<uint8> Value;
+
+	/** Transitions to signal when the value changes. */
+	TArray<FSMTransition*> Transitions;
+};
 
 USTRUCT()
 struct FSMDebugStateMachine
@@ -155,6 +170,14 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
 	void EvaluateTransitions();
+
+	/**
+	 * Raise a named event for transitions set to evaluate on signal. Transitions listening for this event wake when the
+	 * state leading to them is active, and evaluate the next time transitions are processed.
+	 * @return True if any transition was signaled.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	bool SignalEvent(FName EventName);
 	
 	/**
 	 * Sets a temporary initial state of the guid's owning state machine.
@@ -174,6 +197,24 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
 	void LoadFromMultipleStates(const TArray<FGuid>& FromGuids);
 
+	/**
+	 * Write the active states, their time in state, and node instance variables marked SaveGame to a compact binary snapshot.
+	 * Faster than saving and restoring active state guids. Use SaveStateMachineSnapshots for many instances at once.
+	 * @param OutData The snapshot.
+	 * @return True if the snapshot was written.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	bool SaveSnapshot(TArray<uint8>& OutData);
+
+	/**
+	 * Restore a snapshot from SaveSnapshot and start the state machine from it. Must be initialized and not running.
+	 * @param Data The snapshot.
+	 * @param bRunStateBegin Run begin logic of the restored states. If false restored states become active without executing any logic.
+	 * @return True if the snapshot was restored.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	bool LoadSnapshot(const TArray<uint8>& Data, bool bRunStateBegin = true);
+
 //#pragma region Node Locator Helpers
 	/**
 	 * Return the current active state name, or an empty string.
@@ -228,8 +269,14 @@ public:
 	 */
 	FSMState_Base* GetSingleNestedActiveState() const;
 
-	/** Recursively retrieve all active states. */
+	/**
+	 * Retrieve all active states including nested state machines and references. Tracked as states are entered and exited.
+	 * States are ordered by hierarchy so a state machine is always listed before its nested states.
+	 */
 	TArray<FSMState_Base*> GetAllActiveStates() const;
+
+	/** Incremented whenever a state returned from GetAllActiveStates() changes. */
+	uint32 GetActiveStatesVersion() const { return ActiveStatesVersion; }
 	
 	/**
 	 * Recursively retrieve the guid of all current states. Useful if saving the current state of a state machine.
@@ -373,6 +420,19 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
 	float GetTickInterval() const { return TickInterval; }
 
+	/** If transitions are evaluated on worker threads by the update scheduler before this instance ticks. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	bool CanEvaluateTransitionsInParallel() const { return bEvaluateTransitionsInParallel; }
+
+	/**
+	 * Evaluate transitions of all active states ahead of the next update without taking them or running state logic.
+	 * The update still evaluates transitions with the current conditions, this only finds passing transitions early.
+	 * Called by the update scheduler from worker threads when bEvaluateTransitionsInParallel is set.
+	 *
+	 * @param DeltaSeconds The time that will be passed to the next tick. Instances which won't update from it are skipped.
+	 */
+	void PreEvaluateTransitions(float DeltaSeconds);
+
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
 	void SetStopOnEndState(bool Value);
 
@@ -395,6 +455,21 @@ public:
 
 	const TArray<FGuid>& GetReplicatedStates() const { return R_ActiveStates; }
 
+	/**
+	 * Find a compact index for a node PathGuid which is the same on every instance of this class.
+	 * Used to replicate transactions without full guids. Returns INDEX_NONE if the guid isn't mapped.
+	 */
+	int32 GetNetworkNodeIndex(const FGuid& PathGuid);
+
+	/** Find the node PathGuid for an index from GetNetworkNodeIndex. Returns nullptr if the index isn't valid. */
+	const FGuid* GetNetworkNodeGuid(int32 Index);
+
+	/** Find the node for an index from GetNetworkNodeIndex. Returns nullptr if the index isn't valid. */
+	FSMNode_Base* GetNetworkNode(int32 Index);
+
+	/** A checksum of the Path Guids used for network node indices. Indices are only compatible between instances with the same signature. */
+	uint32 GetNetworkNodeSignature();
+
 	/** Retrieve all state instances. These can be States, State Machines, and Conduits. */
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
 	void GetAllStateInstances(TArray<USMStateInstance_Base*>& StateInstances) const;
@@ -439,6 +514,12 @@ public:
 	/** Get the instance owning this reference. If null this is not a reference. */
 	const USMInstance* GetReferenceOwnerConst() const { return ReferenceOwner; }
 
+	/** Set the pool this instance returns to when it is shutdown. */
+	void SetOwningPool(USMInstancePool* Pool) { OwningPool = Pool; }
+
+	/** The pool this instance returns to when it is shutdown, if any. */
+	USMInstancePool* GetOwningPool() const { return OwningPool.Get(); }
+
 	/** Look up the owners to find the root. */
 	const USMInstance* GetMasterReferenceOwnerConst() const;
 
@@ -490,6 +571,15 @@ public:
 
 	/** Sent state change events. */
 	void NotifyStateChange(FSMState_Base* ToState, FSMState_Base* FromState);
+
+	/** Called by state machines when a state is added to or removed from their active states. */
+	void NotifyActiveStateChanged(FSMState_Base* State, bool bIsActive);
+
+	/**
+	 * Called by state machines when their temporary entry states change.
+	 * @param StateMachineDelta 1 if the state machine now has temporary entry states, -1 if they were cleared, otherwise 0.
+	 */
+	void NotifyTemporaryEntryStatesChanged(int32 StateMachineDelta);
 	
 	/** Used to identify the root state machine during initialization. This is not a calculated value and represents the NodeGuid. */
 	UPROPERTY()
@@ -547,6 +637,9 @@ protected:
 	 * of all instances built to prevent stack overflow in the event of state machine references that self reference. */
 	void BuildStateMachineMap(FSMStateMachine* StateMachine, TSet<USMInstance*>& InstancesMapped);
 
+	/** Link nodes and build the node maps from the cached layout of this class instead of generating the state machine. */
+	void InitializeFromClassLayout(const FSMInstanceClassLayout& ClassLayout);
+
 	/** Logs a warning if not initialized. */
 	bool CheckIsInitialized() const;
 
@@ -558,6 +651,12 @@ protected:
 	
 	void DoStart();
 
+	/** Stop and reset this instance without returning it to its pool. */
+	void ShutdownInternal();
+
+	/** Add or remove this instance from the world update scheduler depending on bEvaluateTransitionsInParallel. */
+	void UpdateSchedulerRegistration(bool bRegister);
+
 	UFUNCTION()
 	void REP_StartChanged();
 protected:
@@ -580,6 +679,15 @@ protected:
 	
 	/** Map of all StateMachine Path Guids */
 	TSet<FGuid> StateMachineGuids;
+
+	/** Sorted node Path Guids used for network node indices. Built on demand. */
+	TArray<FGuid> NetworkNodeGuids;
+
+	/** Nodes in the same order as NetworkNodeGuids. */
+	TArray<FSMNode_Base*> NetworkNodes;
+
+	/** Checksum of NetworkNodeGuids. */
+	uint32 NetworkNodeSignature = 0;
 	
 	/** Networked transactions that are currently being executed. Only valid for one update cycle and only used if there is a server object. */
 	UPROPERTY(Transient)
@@ -601,6 +709,10 @@ protected:
 	UPROPERTY()
 	USMInstance* ReferenceOwner;
 
+	/** The pool this instance was acquired from. */
+	UPROPERTY(Transient)
+	TWeakObjectPtr<USMInstancePool> OwningPool;
+
 	/** The custom node instance class to use for this state machine. This is not the same as USMInstance. */
 	UPROPERTY(EditDefaultsOnly, Category = "State Machine Instance", meta = (BlueprintBaseOnly, DisplayName = "Node Class"))
 	TSubclassOf<class USMStateMachineInstance> StateMachineClass;
@@ -639,6 +751,16 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "State Machine Instance|Tick", meta = (EditCondition = "bTickRegistered"))
 	bool bTickBeforeInitialize;
 
+	/**
+	 * Evaluate transitions on task graph worker threads each frame before actors tick. This only finds passing transitions
+	 * early, the update still evaluates every transition on the game thread with the current conditions before taking it.
+	 *
+	 * Only states whose transitions are always true, always false, or compiled to a fast path variable check are evaluated
+	 * in parallel. Any graph or node instance logic, events, conduits and state machine references stay on the game thread.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "State Machine Instance|Tick", meta = (EditCondition = "bCanEverTick"))
+	bool bEvaluateTransitionsInParallel = false;
+
 #if WITH_EDITORONLY_DATA
 	/** Enable info logging for the state machine. */
 	UPROPERTY(EditDefaultsOnly, Category = "State Machine Instance|Logging")
@@ -702,8 +824,62 @@ public:
 	TArray<UObject*> ReferenceTemplates;
 
 private:
+	/** Seed active state tracking from a full scan of the state machine hierarchy. */
+	void RebuildActiveStateTracking();
+
+	/** Number every state by its position in the hierarchy, visiting each state machine's states before its nested state machines. */
+	void BuildActiveStateOrder(const FSMStateMachine& StateMachine, int32& NextIndex, TSet<USMInstance*>& InstancesVisited);
+
+	/** Invalidate cached active state results. */
+	void MarkActiveStatesChanged();
+
+	/** Map events and watched variables to the transitions which evaluate on signal. */
+	void RebuildSignalBindings();
+
+	/** Release watched variable values. */
+	void ClearSignalBindings();
+
+	/** Sort node Path Guids and map them to nodes for network node indices. */
+	void BuildNetworkNodeIndices();
+
+	/** Signal transitions watching variables which changed since the last check. */
+	void CheckWatchedProperties();
+
 	bool bInitialized = false;
 
+	/** All active states of this instance and its references, maintained as states are entered and exited. */
+	TSet<FSMState_Base*> TrackedActiveStates;
+
+	/** Hierarchy position of every state, including references. Used to keep the active state list in a stable order. */
+	TMap<FSMState_Base*, int32> ActiveStateOrder;
+
+	/** TrackedActiveStates sorted by ActiveStateOrder, built on request. */
+	mutable TArray<FSMState_Base*> CachedActiveStates;
+
+	/** If CachedActiveStates needs to be rebuilt. */
+	mutable bool bActiveStatesDirty = true;
+
+	/** Active state guids built from TrackedActiveStates on request. */
+	mutable TArray<FGuid> CachedActiveStateGuids;
+
+	/** If CachedActiveStateGuids needs to be rebuilt. */
+	mutable bool bActiveStateGuidsDirty = true;
+
+	/** State machines which have temporary entry states. These are reported as active so a full scan is used while any exist. */
+	int32 NumTemporaryEntryStateMachines = 0;
+
+	/** Incremented when active states change. */
+	uint32 ActiveStatesVersion = 0;
+
+	/** The ActiveStatesVersion R_ActiveStates was last set from. */
+	uint32 ReplicatedActiveStatesVersion = 0;
+
+	/** Transitions which evaluate on signal mapped by the events which wake them. Includes transitions of references. */
+	TMap<FName, TArray<FSMTransition*>> SignalEventTransitions;
+
+	/** Variables watched by transitions which evaluate on signal. Includes variables of references. */
+	TArray<FSMWatchedProperty> WatchedProperties;
+
 #if WITH_EDITORONLY_DATA
 	FSMDebugStateMachine DebugStateMachine;
 #endif
@@ -0,0 +1,80 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USMInstance;
+
+/**
+ * The structure of a state machine class which is identical for every instance. Nodes are stored by their offset in the
+ * instance so a new instance can be linked without searching class properties, matching guids, or building guid paths.
+ */
+struct SMSYSTEM_API FSMInstanceClassLayout
+{
+	struct FTransitionLayout
+	{
+		int32 Offset;
+		int32 FromStateOffset;
+		int32 ToStateOffset;
+	};
+
+	struct FStateMachineLayout
+	{
+		int32 Offset;
+		TArray<int32> StateOffsets;
+		TArray<int32> EntryStateOffsets;
+		TArray<FTransitionLayout> Transitions;
+	};
+
+	enum class ENodeType : uint8
+	{
+		StateMachine,
+		State,
+		Transition
+	};
+	
+	struct FNodeLayout
+	{
+		FGuid PathGuid;
+		int32 Offset;
+		ENodeType Type;
+	};
+
+	/** The NodeGuid of the root state machine. */
+	FGuid RootGuid;
+
+	/** Owning state machines are always listed before their nested state machines. */
+	TArray<FStateMachineLayout> StateMachines;
+
+	/** Every node including the root state machine. */
+	TArray<FNodeLayout> Nodes;
+	
+	/** Class property data when recorded. Recompiling a class relinks its properties which invalidates the layout. */
+	const FProperty* PropertyLink;
+	int32 PropertiesSize;
+};
+
+/**
+ * Per class cache of FSMInstanceClassLayout. Only accessed from the game thread.
+ */
+class SMSYSTEM_API FSMInstanceClassLayoutCache
+{
+public:
+	/** Find the layout of a class. Returns nullptr if the class hasn't been recorded or was changed since. */
+	static const FSMInstanceClassLayout* Find(const UClass* Class);
+
+	/** Record the layout of an instance which was just generated. Instances containing state machine references aren't recorded. */
+	static void Record(USMInstance* Instance);
+
+	/** Remove all recorded layouts. */
+	static void Clear();
+
+	/** When disabled every instance will be generated from class properties. */
+	static void SetEnabled(bool bValue);
+	static bool IsEnabled() { return bEnabled; }
+
+private:
+	static TMap<TWeakObjectPtr<const UClass>, FSMInstanceClassLayout>& GetLayouts();
+
+	static bool bEnabled;
+};
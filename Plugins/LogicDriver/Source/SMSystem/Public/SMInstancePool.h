@@ -0,0 +1,62 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "SMInstancePool.generated.h"
+
+class USMInstance;
+
+USTRUCT()
+struct FSMPooledInstances
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<USMInstance*> Instances;
+};
+
+/**
+ * Recycles state machine instances of the same class. Instances acquired from the pool return to it when they are shutdown,
+ * and are initialized with a new context the next time they are acquired.
+ */
+UCLASS()
+class SMSYSTEM_API USMInstancePool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	USMInstancePool();
+
+	// USubsystem
+	virtual void Deinitialize() override;
+	// ~USubsystem
+	
+	/**
+	 * Retrieve an initialized instance from the pool or create a new one. Shutdown the instance to return it.
+	 * Blueprint variables of a reused instance are reset to their class defaults. Native properties of C++ subclasses are kept.
+	 *
+	 * @param StateMachineClass The class of the state machine.
+	 * @param Context The context the instance will run under.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	USMInstance* AcquireInstance(TSubclassOf<USMInstance> StateMachineClass, UObject* Context);
+
+	/** Add a shutdown instance to the pool and reset its blueprint variables. Called automatically when a pooled instance is shutdown. */
+	void ReturnInstance(USMInstance* Instance);
+
+	/** The number of instances of a class available for reuse. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	int32 GetNumPooledInstances(TSubclassOf<USMInstance> StateMachineClass) const;
+
+	/** Release all pooled instances. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	void EmptyPool();
+
+	/** The maximum instances kept for each class. Instances returned beyond this are left for garbage collection. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Logic Driver|State Machine Instances")
+	int32 MaxInstancesPerClass;
+
+private:
+	UPROPERTY(Transient)
+	TMap<UClass*, FSMPooledInstances> PooledInstances;
+};
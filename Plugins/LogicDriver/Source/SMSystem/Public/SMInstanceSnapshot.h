@@ -0,0 +1,52 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USMInstance;
+
+/**
+ * Compact binary snapshots of the run-time state of state machine instances. Nodes are written by their network node index
+ * rather than their guid and restoring doesn't require guid lookups. A snapshot contains:
+ *
+ * - The active states, including nested state machines and references, with their time in state.
+ * - Node instance variables marked SaveGame.
+ *
+ * Snapshots can only be restored to instances of the class they were saved from.
+ */
+class SMSYSTEM_API FSMInstanceSnapshot
+{
+public:
+	enum EVersion : uint8
+	{
+		Initial = 1,
+
+		VersionPlusOne,
+		Latest = VersionPlusOne - 1
+	};
+
+	/** Write a snapshot of an initialized instance. */
+	static bool Save(USMInstance* Instance, FArchive& Ar);
+
+	/**
+	 * Restore a snapshot and start the instance from it. The instance must be initialized and not running.
+	 * @param bRunStateBegin Run begin logic of the restored states. If false states become active without executing any logic.
+	 */
+	static bool Load(USMInstance* Instance, FArchive& Ar, bool bRunStateBegin = true);
+
+	/** Write snapshots of many instances into one buffer. */
+	static void SaveInstances(const TArray<USMInstance*>& Instances, TArray<uint8>& OutData);
+
+	/**
+	 * Restore many instances from a buffer written by SaveInstances. Instances must be in the same order they were saved in.
+	 * @return The number of instances restored.
+	 */
+	static int32 LoadInstances(const TArray<USMInstance*>& Instances, const TArray<uint8>& Data, bool bRunStateBegin = true);
+
+	/** Clear cached class information. Call when classes may have changed such as after compiling. */
+	static void ClearCache();
+
+private:
+	/** If a node instance class has variables marked SaveGame. Cached per class. */
+	static bool HasSaveGameProperties(const UClass* Class);
+};
@@ -172,7 +172,13 @@ protected:
 	void SendTransactionsToClients(const TArray<FSMNetworkedTransaction>& Transactions);
 
 	/* Removes all replicated transitions that have expired. */
-	void RemoveExpiredTransactions(const FDateTime& CurrentTime);
+	void RemoveExpiredTransactions(uint64 CurrentFrame);
+
+	/** The number of frames TransitionResetTimeSeconds covers at the fixed or average frame rate, and at least TransitionResetMinFrames. */
+	uint64 GetTransactionExpirationFrames() const;
+
+	/** If the local instance has the same network nodes as the server instance, so transactions can use node indices. */
+	bool HasMatchingNetworkNodeSignature() const;
 	
 //#pragma region Server Implementations
 	/** Signal the server to initialize state machine. */
@@ -199,6 +205,10 @@ protected:
 	UFUNCTION(Server, Reliable, WithValidation)
 	void SERVER_ProcessTransaction(const TArray<FSMNetworkedTransaction>& Transactions);
 
+	/** Signal the server this client has different network nodes so transactions must be sent with full guids. */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void SERVER_ReportNetworkNodeSignatureMismatch();
+
 	/** When the StateMachineInstance is loaded from the server. */
 	UFUNCTION()
 	virtual void REP_OnInstanceLoaded();
@@ -258,11 +268,16 @@ public:
 	bool bTakeTransitionsFromServerOnly;
 
 	/**
-	 * All transitions taken are timestamped and stored in a replicated array allowing all clients to take the same transitions.
-	 * Once this reset time is reached all expired transitions are removed from the array.
+	 * All transitions taken are stamped with the frame they were taken and stored in a replicated array allowing all clients to take the same transitions.
+	 * Once this reset time is reached all expired transitions are removed from the array. The time is converted to frames using the fixed
+	 * frame rate when set, otherwise the average frame rate.
 	 */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, AdvancedDisplay, Category = "Network", meta = (EditCondition = "bReplicates", ClampMin="0.0"))
 	float TransitionResetTimeSeconds;
+
+	/** The minimum number of frames replicated transitions are kept, regardless of TransitionResetTimeSeconds and the frame rate. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, AdvancedDisplay, Category = "Network", meta = (EditCondition = "bReplicates", ClampMin="1"))
+	int32 TransitionResetMinFrames;
 	
 	/**
 	 * When the instance is initially replicated this will load current active states instead of the initial state. It is likely these match.
@@ -310,6 +325,14 @@ protected:
 	UPROPERTY(Transient, ReplicatedUsing = REP_OnInstanceLoaded, meta=(DisplayName = Instance))
 	USMInstance* R_Instance;
 
+	/** USMInstance::GetNetworkNodeSignature of the server instance. Node indices are only valid when it matches the local instance. */
+	UPROPERTY(Transient, Replicated)
+	uint32 R_NetworkNodeSignature;
+
+	/** Set on the server when a client reported different network nodes. Transactions are then replicated with full guids. */
+	UPROPERTY(Transient)
+	bool bSendFullNetworkNodeGuids;
+
 	/** The template to use when initializing the state machine. Only valid within the CDO. */
 	UPROPERTY(VisibleDefaultsOnly, Instanced, DuplicateTransient, Category = "State Machine Components", meta = (DisplayName=Template, DisplayThumbnail=false))
 	USMInstance* InstanceTemplate;
@@ -0,0 +1,52 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "SMUpdateScheduler.generated.h"
+
+class USMInstance;
+
+/**
+ * Evaluates transitions of state machine instances which have bEvaluateTransitionsInParallel set across task graph worker threads.
+ * This runs each frame before actors tick. Instances then update normally on the game thread, where state logic runs and
+ * valid transitions are evaluated again before being taken.
+ */
+UCLASS()
+class SMSYSTEM_API USMUpdateScheduler : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// ~USubsystem
+
+	/** Evaluate transitions of this instance in parallel each frame while it is running. */
+	void RegisterInstance(USMInstance* Instance);
+
+	/** Stop evaluating transitions of this instance in parallel. */
+	void UnregisterInstance(USMInstance* Instance);
+
+	/** The number of instances currently registered. */
+	int32 GetNumRegisteredInstances() const { return RegisteredInstances.Num(); }
+	
+	/**
+	 * Evaluate transitions of all instances across worker threads. Blocks until every instance is evaluated.
+	 *
+	 * @param Instances Instances to evaluate. Only transitions which can evaluate on any thread are evaluated.
+	 * @param DeltaSeconds The time that will be passed to the next tick of each instance.
+	 */
+	static void PreEvaluateInstances(const TArray<USMInstance*>& Instances, float DeltaSeconds);
+
+private:
+	void OnWorldPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+	/** Instances which are running with bEvaluateTransitionsInParallel. */
+	TArray<TWeakObjectPtr<USMInstance>> RegisteredInstances;
+
+	/** Instances evaluated this frame. Kept between frames to avoid reallocating. */
+	TArray<USMInstance*> ScheduledInstances;
+
+	FDelegateHandle PreActorTickHandle;
+};
@@ -24,6 +24,19 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Logic Driver|State Machine Utilities")
 	static USMInstance* CreateStateMachineInstanceFromTemplate(TSubclassOf<class USMInstance> StateMachineClass, UObject* Context, USMInstance* Template);
 
+	/** Write snapshots of many initialized state machine instances into one buffer. See USMInstance::SaveSnapshot. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Utilities")
+	static void SaveStateMachineSnapshots(const TArray<USMInstance*>& Instances, TArray<uint8>& OutData);
+
+	/**
+	 * Restore and start many state machine instances from SaveStateMachineSnapshots. Instances must be initialized, not running,
+	 * of the same classes, and in the same order as when saved.
+	 * @param bRunStateBegin Run begin logic of the restored states.
+	 * @return The number of instances restored.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Utilities")
+	static int32 LoadStateMachineSnapshots(const TArray<USMInstance*>& Instances, const TArray<uint8>& Data, bool bRunStateBegin = true);
+
 private:
 	static USMInstance* CreateStateMachineInstanceInternal(TSubclassOf<class USMInstance> StateMachineClass, UObject* Context, USMInstance* Template);
 };
@@ -5,7 +5,10 @@
 #include "EdGraphUtilities.h"
 #include "ISMSystemEditorModule.h"
 #include "Utilities/SMBlueprintEditorUtils.h"
+#include "SMInstanceClassLayout.h"
+#include "SMInstanceSnapshot.h"
 #include "Kismet/KismetArrayLibrary.h"
+#include "Kismet/KismetMathLibrary.h"
 #include "Kismet2/KismetReinstanceUtilities.h"
 #include "Framework/Notifications/NotificationManager.h"
 #include "Widgets/Notifications/SNotificationList.h"
@@ -13,6 +16,7 @@
 #include "K2Node_VariableGet.h"
 #include "K2Node_StructMemberSet.h"
 #include "K2Node_StructMemberGet.h"
+#include "K2Node_CallFunction.h"
 #include "K2Node_CallArrayFunction.h"
 #include "K2Node_CreateDelegate.h"
 
@@ -425,6 +429,11 @@ void FSMKismetCompilerContext::PostCompile()
 {
 	Super::PostCompile();
 
+	// Instances of this class or its children must be generated from the new properties and bind the new functions.
+	FSMInstanceClassLayoutCache::Clear();
+	FSMExposedFunctionHandler::ClearCache();
+	FSMInstanceSnapshot::ClearCache();
+
 	if (USMGraph* Graph = FSMBlueprintEditorUtils::GetRootStateMachineGraph(Blueprint))
 	{
 		TArray<USMGraphK2Node_Base*> K2Nodes;
@@ -885,6 +894,11 @@ void FSMKismetCompilerContext::ProcessStateMachineGraph(USMGraph* StateMachineGr
 			EdgeNode->SetRuntimeDefaults(TransitionSourceGraph->ResultNode->TransitionNode);
 			TransitionSourceGraph->ResultNode->TransitionNode.SetOwnerNodeGuid(ThisStateMachinesGuid);
 
+			if (TransitionSourceGraph->ResultNode->TransitionNode.bEvaluateOnSignal)
+			{
+				ValidateSignalTransition(EdgeNode, StartNode, TransitionSourceGraph->ResultNode->TransitionNode);
+			}
+
 			// Link the transition to source nodes by guid. They will be resolved to pointers later.
 			{
 				UEdGraph* SourceStateGraph = Cast<UEdGraph>(StartNode->GetBoundGraph());
@@ -940,6 +954,30 @@ void FSMKismetCompilerContext::ProcessStateMachineGraph(USMGraph* StateMachineGr
 	}
 }
 
+void FSMKismetCompilerContext::ValidateSignalTransition(USMGraphNode_TransitionEdge* EdgeNode, USMGraphNode_StateNodeBase* StartNode, const FSMTransition& Transition)
+{
+	// Conduits evaluated with transitions never become active, so nothing could wake a transition leaving one.
+	if (USMGraphNode_ConduitNode* ConduitNode = Cast<USMGraphNode_ConduitNode>(StartNode))
+	{
+		if (ConduitNode->ShouldEvalWithTransitions())
+		{
+			MessageLog.Error(TEXT("State Machine Transition Node @@ evaluates on signal but starts from Conduit @@ which is evaluated with transitions. Disable Evaluate On Signal or configure the conduit as a state."),
+				EdgeNode, StartNode);
+		}
+	}
+
+	// Watched variables are read from this state machine at run-time.
+	for (const FName& PropertyName : Transition.SignalProperties)
+	{
+		const FProperty* Property = Blueprint->SkeletonGeneratedClass ? FindFProperty<FProperty>(Blueprint->SkeletonGeneratedClass, PropertyName) : nullptr;
+		if (!Property || Property->ArrayDim != 1)
+		{
+			MessageLog.Error(*FString::Printf(TEXT("State Machine Transition Node @@ watches variable '%s' which is not a member variable of the state machine."),
+				*PropertyName.ToString()), EdgeNode);
+		}
+	}
+}
+
 void FSMKismetCompilerContext::ProcessRuntimeContainers()
 {
 	TArray<USMGraphK2Node_RuntimeNodeContainer*> RuntimeContainerNodeList;
@@ -1325,6 +1363,9 @@ UK2Node_CustomEvent* FSMKismetCompilerContext::SetupTransitionEntry(USMGraphK2No
 	// The exec (then) pin of the new event node.
 	UEdGraphPin* EntryNodeOutPin = Schema->FindExecutionPin(*EntryEventNode, EGPD_Output);
 
+	// Must run before the result pin is moved to the setter.
+	SetupFastPathEvaluation(ContainerNode, BaseNode->GraphEvaluator);
+	
 	// Create a variable assign node to record the result of the boolean operation.
 	UK2Node_StructMemberSet* VarSetNode = CreateSetter(ContainerNode, Property->GetFName(), ContainerNode->GetRunTimeNodeType());
 
@@ -1335,6 +1376,109 @@ UK2Node_CustomEvent* FSMKismetCompilerContext::SetupTransitionEntry(USMGraphK2No
 	return EntryEventNode;
 }
 
+void FSMKismetCompilerContext::SetupFastPathEvaluation(USMGraphK2Node_RuntimeNodeContainer* ContainerNode, FSMExposedFunctionHandler& FunctionHandler)
+{
+	FunctionHandler.FastPath = ESMExposedFunctionFastPath::None;
+	FunctionHandler.FastPathPropertyName = NAME_None;
+	FunctionHandler.FastPathConstant.Empty();
+
+	UEdGraphPin* ResultPin = ContainerNode->GetInputPin();
+	if (!ResultPin || ResultPin->LinkedTo.Num() != 1)
+	{
+		return;
+	}
+
+	// A pure getter of a member variable on this blueprint. Variables with a getter function are excluded since the graph calls the getter instead of reading the property.
+	auto GetMemberVariableName = [](UEdGraphPin* Pin) -> FName
+	{
+		UK2Node_VariableGet* VariableGetNode = Pin ? Cast<UK2Node_VariableGet>(Pin->GetOwningNode()) : nullptr;
+		if (VariableGetNode && VariableGetNode->IsNodePure() && VariableGetNode->VariableReference.IsSelfContext() && !VariableGetNode->VariableReference.IsLocalScope())
+		{
+			const FProperty* Property = VariableGetNode->GetPropertyForVariable();
+			if (!Property || Property->HasMetaData(FBlueprintMetadata::MD_PropertyGetFunction))
+			{
+				return NAME_None;
+			}
+			
+			return VariableGetNode->GetVarName();
+		}
+
+		return NAME_None;
+	};
+
+	UEdGraphPin* LinkedPin = ResultPin->LinkedTo[0];
+	
+	// Result = bVariable
+	const FName BoolVariableName = GetMemberVariableName(LinkedPin);
+	if (BoolVariableName != NAME_None)
+	{
+		FunctionHandler.FastPath = ESMExposedFunctionFastPath::ReadBool;
+		FunctionHandler.FastPathPropertyName = BoolVariableName;
+		return;
+	}
+
+	// Result = Variable (op) Constant
+	UK2Node_CallFunction* CompareNode = Cast<UK2Node_CallFunction>(LinkedPin->GetOwningNode());
+	UFunction* CompareFunction = CompareNode ? CompareNode->GetTargetFunction() : nullptr;
+	if (!CompareFunction || !CompareNode->IsNodePure() || CompareFunction->GetOwnerClass() != UKismetMathLibrary::StaticClass())
+	{
+		return;
+	}
+
+	FString Operation;
+	FString Types;
+	if (!CompareFunction->GetName().Split(TEXT("_"), &Operation, &Types))
+	{
+		return;
+	}
+
+	static const TSet<FString> SupportedTypes = { TEXT("BoolBool"), TEXT("ByteByte"), TEXT("IntInt"), TEXT("Int64Int64"), TEXT("FloatFloat") };
+	if (!SupportedTypes.Contains(Types))
+	{
+		return;
+	}
+
+	static const TMap<FString, TPair<ESMExposedFunctionFastPath, ESMExposedFunctionFastPath>> SupportedOperations =
+	{
+		// The operation when the variable is the first argument, then when it's the second.
+		{ TEXT("EqualEqual"), { ESMExposedFunctionFastPath::Equal, ESMExposedFunctionFastPath::Equal } },
+		{ TEXT("NotEqual"), { ESMExposedFunctionFastPath::NotEqual, ESMExposedFunctionFastPath::NotEqual } },
+		{ TEXT("Less"), { ESMExposedFunctionFastPath::Less, ESMExposedFunctionFastPath::Greater } },
+		{ TEXT("LessEqual"), { ESMExposedFunctionFastPath::LessEqual, ESMExposedFunctionFastPath::GreaterEqual } },
+		{ TEXT("Greater"), { ESMExposedFunctionFastPath::Greater, ESMExposedFunctionFastPath::Less } },
+		{ TEXT("GreaterEqual"), { ESMExposedFunctionFastPath::GreaterEqual, ESMExposedFunctionFastPath::LessEqual } }
+	};
+	
+	const TPair<ESMExposedFunctionFastPath, ESMExposedFunctionFastPath>* FastPathOperations = SupportedOperations.Find(Operation);
+	UEdGraphPin* PinA = CompareNode->FindPin(TEXT("A"), EGPD_Input);
+	UEdGraphPin* PinB = CompareNode->FindPin(TEXT("B"), EGPD_Input);
+	if (!FastPathOperations || !PinA || !PinB)
+	{
+		return;
+	}
+
+	// One argument must be the variable and the other a constant.
+	const bool bVariableIsA = PinB->LinkedTo.Num() == 0 && PinA->LinkedTo.Num() == 1;
+	const bool bVariableIsB = PinA->LinkedTo.Num() == 0 && PinB->LinkedTo.Num() == 1;
+	if (!bVariableIsA && !bVariableIsB)
+	{
+		return;
+	}
+
+	UEdGraphPin* VariablePin = bVariableIsA ? PinA : PinB;
+	UEdGraphPin* ConstantPin = bVariableIsA ? PinB : PinA;
+	
+	const FName VariableName = GetMemberVariableName(VariablePin->LinkedTo[0]);
+	if (VariableName == NAME_None)
+	{
+		return;
+	}
+
+	FunctionHandler.FastPath = bVariableIsA ? FastPathOperations->Key : FastPathOperations->Value;
+	FunctionHandler.FastPathPropertyName = VariableName;
+	FunctionHandler.FastPathConstant = ConstantPin->GetDefaultAsString();
+}
+
 USMGraphK2Node_StateMachineEntryNode* FSMKismetCompilerContext::ProcessNestedStateMachineNode(USMGraphNode_StateMachineStateNode* StateMachineStateNode)
 {
 	// Find the owning state machine node.
@@ -20,6 +20,9 @@ class USMGraphK2Node_RuntimeNodeContainer;
 class USMGraphK2Node_RootNode;
 class USMGraphK2Node_StateMachineNode;
 class USMGraphK2Node_StateMachineEntryNode;
+class USMGraphNode_TransitionEdge;
+class USMGraphNode_StateNodeBase;
+struct FSMTransition;
 
 
 struct FTemplateContainer
@@ -98,6 +101,9 @@ protected:
 	/** Create runtime properties from a state machine graph. */
 	void ProcessStateMachineGraph(USMGraph* StateMachineGraph);
 
+	/** Report transitions which evaluate on signal but can never be signaled or watch variables which don't exist. */
+	void ValidateSignalTransition(USMGraphNode_TransitionEdge* EdgeNode, USMGraphNode_StateNodeBase* StartNode, const FSMTransition& Transition);
+
 	/** Run through the ConsolidatedGraph and create properties for runtime nodes and entry points. */
 	void ProcessRuntimeContainers();
 
@@ -122,6 +128,9 @@ public:
 
 	/** Creates and wires an entry point and runtime function. */
 	UK2Node_CustomEvent* SetupTransitionEntry(USMGraphK2Node_RuntimeNodeContainer* ContainerNode, FStructProperty* Property);
+
+	/** Let the function handler skip the graph at run-time when the result is a member variable or a member variable compared against a constant. */
+	void SetupFastPathEvaluation(USMGraphK2Node_RuntimeNodeContainer* ContainerNode, struct FSMExposedFunctionHandler& FunctionHandler);
 	
 	/** Creates proper k2 node representing a state machine entry point. */
 	USMGraphK2Node_StateMachineEntryNode* ProcessNestedStateMachineNode(USMGraphNode_StateMachineStateNode* StateMachineStateNode);
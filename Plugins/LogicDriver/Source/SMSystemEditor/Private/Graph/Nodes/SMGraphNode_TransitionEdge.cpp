@@ -40,6 +40,9 @@ void USMGraphNode_TransitionEdge::SetRuntimeDefaults(FSMTransition& Transition)
 		Transition.bCanEvalWithStartState = Instance->bCanEvalWithStartState;
 		Transition.bRunParallel = Instance->bRunParallel;
 		Transition.bEvalIfNextStateActive = Instance->bEvalIfNextStateActive;
+		Transition.bEvaluateOnSignal = Instance->bEvaluateOnSignal;
+		Transition.SignalEvents = Instance->SignalEvents;
+		Transition.SignalProperties = Instance->SignalProperties;
 		Transition.SetNodeName(GetTransitionName());
 	}
 }
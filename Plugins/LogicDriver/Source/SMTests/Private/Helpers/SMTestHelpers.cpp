@@ -187,6 +187,101 @@ bool FAssetHandler::UnloadAsset(FAutomationTestBase* Test)
 	return bResult;
 }
 
+FSMAllocationCounter& FSMAllocationCounter::Get()
+{
+	// Intentionally leaked so the allocator stays valid for any thread still holding it.
+	static FSMAllocationCounter* Counter = new FSMAllocationCounter();
+	return *Counter;
+}
+
+FSMAllocationCounter::FSMAllocationCounter() : InnerMalloc(nullptr), CountingThreadId(0), NumAllocations(0), bCounting(false)
+{
+}
+
+void FSMAllocationCounter::Begin()
+{
+	check(IsInGameThread());
+	check(!bCounting);
+
+	InnerMalloc = GMalloc;
+	CountingThreadId = FPlatformTLS::GetCurrentThreadId();
+	NumAllocations = 0;
+	bCounting = true;
+	GMalloc = this;
+}
+
+int32 FSMAllocationCounter::End()
+{
+	check(bCounting);
+
+	bCounting = false;
+	GMalloc = InnerMalloc;
+	return NumAllocations;
+}
+
+void* FSMAllocationCounter::Malloc(SIZE_T Count, uint32 Alignment)
+{
+	if (bCounting && FPlatformTLS::GetCurrentThreadId() == CountingThreadId)
+	{
+		NumAllocations++;
+	}
+	return InnerMalloc->Malloc(Count, Alignment);
+}
+
+void* FSMAllocationCounter::Realloc(void* Original, SIZE_T Count, uint32 Alignment)
+{
+	if (bCounting && Count > 0 && FPlatformTLS::GetCurrentThreadId() == CountingThreadId)
+	{
+		NumAllocations++;
+	}
+	return InnerMalloc->Realloc(Original, Count, Alignment);
+}
+
+void FSMAllocationCounter::Free(void* Original)
+{
+	InnerMalloc->Free(Original);
+}
+
+bool FSMAllocationCounter::GetAllocationSize(void* Original, SIZE_T& SizeOut)
+{
+	return InnerMalloc->GetAllocationSize(Original, SizeOut);
+}
+
+SIZE_T FSMAllocationCounter::QuantizeSize(SIZE_T Count, uint32 Alignment)
+{
+	return InnerMalloc->QuantizeSize(Count, Alignment);
+}
+
+void FSMAllocationCounter::Trim(bool bTrimThreadCaches)
+{
+	InnerMalloc->Trim(bTrimThreadCaches);
+}
+
+void FSMAllocationCounter::SetupTLSCachesOnCurrentThread()
+{
+	InnerMalloc->SetupTLSCachesOnCurrentThread();
+}
+
+void FSMAllocationCounter::ClearAndDisableTLSCachesOnCurrentThread()
+{
+	InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread();
+}
+
+bool FSMAllocationCounter::IsInternallyThreadSafe() const
+{
+	return InnerMalloc->IsInternallyThreadSafe();
+}
+
+bool FSMAllocationCounter::ValidateHeap()
+{
+	return InnerMalloc->ValidateHeap();
+}
+
+const TCHAR* FSMAllocationCounter::GetDescriptiveName()
+{
+	return TEXT("SMAllocationCounter");
+}
+
 void FAssetHandler::ValidateDirectory()
 {
 	FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry"));
@@ -0,0 +1,129 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#include "Blueprints/SMBlueprint.h"
+#include "SMTestHelpers.h"
+#include "SMTestContext.h"
+#include "Utilities/SMBlueprintEditorUtils.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "Graph/SMGraph.h"
+#include "Graph/Nodes/SMGraphK2Node_StateMachineNode.h"
+#include "Engine/NetSerialization.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#if PLATFORM_DESKTOP
+
+/**
+ * Write and read networked transactions with both node indices and full guids.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNetworkedTransactionSerializationTest, "SMTests.NetworkedTransactionSerialization", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FNetworkedTransactionSerializationTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+
+	// Find root state machine.
+	USMGraphK2Node_StateMachineNode* RootStateMachineNode = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP);
+
+	// Find the state machine graph.
+	USMGraph* StateMachineGraph = RootStateMachineNode->GetStateMachineGraph();
+
+	// Total states to test.
+	const int32 TotalStates = 5;
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, TotalStates, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* ServerInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+	USMInstance* ClientInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+
+	const FGuid& StateMachineGuid = ServerInstance->GetRootStateMachine().GetGuid();
+	TArray<FGuid> TransitionGuids;
+	ServerInstance->GetTransitionMap().GenerateKeyArray(TransitionGuids);
+	if (!TestEqual("Transitions mapped", TransitionGuids.Num(), TotalStates - 1))
+	{
+		return false;
+	}
+
+	auto WriteAndRead = [this](FSMNetworkedTransaction& Transaction, FSMNetworkedTransaction& OutTransaction) -> int64
+	{
+		FNetBitWriter Writer(nullptr, 1024);
+		bool bSuccess = false;
+		Transaction.NetSerialize(Writer, nullptr, bSuccess);
+		TestTrue("Transaction written", bSuccess);
+
+		FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+		bSuccess = false;
+		OutTransaction.NetSerialize(Reader, nullptr, bSuccess);
+		TestTrue("Transaction read", bSuccess);
+		TestFalse("Reader not overflowed", Reader.IsError());
+
+		return Writer.GetNumBits();
+	};
+
+	for (const FGuid& TransitionGuid : TransitionGuids)
+	{
+		FSMNetworkedTransaction Transaction(StateMachineGuid, TransitionGuid);
+		Transaction.Frame = GFrameCounter;
+
+		// Full guids.
+		{
+			FSMNetworkedTransaction ReadTransaction;
+			const int64 NumBits = WriteAndRead(Transaction, ReadTransaction);
+
+			TestEqual("State machine guid read", ReadTransaction.StateMachineGuid, StateMachineGuid);
+			TestEqual("Base guid read", ReadTransaction.BaseGuid, TransitionGuid);
+			TestEqual("Transaction guid read", ReadTransaction.TransactionGuid, Transaction.TransactionGuid);
+			TestTrue("Transaction type read", ReadTransaction.IsTransition());
+			TestTrue("Full guid transaction resolved", ReadTransaction.ResolveNodeGuids(ClientInstance));
+			TestTrue("Full guid transaction size", NumBits <= (sizeof(FGuid) * 3 + 5) * 8);
+		}
+
+		// Node indices.
+		{
+			Transaction.AssignNodeIndices(ServerInstance);
+			TestNotEqual("State machine index assigned", Transaction.StateMachineIndex, INDEX_NONE);
+			TestNotEqual("Base index assigned", Transaction.BaseIndex, INDEX_NONE);
+
+			FSMNetworkedTransaction ReadTransaction;
+			const int64 NumBits = WriteAndRead(Transaction, ReadTransaction);
+
+			TestEqual("State machine index read", ReadTransaction.StateMachineIndex, Transaction.StateMachineIndex);
+			TestEqual("Base index read", ReadTransaction.BaseIndex, Transaction.BaseIndex);
+			TestEqual("Transaction guid read", ReadTransaction.TransactionGuid, Transaction.TransactionGuid);
+			TestTrue("Indexed transaction resolved", ReadTransaction.ResolveNodeGuids(ClientInstance));
+			TestEqual("State machine guid resolved", ReadTransaction.StateMachineGuid, StateMachineGuid);
+			TestEqual("Base guid resolved", ReadTransaction.BaseGuid, TransitionGuid);
+
+			// The header bits, two small packed indices, the transaction guid, and the frame delta.
+			TestTrue("Indexed transaction size", NumBits <= 3 + 8 * 2 + sizeof(FGuid) * 8 + 8);
+			AddInfo(FString::Printf(TEXT("Networked transaction size: %.2f bytes."), NumBits / 8.f));
+		}
+	}
+
+	// Indices outside of the node map should fail to resolve.
+	{
+		FSMNetworkedTransaction Transaction;
+		Transaction.StateMachineIndex = ServerInstance->GetNodeMap().Num();
+		Transaction.BaseIndex = 0;
+		TestFalse("Invalid index not resolved", Transaction.ResolveNodeGuids(ClientInstance));
+	}
+
+	ServerInstance->Shutdown();
+	ClientInstance->Shutdown();
+
+	return NewAsset.DeleteAsset(this);
+}
+
+#endif
+
+#endif
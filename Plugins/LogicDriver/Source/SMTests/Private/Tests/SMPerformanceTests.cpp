@@ -0,0 +1,413 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#include "Blueprints/SMBlueprint.h"
+#include "SMTestHelpers.h"
+#include "SMTestContext.h"
+#include "SMInstanceClassLayout.h"
+#include "SMInstancePool.h"
+#include "Utilities/SMBlueprintEditorUtils.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "Graph/SMGraph.h"
+#include "Graph/Nodes/SMGraphK2Node_StateMachineNode.h"
+#include "Graph/Nodes/SMGraphNode_StateMachineStateNode.h"
+#include "Graph/Nodes/SMGraphNode_TransitionEdge.h"
+#include "Graph/Nodes/SMGraphNode_StateNode.h"
+#include "Graph/SMTransitionGraph.h"
+#include "Graph/Nodes/RootNodes/SMGraphK2Node_TransitionResultNode.h"
+#include "Kismet/KismetMathLibrary.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#if PLATFORM_DESKTOP
+
+/**
+ * Update a state machine which isn't transitioning and check no heap allocations are made.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FUpdateAllocationsTest, "SMTests.Performance.UpdateAllocations", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FUpdateAllocationsTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+
+	// Find root state machine.
+	USMGraphK2Node_StateMachineNode* RootStateMachineNode = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP);
+
+	// Find the state machine graph.
+	USMGraph* StateMachineGraph = RootStateMachineNode->GetStateMachineGraph();
+
+	// Total states to test.
+	const int32 TotalStates = 3;
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, TotalStates, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+
+	// Evaluate transitions every update without taking them.
+	Context->bCanTransition = false;
+	Instance->Start();
+
+	const FGuid StartingState = Instance->GetSingleActiveStateGuid();
+	
+	// Let any containers used by the update reach their working size.
+	const float DeltaTime = 1.f;
+	const int32 WarmUpIterations = 5;
+	for (int32 Idx = 0; Idx < WarmUpIterations; ++Idx)
+	{
+		Instance->Update(DeltaTime);
+	}
+
+	const int32 UpdateHitsBefore = Context->GetUpdateInt();
+	
+	const int32 TotalIterations = 1000;
+	const double StartTime = FPlatformTime::Seconds();
+	FSMAllocationCounter::Get().Begin();
+	for (int32 Idx = 0; Idx < TotalIterations; ++Idx)
+	{
+		Instance->Update(DeltaTime);
+	}
+	const int32 TotalAllocations = FSMAllocationCounter::Get().End();
+	const double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("%d updates in %.3f ms with %d allocations."), TotalIterations, ElapsedTime * 1000.0, TotalAllocations));
+	
+	TestEqual("State machine didn't transition", Instance->GetSingleActiveStateGuid(), StartingState);
+	TestTrue("State machine updated", Context->GetUpdateInt() > UpdateHitsBefore);
+	TestEqual("No heap allocations made while updating", TotalAllocations, 0);
+
+	Instance->Shutdown();
+	
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Initialize many instances of one class with and without the class layout cache, then recycle instances through a pool.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInitializeClassLayoutCacheTest, "SMTests.Performance.InitializeClassLayoutCache", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FInitializeClassLayoutCacheTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+
+	// Find root state machine.
+	USMGraphK2Node_StateMachineNode* RootStateMachineNode = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP);
+
+	// Find the state machine graph.
+	USMGraph* StateMachineGraph = RootStateMachineNode->GetStateMachineGraph();
+
+	// A -> B -> [A -> B -> C] -> C
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 2, &LastStatePin);
+	USMGraphNode_StateMachineStateNode* NestedFSM = TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, 3, &LastStatePin, nullptr);
+	LastStatePin = NestedFSM->GetOutputPin();
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+
+	// Variable to check pooled instances are reset.
+	const FName PooledVarName = "PooledValue";
+	FEdGraphPinType PooledVarType;
+	PooledVarType.PinCategory = UEdGraphSchema_K2::PC_Int;
+	FBlueprintEditorUtils::AddMemberVariable(NewBP, PooledVarName, PooledVarType, "5");
+	
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	const int32 TotalInstances = 250;
+	const bool bWasEnabled = FSMInstanceClassLayoutCache::IsEnabled();
+
+	auto InitializeInstances = [&](bool bUseCache, TArray<USMInstance*>& InstancesOut)
+	{
+		FSMInstanceClassLayoutCache::SetEnabled(false);
+		FSMInstanceClassLayoutCache::SetEnabled(bUseCache);
+
+		USMTestContext* Context = NewObject<USMTestContext>();
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Idx = 0; Idx < TotalInstances; ++Idx)
+		{
+			InstancesOut.Add(USMBlueprintUtils::CreateStateMachineInstance(NewBP->GetGeneratedClass(), Context));
+		}
+		return FPlatformTime::Seconds() - StartTime;
+	};
+
+	TArray<USMInstance*> GeneratedInstances;
+	const double GeneratedTime = InitializeInstances(false, GeneratedInstances);
+	
+	TArray<USMInstance*> CachedInstances;
+	const double CachedTime = InitializeInstances(true, CachedInstances);
+
+	AddInfo(FString::Printf(TEXT("Initialized %d instances in %.3f ms without the class layout cache and %.3f ms with it."), TotalInstances, GeneratedTime * 1000.0, CachedTime * 1000.0));
+
+	// Cached instances should be identical to generated instances.
+	USMInstance* GeneratedInstance = GeneratedInstances.Last();
+	USMInstance* CachedInstance = CachedInstances.Last();
+	TestTrue("Cached instance initialized", CachedInstance->IsInitialized());
+	TestEqual("Node map matches", CachedInstance->GetNodeMap().Num(), GeneratedInstance->GetNodeMap().Num());
+	TestEqual("State map matches", CachedInstance->GetStateMap().Num(), GeneratedInstance->GetStateMap().Num());
+	TestEqual("Transition map matches", CachedInstance->GetTransitionMap().Num(), GeneratedInstance->GetTransitionMap().Num());
+	for (const auto& KeyVal : GeneratedInstance->GetNodeMap())
+	{
+		const FSMNode_Base* CachedNode = CachedInstance->GetNodeMap().FindRef(KeyVal.Key);
+		TestNotNull("Cached instance contains node path guid", CachedNode);
+		if (!CachedNode)
+		{
+			continue;
+		}
+
+		TestEqual("Node guid matches", CachedNode->GetNodeGuid(), KeyVal.Value->GetNodeGuid());
+		TestEqual("Owner matches", CachedNode->GetOwnerNode() ? CachedNode->GetOwnerNode()->GetGuid() : FGuid(),
+			KeyVal.Value->GetOwnerNode() ? KeyVal.Value->GetOwnerNode()->GetGuid() : FGuid());
+	}
+
+	// Both should run the same way.
+	auto RunToCompletion = [&](USMInstance* Instance)
+	{
+		USMTestContext* Context = NewObject<USMTestContext>();
+		Instance->Initialize(Context);
+		Instance->Start();
+		int32 Iterations = 0;
+		while (!Instance->IsInEndState() && Iterations++ < 100)
+		{
+			Instance->Update(1.f);
+		}
+		TestTrue("State machine reached end state", Instance->IsInEndState());
+		Instance->Shutdown();
+		return FIntVector(Context->GetEntryInt(), Context->GetUpdateInt(), Context->GetEndInt());
+	};
+	
+	FSMInstanceClassLayoutCache::SetEnabled(false);
+	const FIntVector GeneratedResults = RunToCompletion(GeneratedInstance);
+	FSMInstanceClassLayoutCache::SetEnabled(true);
+	RunToCompletion(GeneratedInstance);
+	const FIntVector CachedResults = RunToCompletion(CachedInstance);
+	TestEqual("Cached instance ran the same as the generated instance", CachedResults, GeneratedResults);
+
+	// Recycle through a pool.
+	{
+		USMInstancePool* Pool = NewObject<USMInstancePool>();
+		USMTestContext* Context = NewObject<USMTestContext>();
+		
+		USMInstance* PooledInstance = Pool->AcquireInstance(NewBP->GetGeneratedClass(), Context);
+		TestNotNull("Instance acquired", PooledInstance);
+		if (PooledInstance)
+		{
+			TestEqual("Instance owned by pool", PooledInstance->GetOwningPool(), Pool);
+
+			FIntProperty* PooledProperty = FindFProperty<FIntProperty>(PooledInstance->GetClass(), PooledVarName);
+			check(PooledProperty);
+			PooledProperty->SetPropertyValue_InContainer(PooledInstance, 10);
+			
+			PooledInstance->Start();
+			PooledInstance->Shutdown();
+			TestEqual("Instance returned to pool on shutdown", Pool->GetNumPooledInstances(NewBP->GetGeneratedClass()), 1);
+			TestNull("Context released", PooledInstance->GetContext());
+
+			USMTestContext* NewContext = NewObject<USMTestContext>();
+			USMInstance* ReusedInstance = Pool->AcquireInstance(NewBP->GetGeneratedClass(), NewContext);
+			TestEqual("Pooled instance reused", ReusedInstance, PooledInstance);
+			TestEqual("Pool emptied", Pool->GetNumPooledInstances(NewBP->GetGeneratedClass()), 0);
+			TestTrue("Reused instance initialized", ReusedInstance->IsInitialized());
+			TestEqual("Reused instance has new context", ReusedInstance->GetContext(), (UObject*)NewContext);
+			TestEqual("Reused instance outered to new context", ReusedInstance->GetOuter(), (UObject*)NewContext);
+			TestEqual("Reused instance variable reset to default", PooledProperty->GetPropertyValue_InContainer(ReusedInstance), 5);
+
+			// Initializing an instance in use must not return it to the pool.
+			ReusedInstance->Initialize(NewContext);
+			TestEqual("Reinitialized instance not returned to pool", Pool->GetNumPooledInstances(NewBP->GetGeneratedClass()), 0);
+			TestEqual("Reinitialized instance still owned by pool", ReusedInstance->GetOwningPool(), Pool);
+			TestEqual("Reinitialized instance keeps context", ReusedInstance->GetContext(), (UObject*)NewContext);
+
+			ReusedInstance->SetOwningPool(nullptr);
+			ReusedInstance->Shutdown();
+		}
+	}
+	
+	FSMInstanceClassLayoutCache::SetEnabled(bWasEnabled);
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Evaluate transitions which only read a variable or compare it to a constant with and without the graph evaluation fast path.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTransitionFastPathTest, "SMTests.Performance.TransitionFastPath", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FTransitionFastPathTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+
+	// Find root state machine.
+	USMGraphK2Node_StateMachineNode* RootStateMachineNode = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP);
+
+	// Find the state machine graph.
+	USMGraph* StateMachineGraph = RootStateMachineNode->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 2, &LastStatePin);
+
+	USMGraphNode_TransitionEdge* TransitionEdge =
+		CastChecked<USMGraphNode_TransitionEdge>(Cast<USMGraphNode_StateNode>(LastStatePin->GetOwningNode())->GetInputPin()->LinkedTo[0]->GetOwningNode());
+	USMTransitionGraph* TransitionGraph = TransitionEdge->GetTransitionGraph();
+
+	const bool bWasEnabled = FSMExposedFunctionHandler::IsFastPathEnabled();
+	const int32 TotalIterations = 10000;
+
+	/*
+	 * Compile and check the transition uses the expected fast path. Then evaluate it with the fast path enabled and disabled,
+	 * setting the variable to each value so both paths are compared against each other.
+	 */
+	auto BenchmarkTransition = [&](const FString& Description, ESMExposedFunctionFastPath ExpectedFastPath, const FName& VarName,
+		const TArray<FString>& VarValues)
+	{
+		FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+		USMTestContext* Context = NewObject<USMTestContext>();
+		USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+
+		TArray<FSMTransition*> Transitions;
+		Instance->GetTransitionMap().GenerateValueArray(Transitions);
+		if (!TestEqual("One transition", Transitions.Num(), 1))
+		{
+			return;
+		}
+		
+		FSMTransition* Transition = Transitions[0];
+		TestEqual("Fast path recognized by the compiler", Transition->GraphEvaluator.FastPath, ExpectedFastPath);
+
+		FProperty* Property = FindFProperty<FProperty>(Instance->GetClass(), VarName);
+		TestNotNull("Variable found", Property);
+		if (!Property)
+		{
+			return;
+		}
+
+		double FastPathTime = 0.0;
+		double GraphTime = 0.0;
+		for (const FString& VarValue : VarValues)
+		{
+			Property->ImportText(*VarValue, Property->ContainerPtrToValuePtr<void>(Instance), PPF_None, Instance);
+
+			auto EvaluateTransition = [&](bool bUseFastPath, double& TimeOut)
+			{
+				FSMExposedFunctionHandler::SetFastPathEnabled(bUseFastPath);
+				
+				bool bResult = false;
+				const double StartTime = FPlatformTime::Seconds();
+				for (int32 Idx = 0; Idx < TotalIterations; ++Idx)
+				{
+					bResult = Transition->DoesTransitionPass();
+				}
+				TimeOut += FPlatformTime::Seconds() - StartTime;
+				
+				return bResult;
+			};
+
+			const bool bFastPathResult = EvaluateTransition(true, FastPathTime);
+			const bool bGraphResult = EvaluateTransition(false, GraphTime);
+			TestEqual(FString::Printf(TEXT("%s fast path matches graph when %s is %s"), *Description, *VarName.ToString(), *VarValue), bFastPathResult, bGraphResult);
+		}
+
+		const int32 TotalEvaluations = TotalIterations * VarValues.Num();
+		AddInfo(FString::Printf(TEXT("%s: %.0f transitions per second evaluating the graph and %.0f with the fast path."), *Description,
+			TotalEvaluations / FMath::Max(GraphTime, SMALL_NUMBER), TotalEvaluations / FMath::Max(FastPathTime, SMALL_NUMBER)));
+
+		Instance->Shutdown();
+	};
+
+	// Result = bool variable
+	{
+		const FName VarName = "bFastPathCondition";
+		FEdGraphPinType VarType;
+		VarType.PinCategory = UEdGraphSchema_K2::PC_Boolean;
+		FBlueprintEditorUtils::AddMemberVariable(NewBP, VarName, VarType, "False");
+
+		FProperty* NewProperty = FSMBlueprintEditorUtils::GetPropertyForVariable(NewBP, VarName);
+		
+		TransitionGraph->ResultNode->BreakAllNodeLinks();
+		FSMBlueprintEditorUtils::PlacePropertyOnGraph(TransitionGraph, NewProperty, TransitionGraph->ResultNode->GetTransitionEvaluationPin(), nullptr);
+
+		BenchmarkTransition(TEXT("Read bool"), ESMExposedFunctionFastPath::ReadBool, VarName, { TEXT("False"), TEXT("True") });
+	}
+
+	// Result = int variable > constant
+	{
+		const FName VarName = "FastPathCount";
+		FEdGraphPinType VarType;
+		VarType.PinCategory = UEdGraphSchema_K2::PC_Int;
+		FBlueprintEditorUtils::AddMemberVariable(NewBP, VarName, VarType, "0");
+
+		FProperty* NewProperty = FSMBlueprintEditorUtils::GetPropertyForVariable(NewBP, VarName);
+
+		TransitionGraph->ResultNode->BreakAllNodeLinks();
+
+		UEdGraphNode* CompareNode = nullptr;
+		UFunction* CompareFunction = UKismetMathLibrary::StaticClass()->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(UKismetMathLibrary, Greater_IntInt));
+		TestTrue("Comparison placed", FSMBlueprintEditorUtils::PlaceFunctionOnGraph(TransitionGraph, CompareFunction,
+			TransitionGraph->ResultNode->GetTransitionEvaluationPin(), &CompareNode, nullptr));
+		TestNotNull("Comparison node created", CompareNode);
+		if (!CompareNode)
+		{
+			return false;
+		}
+		
+		FSMBlueprintEditorUtils::PlacePropertyOnGraph(TransitionGraph, NewProperty, CompareNode->FindPin(TEXT("A"), EGPD_Input), nullptr);
+		TransitionGraph->GetSchema()->TrySetDefaultValue(*CompareNode->FindPin(TEXT("B"), EGPD_Input), TEXT("5"));
+		
+		BenchmarkTransition(TEXT("Int greater than constant"), ESMExposedFunctionFastPath::Greater, VarName, { TEXT("0"), TEXT("5"), TEXT("10") });
+	}
+
+	// Result = float variable <= constant. The constant isn't exactly representable so it must be compared at float precision.
+	{
+		const FName VarName = "FastPathValue";
+		FEdGraphPinType VarType;
+		VarType.PinCategory = UEdGraphSchema_K2::PC_Float;
+		FBlueprintEditorUtils::AddMemberVariable(NewBP, VarName, VarType, "0.0");
+
+		FProperty* NewProperty = FSMBlueprintEditorUtils::GetPropertyForVariable(NewBP, VarName);
+
+		TransitionGraph->ResultNode->BreakAllNodeLinks();
+
+		UEdGraphNode* CompareNode = nullptr;
+		UFunction* CompareFunction = UKismetMathLibrary::StaticClass()->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(UKismetMathLibrary, LessEqual_FloatFloat));
+		TestTrue("Comparison placed", FSMBlueprintEditorUtils::PlaceFunctionOnGraph(TransitionGraph, CompareFunction,
+			TransitionGraph->ResultNode->GetTransitionEvaluationPin(), &CompareNode, nullptr));
+		TestNotNull("Comparison node created", CompareNode);
+		if (!CompareNode)
+		{
+			return false;
+		}
+		
+		FSMBlueprintEditorUtils::PlacePropertyOnGraph(TransitionGraph, NewProperty, CompareNode->FindPin(TEXT("A"), EGPD_Input), nullptr);
+		TransitionGraph->GetSchema()->TrySetDefaultValue(*CompareNode->FindPin(TEXT("B"), EGPD_Input), TEXT("0.1"));
+		
+		BenchmarkTransition(TEXT("Float less than or equal to constant"), ESMExposedFunctionFastPath::LessEqual, VarName, { TEXT("0.0"), TEXT("0.1"), TEXT("0.2") });
+	}
+
+	FSMExposedFunctionHandler::SetFastPathEnabled(bWasEnabled);
+	
+	return NewAsset.DeleteAsset(this);
+}
+
+#endif
+
+#endif
@@ -14,6 +14,10 @@
 #include "Graph/Nodes/SMGraphNode_StateMachineStateNode.h"
 #include "Graph/Nodes/SMGraphNode_ConduitNode.h"
 #include "Graph/Nodes/Helpers/SMGraphK2Node_StateReadNodes.h"
+#include "SMInstanceSnapshot.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "SMUtils.h"
 
 
 #if WITH_DEV_AUTOMATION_TESTS
@@ -529,6 +533,256 @@ IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSaveStateMachineStateWithIntermediateReference
 		TestSaveStateMachineState(this, bUseReferences, true, true, true);
 }
 
+/**
+ * Save and restore binary snapshots of a hierarchical state machine including SaveGame node instance variables.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSaveStateMachineSnapshotTest, "SMTests.SaveRestoreStateMachineSnapshot", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FSaveStateMachineSnapshotTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+
+	// Find root state machine.
+	USMGraphK2Node_StateMachineNode* RootStateMachineNode = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP);
+
+	// Find the state machine graph.
+	USMGraph* StateMachineGraph = RootStateMachineNode->GetStateMachineGraph();
+
+	// Linear states, a nested state machine, and a final state.
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 2, &LastStatePin, USMStateSnapshotTestInstance::StaticClass());
+	TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, 3, &LastStatePin, nullptr);
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin, USMStateSnapshotTestInstance::StaticClass());
+
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+
+	Instance->Start();
+
+	// Run until the nested state machine is active.
+	for (int32 Idx = 0; Idx < 10 && Instance->GetAllActiveStateGuidsCopy().Num() < 2; ++Idx)
+	{
+		Instance->Update(1.f);
+	}
+	Instance->Update(0.5f);
+
+	TArray<FGuid> ActiveGuids = Instance->GetAllActiveStateGuidsCopy();
+	TestEqual("Nested state machine and its state active", ActiveGuids.Num(), 2);
+
+	FSMState_Base* NestedActiveState = Instance->GetSingleNestedActiveState();
+	if (!TestNotNull("Nested active state found", NestedActiveState))
+	{
+		return NewAsset.DeleteAsset(this);
+	}
+
+	const float TimeInState = NestedActiveState->GetActiveTime();
+
+	TArray<USMStateInstance_Base*> StateInstances;
+	Instance->GetAllStateInstances(StateInstances);
+	int32 NumSnapshotNodes = 0;
+	for (USMStateInstance_Base* StateInstance : StateInstances)
+	{
+		if (USMStateSnapshotTestInstance* SnapshotInstance = Cast<USMStateSnapshotTestInstance>(StateInstance))
+		{
+			SnapshotInstance->SavedInt = 42;
+			SnapshotInstance->SavedString = TEXT("Saved");
+			SnapshotInstance->UnsavedInt = 7;
+			NumSnapshotNodes++;
+		}
+	}
+	TestEqual("Snapshot node instances found", NumSnapshotNodes, 3);
+
+	TArray<uint8> SnapshotData;
+	TestTrue("Snapshot saved", Instance->SaveSnapshot(SnapshotData));
+	TestTrue("Snapshot has data", SnapshotData.Num() > 0);
+
+	// Restore and run begin logic.
+	{
+		USMTestContext* NewContext = NewObject<USMTestContext>();
+		USMInstance* NewInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewContext);
+
+		TestTrue("Snapshot loaded", NewInstance->LoadSnapshot(SnapshotData));
+		TestTrue("Instance is running", NewInstance->IsActive());
+
+		TArray<FGuid> RestoredGuids = NewInstance->GetAllActiveStateGuidsCopy();
+		TestEqual("Active states restored", RestoredGuids.Num(), ActiveGuids.Num());
+		TestEqual("Active states match", TestHelpers::ArrayContentsInArray(RestoredGuids, ActiveGuids), ActiveGuids.Num());
+
+		FSMState_Base* RestoredState = NewInstance->GetSingleNestedActiveState();
+		if (TestNotNull("Restored nested active state found", RestoredState))
+		{
+			TestEqual("Time in state restored", RestoredState->GetActiveTime(), TimeInState);
+		}
+
+		TestTrue("State begin logic run", NewContext->GetEntryInt() > 0);
+
+		NewInstance->GetAllStateInstances(StateInstances);
+		for (USMStateInstance_Base* StateInstance : StateInstances)
+		{
+			if (USMStateSnapshotTestInstance* SnapshotInstance = Cast<USMStateSnapshotTestInstance>(StateInstance))
+			{
+				TestEqual("SaveGame int restored", SnapshotInstance->SavedInt, 42);
+				TestEqual("SaveGame string restored", SnapshotInstance->SavedString, FString(TEXT("Saved")));
+				TestEqual("Unsaved int not restored", SnapshotInstance->UnsavedInt, 0);
+			}
+		}
+
+		// The restored instance should run normally.
+		for (int32 Idx = 0; Idx < 10 && !NewInstance->IsInEndState(); ++Idx)
+		{
+			NewInstance->Update(1.f);
+		}
+		TestTrue("Restored instance completed", NewInstance->IsInEndState());
+
+		TestFalse("Running instance can't be loaded", NewInstance->LoadSnapshot(SnapshotData));
+	}
+
+	// Restore without running begin logic.
+	{
+		USMTestContext* NewContext = NewObject<USMTestContext>();
+		USMInstance* NewInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewContext);
+
+		TestTrue("Snapshot loaded", NewInstance->LoadSnapshot(SnapshotData, false));
+		TestEqual("Active states match", TestHelpers::ArrayContentsInArray(NewInstance->GetAllActiveStateGuidsCopy(), ActiveGuids), ActiveGuids.Num());
+		TestEqual("State begin logic not run", NewContext->GetEntryInt(), 0);
+
+		NewInstance->Update(0.f);
+		TestEqual("State begin logic not run on update", NewContext->GetEntryInt(), 0);
+	}
+
+	// Invalid snapshots.
+	{
+		USMInstance* NewInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+
+		TArray<uint8> BadData = SnapshotData;
+		BadData[0] = 0xFF;
+		AddExpectedError("has unsupported version", EAutomationExpectedErrorFlags::Contains, 1);
+		TestFalse("Bad version not loaded", NewInstance->LoadSnapshot(BadData));
+
+		BadData = SnapshotData;
+		BadData[1] ^= 0xFF;
+		AddExpectedError("was saved from a different state machine class", EAutomationExpectedErrorFlags::Contains, 1);
+		TestFalse("Bad signature not loaded", NewInstance->LoadSnapshot(BadData));
+
+		TestFalse("Instance not started", NewInstance->IsActive());
+	}
+
+	// Compare bulk snapshots against restoring from guids.
+	{
+		const int32 NumInstances = 500;
+
+		TArray<USMInstance*> SourceInstances;
+		TArray<USMInstance*> SnapshotInstances;
+		TArray<USMInstance*> GuidInstances;
+		for (int32 Idx = 0; Idx < NumInstances; ++Idx)
+		{
+			USMInstance* SourceInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context, false);
+			SourceInstance->LoadSnapshot(SnapshotData, false);
+			SourceInstances.Add(SourceInstance);
+
+			SnapshotInstances.Add(TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context, false));
+			GuidInstances.Add(TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context, false));
+		}
+
+		double StartTime = FPlatformTime::Seconds();
+		TArray<uint8> BulkData;
+		USMBlueprintUtils::SaveStateMachineSnapshots(SourceInstances, BulkData);
+		const int32 NumLoaded = USMBlueprintUtils::LoadStateMachineSnapshots(SnapshotInstances, BulkData, false);
+		const double SnapshotTime = FPlatformTime::Seconds() - StartTime;
+
+		TestEqual("All snapshots loaded", NumLoaded, NumInstances);
+
+		StartTime = FPlatformTime::Seconds();
+		TArray<TArray<FGuid>> SavedGuids;
+		SavedGuids.SetNum(NumInstances);
+		for (int32 Idx = 0; Idx < NumInstances; ++Idx)
+		{
+			SourceInstances[Idx]->GetAllActiveStateGuids(SavedGuids[Idx]);
+		}
+		for (int32 Idx = 0; Idx < NumInstances; ++Idx)
+		{
+			GuidInstances[Idx]->LoadFromMultipleStates(SavedGuids[Idx]);
+			GuidInstances[Idx]->Start();
+		}
+		const double GuidTime = FPlatformTime::Seconds() - StartTime;
+
+		for (int32 Idx = 0; Idx < NumInstances; ++Idx)
+		{
+			if (TestHelpers::ArrayContentsInArray(SnapshotInstances[Idx]->GetAllActiveStateGuidsCopy(), ActiveGuids) != ActiveGuids.Num())
+			{
+				AddError(FString::Printf(TEXT("Snapshot instance %d restored to the wrong states."), Idx));
+				break;
+			}
+		}
+
+		AddInfo(FString::Printf(TEXT("Snapshots: %d instances in %d bytes, saved and restored in %.3f ms. Guids restored in %.3f ms."),
+			NumInstances, BulkData.Num(), SnapshotTime * 1000.0, GuidTime * 1000.0));
+	}
+
+	// Truncated and corrupt bulk snapshots.
+	{
+		const int32 NumInstances = 10;
+
+		TArray<USMInstance*> SourceInstances;
+		for (int32 Idx = 0; Idx < NumInstances; ++Idx)
+		{
+			USMInstance* SourceInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context, false);
+			SourceInstance->LoadSnapshot(SnapshotData, false);
+			SourceInstances.Add(SourceInstance);
+		}
+
+		TArray<uint8> BulkData;
+		USMBlueprintUtils::SaveStateMachineSnapshots(SourceInstances, BulkData);
+
+		auto CreateTargetInstances = [&]()
+		{
+			TArray<USMInstance*> TargetInstances;
+			for (int32 Idx = 0; Idx < NumInstances; ++Idx)
+			{
+				TargetInstances.Add(TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context, false));
+			}
+			return TargetInstances;
+		};
+
+		// Cut the buffer in the middle of an instance record.
+		TArray<uint8> TruncatedData = BulkData;
+		TruncatedData.SetNum(BulkData.Num() / 2);
+		AddExpectedError("snapshot data is truncated or corrupt", EAutomationExpectedErrorFlags::Contains, 1);
+		const int32 NumTruncatedLoaded = USMBlueprintUtils::LoadStateMachineSnapshots(CreateTargetInstances(), TruncatedData, false);
+		TestTrue("Instances before the truncation loaded", NumTruncatedLoaded > 0);
+		TestTrue("Instances after the truncation not loaded", NumTruncatedLoaded < NumInstances);
+
+		// Overwrite the size of the first instance record with a negative value.
+		int64 FirstSizePosition = 0;
+		{
+			FMemoryReader Reader(BulkData);
+			uint32 NumSaved = 0;
+			Reader.SerializeIntPacked(NumSaved);
+			FirstSizePosition = Reader.Tell();
+		}
+		TArray<uint8> CorruptData = BulkData;
+		{
+			FMemoryWriter Writer(CorruptData);
+			Writer.Seek(FirstSizePosition);
+			int32 BadSize = -1;
+			Writer << BadSize;
+		}
+		AddExpectedError("snapshot data is truncated or corrupt", EAutomationExpectedErrorFlags::Contains, 1);
+		TestEqual("Negative record size not loaded", USMBlueprintUtils::LoadStateMachineSnapshots(CreateTargetInstances(), CorruptData, false), 0);
+	}
+
+	return NewAsset.DeleteAsset(this);
+}
+
 #endif
 
 #endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
@@ -669,6 +669,213 @@ IMPLEMENT_SIMPLE_AUTOMATION_TEST(FParallelStatesTest, "SMTests.ParallelStates",
 	return NewAsset.DeleteAsset(this);
 }
 
+/** Recursively find active states the way the instance did before active states were tracked. */
+static void ScanActiveStates(const FSMStateMachine& StateMachine, TArray<FSMState_Base*>& OutStates)
+{
+	if (USMInstance* ReferencedInstance = StateMachine.GetInstanceReference())
+	{
+		ScanActiveStates(ReferencedInstance->GetRootStateMachine(), OutStates);
+		return;
+	}
+
+	OutStates.Append(StateMachine.GetActiveStates());
+	for (FSMState_Base* State : StateMachine.GetStates())
+	{
+		if (State->IsStateMachine())
+		{
+			ScanActiveStates(*(FSMStateMachine*)State, OutStates);
+		}
+	}
+}
+
+static void TestActiveStatesMatchFullScan(FAutomationTestBase* Test, USMInstance* Instance, bool bCheckScanOrder = false)
+{
+	TArray<FSMState_Base*> ScannedStates;
+	ScanActiveStates(Instance->GetRootStateMachine(), ScannedStates);
+
+	TArray<FGuid> ScannedGuids;
+	for (FSMState_Base* State : ScannedStates)
+	{
+		ScannedGuids.AddUnique(State->GetGuid());
+	}
+	
+	const TArray<FSMState_Base*> TrackedStates = Instance->GetAllActiveStates();
+	Test->TestEqual("Tracked states match full scan", TrackedStates.Num(), ScannedStates.Num());
+	Test->TestEqual("Tracked states match full scan", TestHelpers::ArrayContentsInArray(TrackedStates, ScannedStates), ScannedStates.Num());
+
+	const TArray<FGuid> TrackedGuids = Instance->GetAllActiveStateGuidsCopy();
+	Test->TestEqual("Tracked guids match full scan", TrackedGuids.Num(), ScannedGuids.Num());
+	Test->TestEqual("Tracked guids match full scan", TestHelpers::ArrayContentsInArray(TrackedGuids, ScannedGuids), ScannedGuids.Num());
+
+	// State machines are listed before their nested states.
+	for (int32 Idx = 0; Idx < TrackedStates.Num(); ++Idx)
+	{
+		const int32 OwnerIdx = TrackedStates.IndexOfByKey(TrackedStates[Idx]->GetOwnerNode());
+		if (OwnerIdx != INDEX_NONE)
+		{
+			Test->TestTrue("Tracked state listed after its state machine", OwnerIdx < Idx);
+		}
+	}
+
+	// With a single active state per state machine the order matches the full scan exactly.
+	if (bCheckScanOrder)
+	{
+		Test->TestTrue("Tracked states in full scan order", TrackedStates == ScannedStates);
+		Test->TestTrue("Tracked guids in full scan order", TrackedGuids == ScannedGuids);
+	}
+}
+
+/**
+ * Verify incrementally tracked active states match a full scan for nested state machines, references, and parallel states.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FActiveStateTrackingTest, "SMTests.ActiveStateTracking", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FActiveStateTrackingTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+
+	// Find root state machine.
+	USMGraphK2Node_StateMachineNode* RootStateMachineNode = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP);
+
+	// Find the state machine graph.
+	USMGraph* StateMachineGraph = RootStateMachineNode->GetStateMachineGraph();
+
+	const int32 TotalNestedStates = 3;
+	
+	// Nested state machines and references.
+	// A -> [A -> B -> C] -> Ref[A -> B -> C] -> B
+	{
+		UEdGraphPin* LastStatePin = nullptr;
+		TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+
+		UEdGraphPin* EntryPointForNestedStateMachine = LastStatePin;
+		USMGraphNode_StateMachineStateNode* NestedFSM = TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, TotalNestedStates, &EntryPointForNestedStateMachine, nullptr);
+		NestedFSM->GetNodeTemplateAs<USMStateMachineInstance>()->bWaitForEndState = true;
+		LastStatePin = NestedFSM->GetOutputPin();
+
+		EntryPointForNestedStateMachine = LastStatePin;
+		USMGraphNode_StateMachineStateNode* ReferencedFSM = TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, TotalNestedStates, &EntryPointForNestedStateMachine, nullptr);
+		ReferencedFSM->GetNodeTemplateAs<USMStateMachineInstance>()->bWaitForEndState = true;
+		LastStatePin = ReferencedFSM->GetOutputPin();
+
+		TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+
+		FString AssetName = "ActiveStateTrackingRef";
+		USMBlueprint* NewReferencedBlueprint = FSMBlueprintEditorUtils::ConvertStateMachineToReference(ReferencedFSM, false, &AssetName, nullptr);
+		TestNotNull("New referenced blueprint created", NewReferencedBlueprint);
+		if (!NewReferencedBlueprint)
+		{
+			return false;
+		}
+		
+		FKismetEditorUtilities::CompileBlueprint(NewReferencedBlueprint);
+		FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+		FString ReferencedPath = NewReferencedBlueprint->GetPathName();
+		FAssetHandler ReferencedAsset(NewReferencedBlueprint->GetName(), USMBlueprint::StaticClass(), NewObject<USMBlueprintFactory>(), &ReferencedPath);
+		ReferencedAsset.Object = NewReferencedBlueprint;
+		ReferencedAsset.Package = FAssetData(NewReferencedBlueprint).GetPackage();
+
+		USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+		TestActiveStatesMatchFullScan(this, Instance, true);
+
+		Instance->Start();
+		TestActiveStatesMatchFullScan(this, Instance, true);
+
+		int32 Iterations = 0;
+		while (!Instance->IsInEndState() && Iterations < 100)
+		{
+			Instance->Update(1.f);
+			TestActiveStatesMatchFullScan(this, Instance, true);
+			Iterations++;
+		}
+		
+		TestTrue("State machine reached end state", Instance->IsInEndState());
+
+		// Nothing changes once in the end state.
+		const uint32 Version = Instance->GetActiveStatesVersion();
+		Instance->Update(1.f);
+		TestEqual("Active states version unchanged", Instance->GetActiveStatesVersion(), Version);
+
+		Instance->Stop();
+		TestActiveStatesMatchFullScan(this, Instance, true);
+
+		// Load into a nested state and the reference. Temporary entry states are reported as active until the instance starts.
+		TArray<FGuid> LoadGuids;
+		for (const auto& KeyVal : Instance->GetStateMap())
+		{
+			FSMState_Base* State = KeyVal.Value;
+			const FSMStateMachine* Owner = (FSMStateMachine*)State->GetOwnerNode();
+			if (!State->IsStateMachine() && Owner && Owner != &Instance->GetRootStateMachine() && State->IsEndState())
+			{
+				LoadGuids.Add(KeyVal.Key);
+			}
+		}
+		Instance->Shutdown();
+
+		Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+		Instance->LoadFromMultipleStates(LoadGuids);
+		TestActiveStatesMatchFullScan(this, Instance);
+
+		Instance->Start();
+		TestActiveStatesMatchFullScan(this, Instance);
+		Instance->Shutdown();
+
+		ReferencedAsset.DeleteAsset(this);
+	}
+
+	// Parallel states which stay active.
+	{
+		TArray<UEdGraphPin*> LastStatePins;
+		FSMBlueprintEditorUtils::RemoveAllNodesFromGraph(StateMachineGraph, NewBP);
+		TestHelpers::BuildBranchingStateMachine(this, StateMachineGraph, 3, 3, true, &LastStatePins, true);
+		FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+		USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+		Instance->Start();
+		TestActiveStatesMatchFullScan(this, Instance);
+
+		int32 Iterations = 0;
+		while (!Instance->IsInEndState() && Iterations < 100)
+		{
+			Instance->Update(1.f);
+			TestActiveStatesMatchFullScan(this, Instance);
+			Iterations++;
+		}
+
+		TArray<USMStateInstance_Base*> StateInstances;
+		Instance->GetAllStateInstances(StateInstances);
+
+		uint32 Version = Instance->GetActiveStatesVersion();
+		StateInstances[1]->SetActive(false);
+		TestNotEqual("Active states version changed", Instance->GetActiveStatesVersion(), Version);
+		TestActiveStatesMatchFullScan(this, Instance);
+
+		Version = Instance->GetActiveStatesVersion();
+		StateInstances[1]->SetActive(true);
+		TestNotEqual("Active states version changed", Instance->GetActiveStatesVersion(), Version);
+		TestActiveStatesMatchFullScan(this, Instance);
+
+		for (USMStateInstance_Base* StateInstance : StateInstances)
+		{
+			StateInstance->SetActive(false);
+		}
+		TestActiveStatesMatchFullScan(this, Instance);
+		TestEqual("No states active", Instance->GetAllActiveStates().Num(), 0);
+
+		Instance->Shutdown();
+	}
+	
+	return NewAsset.DeleteAsset(this);
+}
+
 #endif
 
 #endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include "Graph/SMStateGraph.h"
 #include "Graph/Nodes/SMGraphK2Node_StateMachineNode.h"
 #include "Graph/Nodes/SMGraphNode_StateNode.h"
+#include "Graph/Nodes/SMGraphNode_ConduitNode.h"
 #include "Graph/Nodes/SMGraphNode_StateMachineEntryNode.h"
 #include "Graph/Nodes/SMGraphNode_TransitionEdge.h"
 #include "Graph/Nodes/SMGraphNode_StateMachineStateNode.h"
@@ -700,6 +701,168 @@ IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTransitionOptimizationTest, "SMTests.Transitio
 	return true;
 }
 
+/**
+ * Transitions which evaluate on signal should only run when their state starts, an event is raised, or a watched variable changes.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTransitionEvaluateOnSignalTest, "SMTests.TransitionEvaluateOnSignal", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FTransitionEvaluateOnSignalTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+
+	// Find root state machine.
+	USMGraphK2Node_StateMachineNode* RootStateMachineNode = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP);
+
+	// Find the state machine graph.
+	USMGraph* StateMachineGraph = RootStateMachineNode->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 2, &LastStatePin);
+
+	USMGraphNode_TransitionEdge* TransitionEdge =
+		CastChecked<USMGraphNode_TransitionEdge>(Cast<USMGraphNode_StateNode>(LastStatePin->GetOwningNode())->GetInputPin()->LinkedTo[0]->GetOwningNode());
+
+	// Pre evaluate counts how often the transition runs its graphs.
+	TestHelpers::AddEventWithLogic<USMGraphK2Node_TransitionPreEvaluateNode>(this, TransitionEdge,
+		USMTestContext::StaticClass()->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(USMTestContext, IncreaseTransitionPreEval)));
+
+	const FName VarName = "WatchedValue";
+	FEdGraphPinType VarType;
+	VarType.PinCategory = UEdGraphSchema_K2::PC_Int;
+	FBlueprintEditorUtils::AddMemberVariable(NewBP, VarName, VarType, "0");
+
+	const FName EventName = "TestSignal";
+	USMTransitionInstance* TransitionTemplate = TransitionEdge->GetNodeTemplateAs<USMTransitionInstance>();
+	TransitionTemplate->bEvaluateOnSignal = true;
+	TransitionTemplate->SignalEvents.Add(EventName);
+	TransitionTemplate->SignalProperties.Add(VarName);
+	
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	auto StartInstance = [&](USMTestContext*& ContextOut)
+	{
+		ContextOut = NewObject<USMTestContext>();
+		ContextOut->bCanTransition = false;
+		
+		USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, ContextOut);
+		Instance->Start();
+		TestEqual("Not evaluated on start", ContextOut->TestTransitionPreEval.Count, 0);
+
+		// The first update evaluates the transition since the state just started.
+		Instance->Update();
+		TestEqual("Evaluated once after state start", ContextOut->TestTransitionPreEval.Count, 1);
+		TestFalse("Not in end state", Instance->IsInEndState());
+
+		// Sleeps even though it would pass now.
+		ContextOut->bCanTransition = true;
+		for (int32 Idx = 0; Idx < 5; ++Idx)
+		{
+			Instance->Update();
+		}
+		TestEqual("Not evaluated while waiting for a signal", ContextOut->TestTransitionPreEval.Count, 1);
+		TestFalse("Not in end state while waiting for a signal", Instance->IsInEndState());
+
+		return Instance;
+	};
+
+	// Named event.
+	{
+		USMTestContext* Context = nullptr;
+		USMInstance* Instance = StartInstance(Context);
+
+		TestFalse("Unknown event doesn't signal", Instance->SignalEvent("UnknownSignal"));
+		Instance->Update();
+		TestFalse("Not in end state after unknown event", Instance->IsInEndState());
+
+		TestTrue("Event signaled transition", Instance->SignalEvent(EventName));
+		Instance->Update();
+		TestEqual("Evaluated after event", Context->TestTransitionPreEval.Count, 2);
+		TestTrue("In end state after event", Instance->IsInEndState());
+
+		Instance->Shutdown();
+	}
+
+	// Watched variable.
+	{
+		USMTestContext* Context = nullptr;
+		USMInstance* Instance = StartInstance(Context);
+		
+		FIntProperty* Property = FindFProperty<FIntProperty>(Instance->GetClass(), VarName);
+		TestNotNull("Watched variable found", Property);
+		if (!Property)
+		{
+			return false;
+		}
+		
+		Property->SetPropertyValue_InContainer(Instance, 1);
+		Instance->Update();
+		TestEqual("Evaluated after variable changed", Context->TestTransitionPreEval.Count, 2);
+		TestTrue("In end state after variable changed", Instance->IsInEndState());
+
+		TestFalse("Inactive state doesn't receive events", Instance->SignalEvent(EventName));
+		
+		Instance->Shutdown();
+	}
+
+	// Polling still evaluates every update.
+	{
+		TransitionTemplate->bEvaluateOnSignal = false;
+		FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+		USMTestContext* Context = NewObject<USMTestContext>();
+		Context->bCanTransition = false;
+		USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+		Instance->Start();
+		TestEqual("Not evaluated on start", Context->TestTransitionPreEval.Count, 0);
+		
+		const int32 TotalUpdates = 5;
+		for (int32 Idx = 0; Idx < TotalUpdates; ++Idx)
+		{
+			Instance->Update();
+		}
+		TestEqual("Evaluated every update", Context->TestTransitionPreEval.Count, TotalUpdates);
+
+		Instance->Shutdown();
+	}
+
+	// Watched variables must exist on the state machine.
+	{
+		TransitionTemplate->bEvaluateOnSignal = true;
+		TransitionTemplate->SignalProperties.Add("MissingVariable");
+
+		AddExpectedError("which is not a member variable of the state machine", EAutomationExpectedErrorFlags::Contains, 1);
+		FKismetEditorUtilities::CompileBlueprint(NewBP);
+		TestEqual("Missing watched variable fails compile", NewBP->Status, BS_Error);
+
+		TransitionTemplate->SignalProperties.Remove("MissingVariable");
+		FKismetEditorUtilities::CompileBlueprint(NewBP);
+		TestNotEqual("Compiles with valid watched variables", NewBP->Status, BS_Error);
+	}
+
+	// Conduits evaluated with transitions are never active so can't signal their transitions.
+	{
+		USMGraphNode_ConduitNode* ConduitNode = FSMBlueprintEditorUtils::ConvertNodeTo<USMGraphNode_ConduitNode>(TransitionEdge->GetFromState());
+		ConduitNode->GetNodeTemplateAs<USMConduitInstance>()->bEvalWithTransitions = true;
+
+		AddExpectedError("evaluates on signal but starts from Conduit", EAutomationExpectedErrorFlags::Contains, 1);
+		FKismetEditorUtilities::CompileBlueprint(NewBP);
+		TestEqual("Signal transition from conduit fails compile", NewBP->Status, BS_Error);
+
+		ConduitNode->GetNodeTemplateAs<USMConduitInstance>()->bEvalWithTransitions = false;
+		FKismetEditorUtilities::CompileBlueprint(NewBP);
+		TestNotEqual("Signal transition from conduit configured as a state compiles", NewBP->Status, BS_Error);
+	}
+	
+	return NewAsset.DeleteAsset(this);
+}
+
 #endif
 
 #endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
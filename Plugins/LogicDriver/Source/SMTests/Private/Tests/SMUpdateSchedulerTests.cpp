@@ -0,0 +1,245 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#include "Blueprints/SMBlueprint.h"
+#include "SMTestHelpers.h"
+#include "SMTestContext.h"
+#include "SMUpdateScheduler.h"
+#include "Utilities/SMBlueprintEditorUtils.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "Graph/SMGraph.h"
+#include "Graph/Nodes/SMGraphK2Node_StateMachineNode.h"
+#include "Graph/Nodes/SMGraphNode_TransitionEdge.h"
+#include "Graph/SMTransitionGraph.h"
+#include "Graph/Nodes/RootNodes/SMGraphK2Node_TransitionResultNode.h"
+#include "Engine/World.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#if PLATFORM_DESKTOP
+
+static const FName ParallelConditionName = "bParallelCondition";
+
+/** Build a linear state machine where every transition only reads a bool variable, allowing it to be evaluated in parallel. */
+static bool BuildParallelStateMachine(FAutomationTestBase* Test, FAssetHandler& NewAsset, int32 TotalStates)
+{
+	if (!TestHelpers::TryCreateNewStateMachineAsset(Test, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+
+	// Find root state machine.
+	USMGraphK2Node_StateMachineNode* RootStateMachineNode = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP);
+
+	// Find the state machine graph.
+	USMGraph* StateMachineGraph = RootStateMachineNode->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(Test, StateMachineGraph, TotalStates, &LastStatePin);
+
+	FEdGraphPinType VarType;
+	VarType.PinCategory = UEdGraphSchema_K2::PC_Boolean;
+	FBlueprintEditorUtils::AddMemberVariable(NewBP, ParallelConditionName, VarType, "True");
+
+	FProperty* NewProperty = FSMBlueprintEditorUtils::GetPropertyForVariable(NewBP, ParallelConditionName);
+
+	TArray<USMGraphNode_TransitionEdge*> TransitionEdges;
+	StateMachineGraph->GetNodesOfClass(TransitionEdges);
+	for (USMGraphNode_TransitionEdge* TransitionEdge : TransitionEdges)
+	{
+		USMTransitionGraph* TransitionGraph = TransitionEdge->GetTransitionGraph();
+		TransitionGraph->ResultNode->BreakAllNodeLinks();
+		FSMBlueprintEditorUtils::PlacePropertyOnGraph(TransitionGraph, NewProperty, TransitionGraph->ResultNode->GetTransitionEvaluationPin(), nullptr);
+	}
+
+	return true;
+}
+
+static void SetParallelCondition(USMInstance* Instance, bool bValue)
+{
+	FBoolProperty* Property = FindFProperty<FBoolProperty>(Instance->GetClass(), ParallelConditionName);
+	check(Property);
+	Property->SetPropertyValue_InContainer(Instance, bValue);
+}
+
+/**
+ * Evaluate transitions of many instances across worker threads and check the results match a normal update.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FParallelTransitionEvaluationTest, "SMTests.ParallelTransitionEvaluation", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FParallelTransitionEvaluationTest::RunTest(const FString& Parameters)
+{
+	// Total states to test.
+	const int32 TotalStates = 5;
+
+	FAssetHandler NewAsset;
+	if (!BuildParallelStateMachine(this, NewAsset, TotalStates))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+
+	// Serial results to compare against.
+	int32 ExpectedEntryHits = 0; int32 ExpectedUpdateHits = 0; int32 ExpectedEndHits = 0; int32 ExpectedIterations = 0;
+	TestHelpers::RunStateMachineToCompletion(this, NewBP, ExpectedEntryHits, ExpectedUpdateHits, ExpectedEndHits, 1000, true, true, true, &ExpectedIterations);
+
+	const int32 TotalInstances = 64;
+	TArray<USMTestContext*> Contexts;
+	TArray<USMInstance*> Instances;
+	for (int32 Idx = 0; Idx < TotalInstances; ++Idx)
+	{
+		USMTestContext* Context = NewObject<USMTestContext>();
+		USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+		Instance->Start();
+		
+		Contexts.Add(Context);
+		Instances.Add(Instance);
+	}
+
+	// Evaluate transitions in parallel and take them during the update.
+	const float DeltaTime = 1.f;
+	int32 Iterations = 0;
+	while (!Instances[0]->IsInEndState() && Iterations < 1000)
+	{
+		USMUpdateScheduler::PreEvaluateInstances(Instances, DeltaTime);
+		for (USMInstance* Instance : Instances)
+		{
+			Instance->Update(DeltaTime);
+		}
+		Iterations++;
+	}
+
+	TestEqual("Parallel evaluation updated the same number of times", Iterations, ExpectedIterations);
+	
+	for (int32 Idx = 0; Idx < TotalInstances; ++Idx)
+	{
+		TestTrue("State machine reached end state", Instances[Idx]->IsInEndState());
+		Instances[Idx]->Shutdown();
+
+		TestEqual("Entry hits match serial evaluation", Contexts[Idx]->GetEntryInt(), ExpectedEntryHits);
+		TestEqual("Update hits match serial evaluation", Contexts[Idx]->GetUpdateInt(), ExpectedUpdateHits);
+		TestEqual("End hits match serial evaluation", Contexts[Idx]->GetEndInt(), ExpectedEndHits);
+	}
+
+	// Conditions changing between the parallel evaluation and the update.
+	{
+		USMTestContext* Context = NewObject<USMTestContext>();
+		USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+		Instance->Start();
+
+		FSMState_Base* InitialState = Instance->GetRootStateMachine().GetSingleActiveState();
+
+		// A transition found in parallel isn't taken once its condition is no longer true.
+		USMUpdateScheduler::PreEvaluateInstances({ Instance }, DeltaTime);
+		TestEqual("Transition found in parallel", Instance->GetRootStateMachine().GetPreEvaluatedTransitions().Num(), 1);
+		SetParallelCondition(Instance, false);
+		Instance->Update(DeltaTime);
+		TestEqual("Stale transition not taken", Instance->GetRootStateMachine().GetSingleActiveState(), InitialState);
+
+		// A condition becoming true after the parallel evaluation is still picked up by the same update.
+		USMUpdateScheduler::PreEvaluateInstances({ Instance }, DeltaTime);
+		TestEqual("No transition found in parallel", Instance->GetRootStateMachine().GetPreEvaluatedTransitions().Num(), 0);
+		SetParallelCondition(Instance, true);
+		Instance->Update(DeltaTime);
+		TestNotEqual("Transition taken in the same update", Instance->GetRootStateMachine().GetSingleActiveState(), InitialState);
+
+		Instance->Shutdown();
+	}
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Register instances with the update scheduler of a world and evaluate them from the world pre actor tick.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FUpdateSchedulerRegistrationTest, "SMTests.UpdateSchedulerRegistration", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FUpdateSchedulerRegistrationTest::RunTest(const FString& Parameters)
+{
+	// Total states to test.
+	const int32 TotalStates = 5;
+
+	FAssetHandler NewAsset;
+	if (!BuildParallelStateMachine(this, NewAsset, TotalStates))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+
+	// Serial results to compare against.
+	int32 ExpectedEntryHits = 0; int32 ExpectedUpdateHits = 0; int32 ExpectedEndHits = 0; int32 ExpectedIterations = 0;
+	TestHelpers::RunStateMachineToCompletion(this, NewBP, ExpectedEntryHits, ExpectedUpdateHits, ExpectedEndHits, 1000, true, true, true, &ExpectedIterations);
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	USMUpdateScheduler* Scheduler = World->GetSubsystem<USMUpdateScheduler>();
+	if (!TestNotNull("Update scheduler created for world", Scheduler))
+	{
+		World->DestroyWorld(false);
+		return NewAsset.DeleteAsset(this);
+	}
+
+	FBoolProperty* ParallelProperty = FindFProperty<FBoolProperty>(USMInstance::StaticClass(), TEXT("bEvaluateTransitionsInParallel"));
+	check(ParallelProperty);
+
+	const int32 TotalInstances = 16;
+	TArray<USMTestContext*> Contexts;
+	TArray<USMInstance*> Instances;
+	for (int32 Idx = 0; Idx < TotalInstances; ++Idx)
+	{
+		// Contexts are outered to the world so instances register with its scheduler.
+		USMTestContext* Context = NewObject<USMTestContext>(World);
+		USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+		ParallelProperty->SetPropertyValue_InContainer(Instance, true);
+		Instance->Start();
+
+		Contexts.Add(Context);
+		Instances.Add(Instance);
+	}
+
+	TestEqual("Started instances registered", Scheduler->GetNumRegisteredInstances(), TotalInstances);
+
+	// Evaluate transitions from the world the same way a frame would, then take them during the update.
+	const float DeltaTime = 1.f;
+	int32 Iterations = 0;
+	while (!Instances[0]->IsInEndState() && Iterations < 1000)
+	{
+		FWorldDelegates::OnWorldPreActorTick.Broadcast(World, LEVELTICK_All, DeltaTime);
+		for (USMInstance* Instance : Instances)
+		{
+			Instance->Update(DeltaTime);
+		}
+		Iterations++;
+	}
+
+	TestEqual("Scheduled evaluation updated the same number of times", Iterations, ExpectedIterations);
+
+	for (int32 Idx = 0; Idx < TotalInstances; ++Idx)
+	{
+		TestTrue("State machine reached end state", Instances[Idx]->IsInEndState());
+		Instances[Idx]->Stop();
+
+		TestEqual("Entry hits match serial evaluation", Contexts[Idx]->GetEntryInt(), ExpectedEntryHits);
+		TestEqual("Update hits match serial evaluation", Contexts[Idx]->GetUpdateInt(), ExpectedUpdateHits);
+		TestEqual("End hits match serial evaluation", Contexts[Idx]->GetEndInt(), ExpectedEndHits);
+	}
+
+	TestEqual("Stopped instances unregistered", Scheduler->GetNumRegisteredInstances(), 0);
+
+	for (USMInstance* Instance : Instances)
+	{
+		Instance->Shutdown();
+	}
+
+	World->DestroyWorld(false);
+
+	return NewAsset.DeleteAsset(this);
+}
+
+#endif
+
+#endif
@@ -225,6 +225,22 @@ public:
 	int32 AnotherExposedInt;
 };
 
+UCLASS(Blueprintable)
+class USMStateSnapshotTestInstance : public USMStateTestInstance
+{
+public:
+	GENERATED_BODY()
+
+	UPROPERTY(SaveGame)
+	int32 SavedInt;
+
+	UPROPERTY(SaveGame)
+	FString SavedString;
+
+	UPROPERTY()
+	int32 UnsavedInt;
+};
+
 UCLASS(Blueprintable)
 class USMStateMachineTestInstance : public USMStateMachineInstance
 {
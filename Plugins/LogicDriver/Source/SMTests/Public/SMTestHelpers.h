@@ -81,6 +81,42 @@ protected:
 	void ValidateDirectory();
 };
 
+// Count heap allocations made by the game thread. Wraps GMalloc while counting and forwards everything to it.
+class FSMAllocationCounter : public FMalloc
+{
+public:
+	static FSMAllocationCounter& Get();
+
+	/** Start counting allocations made on the calling thread. */
+	void Begin();
+
+	/** Stop counting and return the number of allocations and reallocations made since Begin. */
+	int32 End();
+
+	// FMalloc
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment = DEFAULT_ALIGNMENT) override;
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment = DEFAULT_ALIGNMENT) override;
+	virtual void Free(void* Original) override;
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override;
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override;
+	virtual void Trim(bool bTrimThreadCaches) override;
+	virtual void SetupTLSCachesOnCurrentThread() override;
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override;
+	virtual bool IsInternallyThreadSafe() const override;
+	virtual bool ValidateHeap() override;
+	virtual const TCHAR* GetDescriptiveName() override;
+	// ~FMalloc
+
+private:
+	FSMAllocationCounter();
+
+	/** The allocator being wrapped. Never cleared since other threads may still be calling into this wrapper. */
+	FMalloc* InnerMalloc;
+	uint32 CountingThreadId;
+	int32 NumAllocations;
+	bool bCounting;
+};
+
 namespace TestHelpers
 {
 	/** Instantiate a runtime state machine instance from a blueprint class. */
@@ -1,7 +1,9 @@
 ﻿// Copyright © 2020 Justin Camden All Rights Reserved
 
 #include "AsgardLashComponent.h"
+#include "Asgard/Abilities/AsgardLashRenderComponent.h"
 #include "Runtime/Engine/Classes/Engine/World.h"
+#include "Async/TaskGraphInterfaces.h"
 
 // Stat cycles
 DECLARE_CYCLE_STAT(TEXT("AsgardLash SimulateLash"), STAT_ASGARD_LashSimulateLash, STATGROUP_ASGARD_Lash);
@@ -9,6 +11,11 @@ DECLARE_CYCLE_STAT(TEXT("AsgardLash Velocity"), STAT_ASGARD_LashVelocity, STATGR
 DECLARE_CYCLE_STAT(TEXT("AsgardLash Constraints"), STAT_ASGARD_LashConstraints, STATGROUP_ASGARD_Lash);
 DECLARE_CYCLE_STAT(TEXT("AsgardLash Detection"), STAT_ASGARD_LashDetection, STATGROUP_ASGARD_Lash);
 DECLARE_CYCLE_STAT(TEXT("AsgardLash Collision"), STAT_ASGARD_LashCollision, STATGROUP_ASGARD_Lash);
+DECLARE_CYCLE_STAT(TEXT("AsgardLash GatherCandidates"), STAT_ASGARD_LashGatherCandidates, STATGROUP_ASGARD_Lash);
+
+// Stat counters
+DECLARE_DWORD_COUNTER_STAT(TEXT("AsgardLash SceneQueries"), STAT_ASGARD_LashSceneQueries, STATGROUP_ASGARD_Lash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AsgardLash CollisionCandidates"), STAT_ASGARD_LashCollisionCandidates, STATGROUP_ASGARD_Lash);
 
 // Console variable setup so we can enable and disable debugging from the console
 // Draw detection debug
@@ -20,6 +27,24 @@ static TAutoConsoleVariable<int32> CVarAsgardLashDrawDebug(
 	ECVF_Scalability | ECVF_RenderThreadSafe);
 static const auto LashDrawDebug = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.LashDrawDebug"));
 
+// Vectorized integration
+static TAutoConsoleVariable<int32> CVarAsgardLashVectorizedIntegration(
+	TEXT("Asgard.LashVectorizedIntegration"),
+	1,
+	TEXT("Whether to integrate lash point velocities four points at a time.\n")
+	TEXT("0: Disabled, integrate one point at a time for comparison, 1: Enabled"),
+	ECVF_Scalability);
+static const auto LashVectorizedIntegration = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.LashVectorizedIntegration"));
+
+// Async simulation
+static TAutoConsoleVariable<int32> CVarAsgardLashAsyncSimulation(
+	TEXT("Asgard.LashAsyncSimulation"),
+	1,
+	TEXT("Whether lashes with bSimulateAsync run their simulation on a task graph worker.\n")
+	TEXT("0: Disabled, simulate on the game thread, 1: Enabled"),
+	ECVF_Scalability);
+static const auto LashAsyncSimulation = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.LashAsyncSimulation"));
+
 // Macros for debug builds
 #if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
 #include "DrawDebugHelpers.h"
@@ -28,6 +53,93 @@ static const auto LashDrawDebug = IConsoleManager::Get().FindConsoleVariable(TEX
 #define DRAW_LASH()	/* nothing */
 #endif
 
+namespace AsgardLash
+{
+	/**
+	* Verlet integrates one axis of the lash points from StartIdx to EndIdx inclusive.
+	* If vectorized, points are integrated four at a time, with any remainder integrated individually.
+	*/
+	static void IntegrateAxis(float* RESTRICT CurrentLocations, float* RESTRICT LastLocations, int32 StartIdx, int32 EndIdx, float VelocityScale, float Acceleration, bool bVectorized)
+	{
+		int32 Idx = StartIdx;
+		if (bVectorized)
+		{
+			const VectorRegister VelocityScaleVector = VectorSetFloat1(VelocityScale);
+			const VectorRegister AccelerationVector = VectorSetFloat1(Acceleration);
+			for (; Idx + 3 <= EndIdx; Idx += 4)
+			{
+				const VectorRegister CurrentVector = VectorLoad(CurrentLocations + Idx);
+				const VectorRegister VelocityVector = VectorSubtract(CurrentVector, VectorLoad(LastLocations + Idx));
+				VectorStore(CurrentVector, LastLocations + Idx);
+				VectorStore(VectorAdd(CurrentVector, VectorMultiplyAdd(VelocityVector, VelocityScaleVector, AccelerationVector)), CurrentLocations + Idx);
+			}
+		}
+
+		for (; Idx <= EndIdx; Idx++)
+		{
+			const float CurrentLocation = CurrentLocations[Idx];
+			const float Velocity = CurrentLocation - LastLocations[Idx];
+			LastLocations[Idx] = CurrentLocation;
+			CurrentLocations[Idx] = CurrentLocation + ((Velocity * VelocityScale) + Acceleration);
+		}
+
+		return;
+	}
+}
+
+void FAsgardLashPointBuffer::Reserve(int32 Number)
+{
+	X.Reserve(Number);
+	Y.Reserve(Number);
+	Z.Reserve(Number);
+}
+
+void FAsgardLashPointBuffer::Add(const FVector& Location)
+{
+	X.Add(Location.X);
+	Y.Add(Location.Y);
+	Z.Add(Location.Z);
+}
+
+void FAsgardLashPointBuffer::RemoveAt(int32 Idx)
+{
+	X.RemoveAt(Idx, 1, false);
+	Y.RemoveAt(Idx, 1, false);
+	Z.RemoveAt(Idx, 1, false);
+}
+
+void FAsgardLashPointBuffer::SetNum(int32 NewNum)
+{
+	X.SetNum(NewNum, false);
+	Y.SetNum(NewNum, false);
+	Z.SetNum(NewNum, false);
+}
+
+void FAsgardLashPointBuffer::CopyTo(TArray<FVector>& OutLocations) const
+{
+	const int32 NumPoints = Num();
+	OutLocations.SetNumUninitialized(NumPoints, false);
+	for (int32 Idx = 0; Idx < NumPoints; Idx++)
+	{
+		OutLocations[Idx] = Get(Idx);
+	}
+}
+
+void FAsgardLashSimulationCompletionTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && !Target->IsPendingKill())
+	{
+		Target->CompleteAsyncSimulation();
+	}
+
+	return;
+}
+
+FString FAsgardLashSimulationCompletionTickFunction::DiagnosticMessage()
+{
+	return Target ? Target->GetFullName() + TEXT("[CompleteAsyncSimulation]") : TEXT("<NULL>[CompleteAsyncSimulation]");
+}
+
 
 // Sets default values for this component's properties
 UAsgardLashComponent::UAsgardLashComponent()
@@ -35,6 +147,11 @@ UAsgardLashComponent::UAsgardLashComponent()
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
+
+	// Async simulations are completed late in the frame, after gameplay has had a chance to run alongside them
+	SimulationCompletionTickFunction.bCanEverTick = true;
+	SimulationCompletionTickFunction.bStartWithTickEnabled = false;
+	SimulationCompletionTickFunction.TickGroup = TG_PostUpdateWork;
 	MaxLashSegments = 20;
 	LashSegmentMaxLength = 10.0f;
 	LashGrowthMinSegmentLength = 7.5f;
@@ -53,12 +170,17 @@ UAsgardLashComponent::UAsgardLashComponent()
 	CollisionSkinWidth = 0.1f;
 	AttachMaxStretchDistance = 25.0f;
 	BlockdPointCorrectionWeight = 1.0f;
+	CachedCollisionMaxPointDisplacement = 50.0f;
 }
 
 void UAsgardLashComponent::AttachLashEndToComponent(USceneComponent* AttachToComponent)
 {
 	if (AttachToComponent)
 	{
+		// Any detach requested by a simulation in flight applied to the previous attachment
+		WaitForAsyncSimulation();
+		bSimulationDetachRequested = false;
+
 		AttachedToActor = AttachToComponent->GetOwner();
 		AttachedToComponent = AttachToComponent;
 	}
@@ -74,6 +196,7 @@ void UAsgardLashComponent::DetachLashEndFromComponent()
 
 void UAsgardLashComponent::SetLashExtended(bool bNewExtended)
 {
+	WaitForAsyncSimulation();
 	if (bNewExtended)
 	{
 		bLashExtended = true;
@@ -83,7 +206,7 @@ void UAsgardLashComponent::SetLashExtended(bool bNewExtended)
 	{
 		if (NumLashSegments > 0)
 		{
-			LashFirstSegmentMaxLength = (LashPointLocations[1] - LashPointLocations[0]).Size();
+			LashFirstSegmentMaxLength = (LashPointBuffer.Get(1) - LashPointBuffer.Get(0)).Size();
 		}
 		bLashExtended = false;
 	}
@@ -95,29 +218,59 @@ void UAsgardLashComponent::BeginPlay()
 	Super::BeginPlay();
 
 	// Reserve space for the lash points
-	LashPointSimulationStartLocations.Reserve(MaxLashSegments);
-	LashPointLocations.Reserve(MaxLashSegments);
-	LashPointFrameStartLocations.Reserve(MaxLashSegments);
-	LashPointBlockingComponents.Reserve(MaxLashSegments);
+	LashPointSimulationStartBuffer.Reserve(MaxLashSegments + 1);
+	LashPointBuffer.Reserve(MaxLashSegments + 1);
+	LashPointLocations.Reserve(MaxLashSegments + 1);
+	LashPointFrameStartLocations.Reserve(MaxLashSegments + 1);
+	LashPointBlockingComponents.Reserve(MaxLashSegments + 1);
 
 	// Set the first point to be equal to the location of the component
 	FVector ComponentLocation = GetComponentLocation();
-	LashPointSimulationStartLocations.Add(ComponentLocation);
+	LashPointSimulationStartBuffer.Add(ComponentLocation);
+	LashPointBuffer.Add(ComponentLocation);
 	LashPointLocations.Add(ComponentLocation);
 	LashPointFrameStartLocations.Add(ComponentLocation);
 	LashPointBlockingComponents.Add(nullptr);
 
 	// Calculate initial variables
 	LashFirstSegmentMaxLength = LashSegmentMaxLength;
+	SimulationCompletionTickFunction.SetTickFunctionEnable(bSimulateAsync);
+}
+
+// Called when the game ends
+void UAsgardLashComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	WaitForAsyncSimulation();
+	Super::EndPlay(EndPlayReason);
+}
+
+void UAsgardLashComponent::RegisterComponentTickFunctions(bool bRegister)
+{
+	Super::RegisterComponentTickFunctions(bRegister);
+
+	if (bRegister)
+	{
+		if (SetupActorComponentTickFunction(&SimulationCompletionTickFunction))
+		{
+			SimulationCompletionTickFunction.Target = this;
+			SimulationCompletionTickFunction.AddPrerequisite(this, PrimaryComponentTick);
+		}
+	}
+	else if (SimulationCompletionTickFunction.IsTickFunctionRegistered())
+	{
+		SimulationCompletionTickFunction.UnRegisterTickFunction();
+	}
+
+	return;
 }
 
 void UAsgardLashComponent::AddLashSegmentAtEnd()
 {
-	FVector NewPoint = LashPointSimulationStartLocations.Last();
-	LashPointSimulationStartLocations.Emplace(NewPoint);
+	FVector NewPoint = LashPointSimulationStartBuffer.Last();
+	LashPointSimulationStartBuffer.Add(NewPoint);
 	LashPointFrameStartLocations.Emplace(NewPoint);
-	NewPoint = LashPointLocations.Last();
-	LashPointLocations.Emplace(NewPoint);
+	NewPoint = LashPointBuffer.Last();
+	LashPointBuffer.Add(NewPoint);
 	LashPointBlockingComponents.Add(nullptr);
 	NumLashSegments++;
 
@@ -127,8 +280,8 @@ void UAsgardLashComponent::AddLashSegmentAtEnd()
 void UAsgardLashComponent::RemoveLashSegmentFromFront()
 {
 	checkf(NumLashSegments > 0, TEXT("ERROR: NumLashPoints was <= 0. (AsgardLashComponent, RemoveLashPointFromEnd, %s"), * GetNameSafe(this));
-	LashPointSimulationStartLocations.RemoveAt(1, 1, false);
-	LashPointLocations.RemoveAt(1, 1, false);
+	LashPointSimulationStartBuffer.RemoveAt(1);
+	LashPointBuffer.RemoveAt(1);
 	LashPointFrameStartLocations.RemoveAt(1, 1, false);
 	LashPointBlockingComponents.RemoveAt(1, 1, false);
 	NumLashSegments--;
@@ -139,8 +292,8 @@ void UAsgardLashComponent::RemoveLashSegmentFromFront()
 void UAsgardLashComponent::RemoveLashSegmentAtIndex(int32 Idx)
 {
 	checkf(NumLashSegments >= Idx, TEXT("ERROR: NumLashPoints was < %f. (AsgardLashComponent, RemoveLashPointFromEnd, %s"), Idx, *GetNameSafe(this));
-	LashPointSimulationStartLocations.RemoveAt(Idx, 1, false);
-	LashPointLocations.RemoveAt(Idx, 1, false);
+	LashPointSimulationStartBuffer.RemoveAt(Idx);
+	LashPointBuffer.RemoveAt(Idx);
 	LashPointFrameStartLocations.RemoveAt(Idx, 1, false);
 	LashPointBlockingComponents.RemoveAt(Idx, 1, false);
 	NumLashSegments--;
@@ -151,7 +304,7 @@ bool UAsgardLashComponent::ShrinkLash(float DeltaTime, float ShrinkSpeed)
 	// Condense any existing lash segments that are close to each other
 	for (int32 Idx = 1; Idx < NumLashSegments; Idx++)
 	{
-		if ((LashPointLocations[Idx + 1] - LashPointLocations[Idx]).SizeSquared() < (LashShrinkMaxSegmentLength * LashShrinkMaxSegmentLength))
+		if ((LashPointBuffer.Get(Idx + 1) - LashPointBuffer.Get(Idx)).SizeSquared() < (LashShrinkMaxSegmentLength * LashShrinkMaxSegmentLength))
 		{
 			RemoveLashSegmentAtIndex(Idx);
 			Idx--;
@@ -169,7 +322,7 @@ bool UAsgardLashComponent::ShrinkLash(float DeltaTime, float ShrinkSpeed)
 		// Update the length of the last segment if more segments remain
 		if (NumLashSegments > 0)
 		{
-			LashFirstSegmentMaxLength = (LashPointLocations[1] - LashPointLocations[0]).Size();
+			LashFirstSegmentMaxLength = (LashPointBuffer.Get(1) - LashPointBuffer.Get(0)).Size();
 		}
 		else
 		{
@@ -183,20 +336,11 @@ void UAsgardLashComponent::ApplyVelocityToLashPoints(float DeltaTime)
 {
 	SCOPE_CYCLE_COUNTER(STAT_ASGARD_LashVelocity);
 
-	for (uint8 Idx = 1; Idx <= NumLashSegments; Idx++)
-	{
-		// Calculate the velocity
-		FVector& CurrentLocation = LashPointLocations[Idx];
-		FVector& LastLocation = LashPointSimulationStartLocations[Idx];
-		FVector Velocity = CurrentLocation - LastLocation;
-		Velocity.X = FMath::Lerp(Velocity.X, 0.0f, Damping.X * DeltaTime);
-		Velocity.Y = FMath::Lerp(Velocity.Y, 0.0f, Damping.Y * DeltaTime);
-		Velocity.Z = FMath::Lerp(Velocity.Z, 0.0f, Damping.Z * DeltaTime);
-
-		// Update the last and current locations
-		LastLocation = CurrentLocation;
-		CurrentLocation = CurrentLocation + Velocity + (Gravity * DeltaTime);
-	}
+	// Damping lerps velocity towards zero, which is equivalent to scaling it down
+	const bool bVectorized = LashVectorizedIntegration->GetInt() != 0;
+	AsgardLash::IntegrateAxis(LashPointBuffer.X.GetData(), LashPointSimulationStartBuffer.X.GetData(), 1, NumLashSegments, 1.0f - (Damping.X * DeltaTime), Gravity.X * DeltaTime, bVectorized);
+	AsgardLash::IntegrateAxis(LashPointBuffer.Y.GetData(), LashPointSimulationStartBuffer.Y.GetData(), 1, NumLashSegments, 1.0f - (Damping.Y * DeltaTime), Gravity.Y * DeltaTime, bVectorized);
+	AsgardLash::IntegrateAxis(LashPointBuffer.Z.GetData(), LashPointSimulationStartBuffer.Z.GetData(), 1, NumLashSegments, 1.0f - (Damping.Z * DeltaTime), Gravity.Z * DeltaTime, bVectorized);
 
 	return;
 }
@@ -206,44 +350,15 @@ void UAsgardLashComponent::ApplyConstraintsToLashPointsFromFront()
 	SCOPE_CYCLE_COUNTER(STAT_ASGARD_LashConstraints);
 
 	// The first segment is special because it is constrained to the root of the chain, aka the component location
-	// Begin by cashing the variables
-	const FVector& FirstPoint = LashPointLocations[0];
-	FVector& SecondPoint = LashPointLocations[1];
-	FVector ToSecondPoint = SecondPoint - FirstPoint;
-	float FirstSegmentLength = ToSecondPoint.SizeSquared();
-
 	// If physics and constraint simulation has lengthened the first segment, cap the size at the max segment length
-	if (FirstSegmentLength > LashFirstSegmentMaxLength * LashFirstSegmentMaxLength)
-	{
-		ToSecondPoint = ToSecondPoint / (FMath::Sqrt(FirstSegmentLength));
-		SecondPoint = FirstPoint + (ToSecondPoint * LashFirstSegmentMaxLength);
-	}
+	LashPointBuffer.ConstrainDistance(0, 1, LashFirstSegmentMaxLength, 0.0f, 1.0f);
 
 	// Solve constraints from start to end to give the lash a responsive feeling
 	for (int32 Idx = 1; Idx < NumLashSegments; Idx++)
 	{
-		// Cache variables
-		FVector& CurrentPoint = LashPointLocations[Idx];
-		FVector& NextPoint = LashPointLocations[Idx + 1];
-		FVector ToNextPoint = NextPoint - CurrentPoint;
-		float DistToNextPoint = ToNextPoint.SizeSquared();
-
-		// If the current point is too far from the next point
-		if (DistToNextPoint > LashSegmentMaxLength * LashSegmentMaxLength)
-		{
-			// Normalize direction to next point
-			DistToNextPoint = FMath::Sqrt(DistToNextPoint);
-			ToNextPoint = ToNextPoint / DistToNextPoint;
-
-			// Scale the distance according to the error
-			DistToNextPoint -= LashSegmentMaxLength;
-			ToNextPoint = ToNextPoint * DistToNextPoint;
-
-			// Apply the correction to the current and next points
-			float NextPointCorrectionWeight = (LashPointBlockingComponents[Idx + 1] ? BlockdPointCorrectionWeight : ChildPointCorrectionWeight);
-			CurrentPoint = CurrentPoint + (ToNextPoint * (1.0f - NextPointCorrectionWeight));
-			NextPoint = NextPoint + (ToNextPoint * -NextPointCorrectionWeight);
-		}
+		// Apply the correction to the current and next points
+		float NextPointCorrectionWeight = (LashPointBlockingComponents[Idx + 1] ? BlockdPointCorrectionWeight : ChildPointCorrectionWeight);
+		LashPointBuffer.ConstrainDistance(Idx, Idx + 1, LashSegmentMaxLength, 1.0f - NextPointCorrectionWeight, NextPointCorrectionWeight);
 	}
 
 	return;
@@ -255,35 +370,27 @@ void UAsgardLashComponent::ApplyConstraintsToLashPointsFromBack()
 
 	// If the end is attached to a component
 	int32 LastIdx = NumLashSegments;
-	if (AttachedToComponent)
+	if (bSimulationAttached)
 	{
-		// Calculate the designated offset from the attached component
-		FVector NewAttachedLocation = AttachedToComponent->GetComponentTransform().TransformPositionNoScale(AttachOffset);
+		// The designated offset from the attached component is calculated on the game thread before simulating
+		const FVector& NewAttachedLocation = SimulationAttachedLocation;
 
 		// If the lash would stretch too far, detach
+		// The component is detached once the simulation completes, since it may be running off the game thread
 		if (AttachMaxStretchDistance > 0.0f 
-			&& (NewAttachedLocation - LashPointLocations[NumLashSegments - 1]).SizeSquared() > FMath::Square(LashSegmentMaxLength + AttachMaxStretchDistance))
+			&& (NewAttachedLocation - LashPointBuffer.Get(NumLashSegments - 1)).SizeSquared() > FMath::Square(LashSegmentMaxLength + AttachMaxStretchDistance))
 		{
-			DetachLashEndFromComponent();
+			bSimulationAttached = false;
+			bSimulationDetachRequested = true;
 		}
 
 		// Otherwise set the last point to the designated offset from the attached component
 		else
 		{
-			LashPointLocations[LastIdx] = NewAttachedLocation;
+			LashPointBuffer.Set(LastIdx, NewAttachedLocation);
 
 			// Update the next point according to constraints
-			FVector& NextPoint = LashPointLocations[LastIdx - 1];
-			FVector ToNextPoint = NextPoint - NewAttachedLocation;
-			float DistToNextPoint = ToNextPoint.SizeSquared();
-
-			// If the current point is too far from the next point
-			if (DistToNextPoint > LashSegmentMaxLength * LashSegmentMaxLength)
-			{
-				ToNextPoint = ToNextPoint / (FMath::Sqrt(DistToNextPoint));
-				NextPoint = NewAttachedLocation + (ToNextPoint * LashSegmentMaxLength);
-			}
-
+			LashPointBuffer.ConstrainDistance(LastIdx, LastIdx - 1, LashSegmentMaxLength, 0.0f, 1.0f);
 
 			LastIdx--;
 		}
@@ -292,44 +399,15 @@ void UAsgardLashComponent::ApplyConstraintsToLashPointsFromBack()
 	// Solve constraints from end to start to give the lash a weighty feeling
 	for (int32 Idx = LastIdx; Idx > 1; Idx--)
 	{
-		// Cache variables
-		FVector& CurrentPoint = LashPointLocations[Idx];
-		FVector& NextPoint = LashPointLocations[Idx - 1];
-		FVector ToNextPoint = NextPoint - CurrentPoint;
-		float DistToNextPoint = ToNextPoint.SizeSquared();
-
-		// If the current point is too far from the next point
-		if (DistToNextPoint > LashSegmentMaxLength* LashSegmentMaxLength)
-		{
-			// Normalize direction to next point
-			DistToNextPoint = FMath::Sqrt(DistToNextPoint);
-			ToNextPoint = ToNextPoint / DistToNextPoint;
-
-			// Scale the distance according to the error
-			DistToNextPoint -= LashSegmentMaxLength;
-			ToNextPoint = ToNextPoint * DistToNextPoint;
-
-			// Apply the correction to the current and next points
-			float CurrentPointCorrectionWeight = (LashPointBlockingComponents[Idx] ? BlockdPointCorrectionWeight : ChildPointCorrectionWeight);
-			CurrentPoint = CurrentPoint + (ToNextPoint * CurrentPointCorrectionWeight);
-			NextPoint = NextPoint + (ToNextPoint * -(1.0f - CurrentPointCorrectionWeight));
-		}
+		// Apply the correction to the current and next points
+		float CurrentPointCorrectionWeight = (LashPointBlockingComponents[Idx] ? BlockdPointCorrectionWeight : ChildPointCorrectionWeight);
+		LashPointBuffer.ConstrainDistance(Idx, Idx - 1, LashSegmentMaxLength, CurrentPointCorrectionWeight, 1.0f - CurrentPointCorrectionWeight);
 	}
 
 	// The first segment is special because it is constrained to the root of the chain, aka the component location
 	// It can also shrink while the chain is inactive
-	// Begin by cashing the variables
-	const FVector& FirstPoint = LashPointLocations[0];
-	FVector& SecondPoint = LashPointLocations[1];
-	FVector ToSecondPoint = SecondPoint - FirstPoint;
-	float FirstSegmentLength = ToSecondPoint.SizeSquared();
-
 	// If physics and constraint simulation has lengthened the first segment, cap the size at the max segment length
-	if (FirstSegmentLength > LashFirstSegmentMaxLength * LashFirstSegmentMaxLength)
-	{
-		ToSecondPoint = ToSecondPoint / (FMath::Sqrt(FirstSegmentLength));
-		SecondPoint = FirstPoint + (ToSecondPoint * LashFirstSegmentMaxLength);
-	}
+	LashPointBuffer.ConstrainDistance(0, 1, LashFirstSegmentMaxLength, 0.0f, 1.0f);
 
 	return;
 }
@@ -339,55 +417,20 @@ void UAsgardLashComponent::DetectActorsInLashSegments()
 	SCOPE_CYCLE_COUNTER(STAT_ASGARD_LashDetection);
 
 	// Initialize variables for overlap test
-	UWorld* World = GetWorld();
-	TArray<FOverlapResult> TotalOverlaps;
 	FCollisionQueryParams Params;
-	Params.AddIgnoredActors(IgnoredActors);
-	if (bAutoIgnoreOwner)
-	{
-		Params.AddIgnoredActors(TArray<AActor*> {GetOwner()});
-	}
-	if (AttachedToActor)
-	{
-		Params.AddIgnoredActors(TArray<AActor*> {AttachedToActor});
-	}
-	Params.TraceTag = FName("AsgardLashOverlapTest");
-	FCollisionResponseParams ResponseParams;
+	MakeCollisionQueryParams(Params, FName("AsgardLashOverlapTest"), true);
+	const bool bUseCachedCandidates = bUseCachedCollisionCandidates && GatherCollisionCandidates(Params);
+	TotalOverlaps.Reset();
 
 	// Perform an overlap check for each lash segment
 	for (int32 Idx = 1; Idx <= NumLashSegments; Idx++)
 	{
-		TArray<FOverlapResult> OutOverlaps;
-
 		// Overlap from previous point
-		FVector& CurrentPoint = LashPointLocations[Idx];
-		FVector& PreviousPoint = LashPointLocations[Idx - 1];
-		FVector OverlapDirection = CurrentPoint - PreviousPoint;
-		FCollisionShape CollisionShape = FCollisionShape::MakeCapsule(FVector(CollisionRadius, CollisionRadius, OverlapDirection.Size()));
-		World->OverlapMultiByChannel(
-			OutOverlaps,
-			(CurrentPoint + PreviousPoint) * 0.5f,
-			FRotationMatrix::MakeFromZ(OverlapDirection).ToQuat(),
-			CollisionChannel,
-			CollisionShape,
-			Params,
-			ResponseParams);
-		TotalOverlaps.Append(OutOverlaps);
-		OutOverlaps.Reset();
+		const FVector CurrentPoint = LashPointBuffer.Get(Idx);
+		OverlapLashSegment(TotalOverlaps, LashPointBuffer.Get(Idx - 1), CurrentPoint, Params, bUseCachedCandidates);
 
 		// Overlap from last location
-		FVector& FrameStartLocation = LashPointFrameStartLocations[Idx];
-		OverlapDirection = CurrentPoint - FrameStartLocation;
-		CollisionShape.SetCapsule(FVector(CollisionRadius, CollisionRadius, OverlapDirection.Size()));
-		World->OverlapMultiByChannel(
-			OutOverlaps,
-			(CurrentPoint + FrameStartLocation) * 0.5f,
-			FRotationMatrix::MakeFromZ(OverlapDirection).ToQuat(),
-			CollisionChannel,
-			CollisionShape,
-			Params,
-			ResponseParams);
-		TotalOverlaps.Append(OutOverlaps);
+		OverlapLashSegment(TotalOverlaps, LashPointFrameStartLocations[Idx], CurrentPoint, Params, bUseCachedCandidates);
 	}
 
 	// If we detect nothing, clear the list of detected components
@@ -474,18 +517,10 @@ void UAsgardLashComponent::CollideWithActorsInLashSegments(float DeltaTime, floa
 	SCOPE_CYCLE_COUNTER(STAT_ASGARD_LashCollision);
 
 	// Initialize variables for trace
-	UWorld* World = GetWorld();
-	TArray<FHitResult> TotalHits;
 	FCollisionQueryParams Params;
-	Params.AddIgnoredActors(IgnoredActors);
-	if (bAutoIgnoreOwner)
-	{
-		Params.AddIgnoredActors(TArray<AActor*> {GetOwner()});
-	}
-	Params.TraceTag = FName("AsgardLashCollisionTest");
-	FCollisionResponseParams ResponseParams;
-	FCollisionShape CollisionShape = FCollisionShape::MakeSphere(CollisionRadius);
-	FQuat CollisionRotation = FQuat();
+	MakeCollisionQueryParams(Params, FName("AsgardLashCollisionTest"), false);
+	const bool bUseCachedCandidates = bUseCachedCollisionCandidates && GatherCollisionCandidates(Params);
+	TotalHits.Reset();
 
 	// For each lash segment
 	bLashBlocked = false;
@@ -494,18 +529,9 @@ void UAsgardLashComponent::CollideWithActorsInLashSegments(float DeltaTime, floa
 		UPrimitiveComponent* BlockingComponent = nullptr;
 
 		// Trace from the frame start position to the current position
-		TArray<FHitResult> HitsFromFrameStart;
 		FVector& FrameStart = LashPointFrameStartLocations[Idx];
-		FVector& CurrentPoint = LashPointLocations[Idx];
-		bool bHitFromFrameStart = World->SweepMultiByChannel(
-			HitsFromFrameStart,
-			FrameStart,
-			CurrentPoint,
-			CollisionRotation,
-			CollisionChannel,
-			CollisionShape,
-			Params,
-			ResponseParams);
+		FVector CurrentPoint = LashPointBuffer.Get(Idx);
+		bool bHitFromFrameStart = SweepLashPoint(HitsFromFrameStart, FrameStart, CurrentPoint, Params, bUseCachedCandidates);
 
 		// If hit from frame start and did not start penetrating, correct the point to the hit location offset by the skinwidth
 		FVector FrameStartTraceEndpoint;
@@ -528,17 +554,8 @@ void UAsgardLashComponent::CollideWithActorsInLashSegments(float DeltaTime, floa
 		}
 
 		// Trace from the previous segment
-		TArray<FHitResult> HitsFromPrevious;
-		FVector& PreviousPoint = LashPointLocations[Idx - 1];
-		bool bHitFromPrevious = World->SweepMultiByChannel(
-			HitsFromPrevious,
-			PreviousPoint,
-			FrameStartTraceEndpoint,
-			CollisionRotation,
-			CollisionChannel,
-			CollisionShape,
-			Params,
-			ResponseParams);
+		const FVector PreviousPoint = LashPointBuffer.Get(Idx - 1);
+		bool bHitFromPrevious = SweepLashPoint(HitsFromPrevious, PreviousPoint, FrameStartTraceEndpoint, Params, bUseCachedCandidates);
 
 		// If hit from the previous segment
 		FHitResult* FromPreviousHit = nullptr;
@@ -548,8 +565,8 @@ void UAsgardLashComponent::CollideWithActorsInLashSegments(float DeltaTime, floa
 			FromPreviousHit = &HitsFromPrevious.Last();
 			if (FromPreviousHit->bStartPenetrating)
 			{
-				LashPointLocations.SetNum(Idx, false);
-				LashPointSimulationStartLocations.SetNum(Idx, false);
+				LashPointBuffer.SetNum(Idx);
+				LashPointSimulationStartBuffer.SetNum(Idx);
 				LashPointFrameStartLocations.SetNum(Idx, false);
 				LashPointBlockingComponents.SetNum(Idx, false);
 				LashPointBlockingComponents[Idx - 1] = FromPreviousHit->Component.Get();
@@ -566,10 +583,9 @@ void UAsgardLashComponent::CollideWithActorsInLashSegments(float DeltaTime, floa
 
 				// Impart velocity from parent and gravity along the impact normal
 				// so that the point doesn't stick to the object it is colliding against
-				FVector& LastPoint = LashPointSimulationStartLocations[Idx];
-				FVector Correction = (PreviousPoint - LashPointSimulationStartLocations[Idx - 1]);
+				FVector Correction = (PreviousPoint - LashPointSimulationStartBuffer.Get(Idx - 1));
 				Correction += (Gravity * PhysicsStepTime);
-				LastPoint = CurrentPoint - (Correction * (1.0f - ChildPointCorrectionWeight));
+				LashPointSimulationStartBuffer.Set(Idx, CurrentPoint - (Correction * (1.0f - ChildPointCorrectionWeight)));
 				Correction = FVector::VectorPlaneProject(Correction, FromPreviousHit->ImpactNormal).GetSafeNormal() * Correction.Size() * ChildPointCorrectionWeight;
 				CurrentPoint = CurrentPoint + Correction;
 			}
@@ -612,7 +628,7 @@ void UAsgardLashComponent::CollideWithActorsInLashSegments(float DeltaTime, floa
 				//Correction = FVector::VectorPlaneProject(Correction, FromFrameStartHit->ImpactNormal).GetSafeNormal() * Correction.Size() * SlidingVelocityCorrectionWeight;
 				//CurrentPoint = CurrentPoint + Correction;
 
-				LashPointSimulationStartLocations[Idx] = CurrentPoint;
+				LashPointSimulationStartBuffer.Set(Idx, CurrentPoint);
 			}
 
 			// If hit from the previous point
@@ -625,7 +641,7 @@ void UAsgardLashComponent::CollideWithActorsInLashSegments(float DeltaTime, floa
 
 			// If the previous and next points are close enough for there to be one lash segment, remove the current point
 			if ((PreviousPoint - CurrentPoint).SizeSquared() < (LashCollisionMinSegmentLength * LashCollisionMinSegmentLength)
-				|| Idx < NumLashSegments && (LashPointLocations[Idx + 1] - PreviousPoint).SizeSquared() < (LashSegmentMaxLength * LashCollisionMinSegmentLength))
+				|| Idx < NumLashSegments && (LashPointBuffer.Get(Idx + 1) - PreviousPoint).SizeSquared() < (LashSegmentMaxLength * LashCollisionMinSegmentLength))
 			{
 				LashPointBlockingComponents[Idx - 1] = BlockingComponent;
 				RemoveLashSegmentAtIndex(Idx);
@@ -636,6 +652,8 @@ void UAsgardLashComponent::CollideWithActorsInLashSegments(float DeltaTime, floa
 			// Update the blocking component
 			LashPointBlockingComponents[Idx] = BlockingComponent;
 		}
+
+		LashPointBuffer.Set(Idx, CurrentPoint);
 	}
 
 	// If we detect nothing, clear the list of detected components
@@ -716,48 +734,222 @@ void UAsgardLashComponent::CollideWithActorsInLashSegments(float DeltaTime, floa
 	return;
 }
 
+void UAsgardLashComponent::MakeCollisionQueryParams(FCollisionQueryParams& OutParams, FName TraceTag, bool bIgnoreAttachedToActor) const
+{
+	OutParams.AddIgnoredActors(IgnoredActors);
+	if (bAutoIgnoreOwner)
+	{
+		OutParams.AddIgnoredActor(GetOwner());
+	}
+	if (bIgnoreAttachedToActor && AttachedToActor)
+	{
+		OutParams.AddIgnoredActor(AttachedToActor);
+	}
+	OutParams.TraceTag = TraceTag;
 
-// Called every frame
-void UAsgardLashComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+	return;
+}
+
+bool UAsgardLashComponent::GatherCollisionCandidates(const FCollisionQueryParams& Params)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	
-	// Update origin position
-	LashPointFrameStartLocations = LashPointLocations;
-	FVector& LashOrigin = LashPointLocations[0];
-	LashPointSimulationStartLocations[0] = LashOrigin;
-	LashOrigin = GetComponentLocation();
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_LashGatherCandidates);
 
-	// If there are lash segments extended
-	if (NumLashSegments > 0)
+	// Build bounds enclosing every shape the segments will be tested with this frame
+	// A segment capsule fits within a sphere around its center with a radius of its length plus the collision radius
+	FBox LashBounds(ForceInit);
+	const float MaxPointDisplacementSquared = FMath::Square(CachedCollisionMaxPointDisplacement);
+	for (int32 Idx = 1; Idx <= NumLashSegments; Idx++)
 	{
-		SCOPE_CYCLE_COUNTER(STAT_ASGARD_LashSimulateLash);
+		const FVector CurrentPoint = LashPointBuffer.Get(Idx);
+		const FVector PreviousPoint = LashPointBuffer.Get(Idx - 1);
+		const FVector& FrameStartLocation = LashPointFrameStartLocations[Idx];
 
-		// Calculate the number of physics steps
-		float PhysicsStepTime = 1.0f / PhysicsStepsPerSecond;
-		PhysicsStepRemainder += DeltaTime;
-		int32 NumPhysicsSteps = (int32)(PhysicsStepRemainder / PhysicsStepTime);
-		PhysicsStepRemainder -= (float)NumPhysicsSteps * PhysicsStepTime;
+		// If any point is moving too fast, the bounds would gather too many candidates, so fall back to full queries
+		if ((CurrentPoint - FrameStartLocation).SizeSquared() > MaxPointDisplacementSquared)
+		{
+			return false;
+		}
+
+		LashBounds += FBox::BuildAABB((CurrentPoint + PreviousPoint) * 0.5f, FVector((CurrentPoint - PreviousPoint).Size() + CollisionRadius));
+		LashBounds += FBox::BuildAABB((CurrentPoint + FrameStartLocation) * 0.5f, FVector((CurrentPoint - FrameStartLocation).Size() + CollisionRadius));
+	}
+	LashBounds = LashBounds.ExpandBy(CollisionSkinWidth);
+
+	// Gather every primitive that could be touched by the lash with a single query
+	INC_DWORD_STAT(STAT_ASGARD_LashSceneQueries);
+	CollisionCandidates.Reset();
+	GetWorld()->OverlapMultiByChannel(
+		CollisionCandidates,
+		LashBounds.GetCenter(),
+		FQuat::Identity,
+		CollisionChannel,
+		FCollisionShape::MakeBox(LashBounds.GetExtent()),
+		Params,
+		FCollisionResponseParams::DefaultResponseParam);
+	INC_DWORD_STAT_BY(STAT_ASGARD_LashCollisionCandidates, CollisionCandidates.Num());
+
+	return true;
+}
 
-		// If extended and not blocked
-		if (bLashExtended && !bLashBlocked)
+void UAsgardLashComponent::OverlapLashSegment(TArray<FOverlapResult>& OutOverlaps, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params, bool bUseCachedCandidates)
+{
+	// Cache variables
+	const FVector OverlapDirection = End - Start;
+	const FVector OverlapCenter = (End + Start) * 0.5f;
+	const FQuat OverlapRotation = FRotationMatrix::MakeFromZ(OverlapDirection).ToQuat();
+	const FCollisionShape CollisionShape = FCollisionShape::MakeCapsule(FVector(CollisionRadius, CollisionRadius, OverlapDirection.Size()));
+
+	// If using cached candidates, test each candidate locally
+	if (bUseCachedCandidates)
+	{
+		const float BoundingRadius = CollisionShape.GetCapsuleHalfHeight();
+		for (const FOverlapResult& Candidate : CollisionCandidates)
 		{
-			// For each physics steps
-			for (int32 Idx = 0; Idx < NumPhysicsSteps; Idx++)
+			UPrimitiveComponent* CandidateComponent = Candidate.Component.Get();
+			if (CandidateComponent)
 			{
-				// If more lash segments can be added and the last segment is of the minimum length, then add a segment
-				if (NumLashSegments < MaxLashSegments
-					&& LashPointBlockingComponents[NumLashSegments] == nullptr
-					&& (LashPointLocations[NumLashSegments] - LashPointLocations[NumLashSegments - 1]).SizeSquared() >= LashGrowthMinSegmentLength * LashGrowthMinSegmentLength)
+				// Reject by bounds before performing the more expensive shape test
+				const FBoxSphereBounds& CandidateBounds = CandidateComponent->Bounds;
+				if (FVector::DistSquared(CandidateBounds.Origin, OverlapCenter) <= FMath::Square(CandidateBounds.SphereRadius + BoundingRadius)
+					&& CandidateComponent->OverlapComponent(OverlapCenter, OverlapRotation, CollisionShape))
 				{
-					AddLashSegmentAtEnd();
+					OutOverlaps.Add(Candidate);
 				}
+			}
+		}
+	}
+
+	// Otherwise, query the scene
+	else
+	{
+		INC_DWORD_STAT(STAT_ASGARD_LashSceneQueries);
+		SegmentOverlaps.Reset();
+		GetWorld()->OverlapMultiByChannel(
+			SegmentOverlaps,
+			OverlapCenter,
+			OverlapRotation,
+			CollisionChannel,
+			CollisionShape,
+			Params,
+			FCollisionResponseParams::DefaultResponseParam);
+		OutOverlaps.Append(SegmentOverlaps);
+	}
 
-				// Update point velocities
+	return;
+}
+
+bool UAsgardLashComponent::SweepLashPoint(TArray<FHitResult>& OutHits, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params, bool bUseCachedCandidates)
+{
+	OutHits.Reset();
+	const FCollisionShape CollisionShape = FCollisionShape::MakeSphere(CollisionRadius);
+
+	// If not using cached candidates, query the scene
+	if (!bUseCachedCandidates)
+	{
+		INC_DWORD_STAT(STAT_ASGARD_LashSceneQueries);
+		return GetWorld()->SweepMultiByChannel(
+			OutHits,
+			Start,
+			End,
+			FQuat::Identity,
+			CollisionChannel,
+			CollisionShape,
+			Params,
+			FCollisionResponseParams::DefaultResponseParam);
+	}
+
+	// Otherwise, sweep against each candidate locally, keeping the nearest blocking hit
+	FHitResult CandidateHit;
+	FHitResult BlockingHit;
+	bool bBlockingHit = false;
+	for (const FOverlapResult& Candidate : CollisionCandidates)
+	{
+		UPrimitiveComponent* CandidateComponent = Candidate.Component.Get();
+		if (CandidateComponent && CandidateComponent->SweepComponent(CandidateHit, Start, End, FQuat::Identity, CollisionShape))
+		{
+			CandidateHit.Component = Candidate.Component;
+			CandidateHit.Actor = Candidate.Actor;
+			CandidateHit.bBlockingHit = Candidate.bBlockingHit;
+			if (!Candidate.bBlockingHit)
+			{
+				OutHits.Add(CandidateHit);
+			}
+			else if (!bBlockingHit || CandidateHit.Time < BlockingHit.Time)
+			{
+				BlockingHit = CandidateHit;
+				bBlockingHit = true;
+			}
+		}
+	}
+
+	// Match the results of a multi sweep, which ignores touches beyond the blocking hit and reports the blocking hit last
+	if (bBlockingHit)
+	{
+		OutHits.RemoveAllSwap([&BlockingHit](const FHitResult& Hit) { return Hit.Time > BlockingHit.Time; }, false);
+		OutHits.Add(BlockingHit);
+	}
+
+	return bBlockingHit;
+}
+
+
+void UAsgardLashComponent::SimulateLash(int32 NumPhysicsSteps, float PhysicsStepTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_LashSimulateLash);
+
+	// If extended and not blocked
+	if (bLashExtended && !bLashBlocked)
+	{
+		// For each physics steps
+		for (int32 Idx = 0; Idx < NumPhysicsSteps; Idx++)
+		{
+			// If more lash segments can be added and the last segment is of the minimum length, then add a segment
+			if (NumLashSegments < MaxLashSegments
+				&& LashPointBlockingComponents[NumLashSegments] == nullptr
+				&& (LashPointBuffer.Get(NumLashSegments) - LashPointBuffer.Get(NumLashSegments - 1)).SizeSquared() >= LashGrowthMinSegmentLength * LashGrowthMinSegmentLength)
+			{
+				AddLashSegmentAtEnd();
+			}
+
+			// Update point velocities
+			ApplyVelocityToLashPoints(PhysicsStepTime);
+
+			// If the last segment is attached to a component, apply constraints from the back to make the lash feel weighty
+			if (bSimulationAttached)
+			{
+				ApplyConstraintsToLashPointsFromBack();
+			}
+
+			// Otherwise, apply constrainst from the front so that it feels responsive
+			else
+			{
+				ApplyConstraintsToLashPointsFromFront();
+			}
+
+		}
+	}
+
+	// If not extended or blocked
+	else
+	{
+		float ShrinkSpeed = (bLashExtended ? LashShrinkSpeedBlocked : LashShrinkSpeedNotExtended);
+
+		// For each physic step while the lash has not fully shrunk
+		for (int32 Idx = 0; Idx < NumPhysicsSteps; Idx++)
+		{
+			// Shrink the lash
+			if (ShrinkLash(PhysicsStepTime, ShrinkSpeed))
+			{
+				break;
+			}
+			else
+			{
+				// If the lash has still not fully shrink, update point velocities and constraints
 				ApplyVelocityToLashPoints(PhysicsStepTime);
+				ApplyConstraintsToLashPointsFromBack();
 
 				// If the last segment is attached to a component, apply constraints from the back to make the lash feel weighty
-				if (AttachedToComponent)
+				if (bSimulationAttached)
 				{
 					ApplyConstraintsToLashPointsFromBack();
 				}
@@ -767,71 +959,140 @@ void UAsgardLashComponent::TickComponent(float DeltaTime, ELevelTick TickType, F
 				{
 					ApplyConstraintsToLashPointsFromFront();
 				}
-
 			}
 		}
+	}
+
+	return;
+}
+
+void UAsgardLashComponent::FinishLashSimulation(float DeltaTime, float PhysicsStepTime)
+{
+	// Apply any detach requested by the simulation
+	if (bSimulationDetachRequested)
+	{
+		DetachLashEndFromComponent();
+		bSimulationDetachRequested = false;
+	}
 
-		// If not extended or blocked
+	// If collision is enabled, run the appropriate collision checks
+	if (bEnableCollision && NumLashSegments > 0)
+	{
+		if (bBlockedByObjects)
+		{
+			CollideWithActorsInLashSegments(DeltaTime, PhysicsStepTime);
+		}
 		else
 		{
-			float ShrinkSpeed = (bLashExtended ? LashShrinkSpeedBlocked : LashShrinkSpeedNotExtended);
+			DetectActorsInLashSegments();
+		}
+	}
 
-			// For each physic step while the lash has not fully shrunk
-			for (int32 Idx = 0; Idx < NumPhysicsSteps; Idx++)
-			{
-				// Shrink the lash
-				if (ShrinkLash(PhysicsStepTime, ShrinkSpeed))
-				{
-					break;
-				}
-				else
-				{
-					// If the lash has still not fully shrink, update point velocities and constraints
-					ApplyVelocityToLashPoints(PhysicsStepTime);
-					ApplyConstraintsToLashPointsFromBack();
+	// Else, if objects are detected, clear them
+	else if (ComponentsInLash.Num() > 0)
+	{
+		for (UPrimitiveComponent* LostComponent : ComponentsInLash)
+		{
+			OnComponentExitLash.Broadcast(LostComponent);
+		}
+		for (AActor* LostActor : ActorsInLash)
+		{
+			OnActorExitLash.Broadcast(LostActor);
+		}
+		ComponentsInLash.Reset();
+		ActorsInLash.Reset();
+	}
 
-					// If the last segment is attached to a component, apply constraints from the back to make the lash feel weighty
-					if (AttachedToComponent)
-					{
-						ApplyConstraintsToLashPointsFromBack();
-					}
+	return;
+}
 
-					// Otherwise, apply constrainst from the front so that it feels responsive
-					else
-					{
-						ApplyConstraintsToLashPointsFromFront();
-					}
-				}
-			}
-		}
+void UAsgardLashComponent::WaitForAsyncSimulation()
+{
+	if (AsyncSimulationTask.IsValid())
+	{
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(AsyncSimulationTask, ENamedThreads::GameThread);
+		AsyncSimulationTask = nullptr;
+	}
+
+	return;
+}
+
+void UAsgardLashComponent::CompleteAsyncSimulation()
+{
+	WaitForAsyncSimulation();
+
+	// Collision and delegates are handled on the game thread once the simulation has completed
+	if (bAsyncSimulationPending)
+	{
+		bAsyncSimulationPending = false;
+		FinishLashSimulation(AsyncSimulationDeltaTime, AsyncSimulationPhysicsStepTime);
+		UpdateLashPointLocations();
+	}
+
+	return;
+}
+
+void UAsgardLashComponent::UpdateLashPointLocations()
+{
+	LashPointBuffer.CopyTo(LashPointLocations);
+
+	if (LashRenderComponent)
+	{
+		LashRenderComponent->SetLashPoints(LashPointLocations);
+	}
 
-		// If collision is enabled, run the appropriate collision checks
-		if (bEnableCollision && NumLashSegments > 0)
+	DRAW_LASH();
+
+	return;
+}
+
+
+// Called every frame
+void UAsgardLashComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Complete the previous simulation if it is somehow still outstanding
+	CompleteAsyncSimulation();
+	
+	// Update origin position
+	LashPointBuffer.CopyTo(LashPointFrameStartLocations);
+	LashPointSimulationStartBuffer.Set(0, LashPointBuffer.Get(0));
+	LashPointBuffer.Set(0, GetComponentLocation());
+
+	// If there are lash segments extended
+	if (NumLashSegments > 0)
+	{
+		// Calculate the number of physics steps
+		float PhysicsStepTime = 1.0f / PhysicsStepsPerSecond;
+		PhysicsStepRemainder += DeltaTime;
+		int32 NumPhysicsSteps = (int32)(PhysicsStepRemainder / PhysicsStepTime);
+		PhysicsStepRemainder -= (float)NumPhysicsSteps * PhysicsStepTime;
+
+		// Capture the attached location on the game thread, since the simulation may run off of it
+		bSimulationAttached = AttachedToComponent != nullptr;
+		if (bSimulationAttached)
 		{
-			if (bBlockedByObjects)
-			{
-				CollideWithActorsInLashSegments(DeltaTime, PhysicsStepTime);
-			}
-			else
-			{
-				DetectActorsInLashSegments();
-			}
+			SimulationAttachedLocation = AttachedToComponent->GetComponentTransform().TransformPositionNoScale(AttachOffset);
 		}
 
-		// Else, if objects are detected, clear them
-		else if (ComponentsInLash.Num() > 0)
+		// If simulating asynchronously, start the simulation on a worker and complete it later in the frame
+		if (bSimulateAsync && LashAsyncSimulation->GetInt() && SimulationCompletionTickFunction.IsTickFunctionEnabled())
 		{
-			for (UPrimitiveComponent* LostComponent : ComponentsInLash)
-			{
-				OnComponentExitLash.Broadcast(LostComponent);
-			}
-			for (AActor* LostActor : ActorsInLash)
-			{
-				OnActorExitLash.Broadcast(LostActor);
-			}
-			ComponentsInLash.Reset();
-			ActorsInLash.Reset();
+			bAsyncSimulationPending = true;
+			AsyncSimulationDeltaTime = DeltaTime;
+			AsyncSimulationPhysicsStepTime = PhysicsStepTime;
+			AsyncSimulationTask = FFunctionGraphTask::CreateAndDispatchWhenReady([this, NumPhysicsSteps, PhysicsStepTime]()
+				{
+					SimulateLash(NumPhysicsSteps, PhysicsStepTime);
+				},
+				TStatId(), nullptr, ENamedThreads::AnyHiPriThreadHiPriTask);
+
+			return;
 		}
+
+		SimulateLash(NumPhysicsSteps, PhysicsStepTime);
+		FinishLashSimulation(DeltaTime, PhysicsStepTime);
 	}
 
 	// Otherwise, if the lash is active
@@ -841,7 +1102,7 @@ void UAsgardLashComponent::TickComponent(float DeltaTime, ELevelTick TickType, F
 		AddLashSegmentAtEnd();
 	}
 
-	DRAW_LASH();
+	UpdateLashPointLocations();
 
 	return;
 }
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Components/SceneComponent.h"
+#include "WorldCollision.h"
 #include "AsgardLashComponent.generated.h"
 
 // Stats group
@@ -13,6 +14,83 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnComponentExitLashSignature, UPrim
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnActorEnterLashSignature, AActor*, DetectedActor, UPrimitiveComponent*, DetectedComponent, bool, bBlockingHit);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnActorExitLashSignature, AActor*, LostActor);
 
+// Forward declarations
+class UAsgardLashComponent;
+class UAsgardLashRenderComponent;
+
+/**
+ *	Tick function that completes a lash simulation running on a task graph worker, late in the frame.
+ */
+USTRUCT()
+struct FAsgardLashSimulationCompletionTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	/** The lash to complete the simulation of. */
+	UAsgardLashComponent* Target;
+
+	// FTickFunction
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	// ~FTickFunction
+};
+
+template<>
+struct TStructOpsTypeTraits<FAsgardLashSimulationCompletionTickFunction> : public TStructOpsTypeTraitsBase2<FAsgardLashSimulationCompletionTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ *	Structure of arrays storage for lash point locations.
+ *	Each axis is stored contiguously and 16-byte aligned so the simulation can integrate several points at once.
+ */
+struct FAsgardLashPointBuffer
+{
+	TArray<float, TAlignedHeapAllocator<16>> X;
+	TArray<float, TAlignedHeapAllocator<16>> Y;
+	TArray<float, TAlignedHeapAllocator<16>> Z;
+
+	FORCEINLINE int32 Num() const { return X.Num(); }
+	FORCEINLINE FVector Get(int32 Idx) const { return FVector(X[Idx], Y[Idx], Z[Idx]); }
+	FORCEINLINE FVector Last() const { return Get(X.Num() - 1); }
+	FORCEINLINE void Set(int32 Idx, const FVector& Location) { X[Idx] = Location.X; Y[Idx] = Location.Y; Z[Idx] = Location.Z; }
+
+	void Reserve(int32 Number);
+	void Add(const FVector& Location);
+	void RemoveAt(int32 Idx);
+	void SetNum(int32 NewNum);
+	void CopyTo(TArray<FVector>& OutLocations) const;
+
+	/**
+	* If two points are further apart than MaxLength, moves them together by the error.
+	* WeightA and WeightB are the portions of the error corrected by each point.
+	*/
+	FORCEINLINE void ConstrainDistance(int32 IdxA, int32 IdxB, float MaxLength, float WeightA, float WeightB)
+	{
+		const float DeltaX = X[IdxB] - X[IdxA];
+		const float DeltaY = Y[IdxB] - Y[IdxA];
+		const float DeltaZ = Z[IdxB] - Z[IdxA];
+		const float DistanceSquared = (DeltaX * DeltaX) + (DeltaY * DeltaY) + (DeltaZ * DeltaZ);
+		if (DistanceSquared > MaxLength * MaxLength)
+		{
+			const float Distance = FMath::Sqrt(DistanceSquared);
+			const float ErrorScale = (Distance - MaxLength) / Distance;
+			const float ScaleA = ErrorScale * WeightA;
+			const float ScaleB = ErrorScale * WeightB;
+			X[IdxA] += DeltaX * ScaleA;
+			Y[IdxA] += DeltaY * ScaleA;
+			Z[IdxA] += DeltaZ * ScaleA;
+			X[IdxB] -= DeltaX * ScaleB;
+			Y[IdxB] -= DeltaY * ScaleB;
+			Z[IdxB] -= DeltaZ * ScaleB;
+		}
+	}
+};
+
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class ASGARD_API UAsgardLashComponent : public USceneComponent
@@ -26,6 +104,9 @@ public:
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
+	// Registers the simulation completion tick function alongside the primary tick function
+	virtual void RegisterComponentTickFunctions(bool bRegister) override;
+
 	// ---------------------------------------------------------
 	//	Physics settings
 
@@ -95,6 +176,16 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|LashComponent", meta = (AllowPrivateAccess = "true"))
 	float AttachMaxStretchDistance;
 
+	// ---------------------------------------------------------
+	//	Render settings
+
+	/**
+	* Component to render the lash with, if any.
+	* Receives the lash points whenever they are updated, and draws the whole lash in a single draw call.
+	*/
+	UPROPERTY(BlueprintReadWrite, Category = "Asgard|LashComponent|Render")
+	UAsgardLashRenderComponent* LashRenderComponent;
+
 	// ---------------------------------------------------------
 	//	Editor debug
 
@@ -130,7 +221,12 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 private:
+	friend struct FAsgardLashSimulationCompletionTickFunction;
+
 	// ---------------------------------------------------------
 	//	Lash settings
 
@@ -175,6 +271,13 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Asgard|LashComponent", meta = (AllowPrivateAccess = "true", ClampMin = "0.0"))
 	float LashShrinkMaxSegmentLength;
 
+	/**
+	* Whether to run the lash simulation on a task graph worker, completing it late in the frame.
+	* Collision, detection, and their delegates are still handled on the game thread once the simulation completes.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Asgard|LashComponent", meta = (AllowPrivateAccess = "true"))
+	bool bSimulateAsync;
+
 	// ---------------------------------------------------------
 	//	Collision Settings
 
@@ -205,6 +308,19 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|LashComponent", meta = (AllowPrivateAccess = "true", ClampMin = "0.0", ClampMax = "1.0"))
 	float BlockdPointCorrectionWeight;
 
+	/**
+	* Whether to gather collision candidates with a single query around the whole lash each frame, and then test each segment against those candidates locally.
+	* Much cheaper than querying the scene for every segment, unless the lash covers a large area.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|LashComponent|Collision", meta = (AllowPrivateAccess = "true"))
+	bool bUseCachedCollisionCandidates;
+
+	/**
+	* When using cached collision candidates, the distance any lash point may move in a frame before falling back to querying the scene for every segment.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|LashComponent|Collision", meta = (AllowPrivateAccess = "true", ClampMin = "0.0", EditCondition = "bUseCachedCollisionCandidates"))
+	float CachedCollisionMaxPointDisplacement;
+
 
 	// ---------------------------------------------------------
 	//	Lash state
@@ -217,14 +333,19 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Asgard|LashComponent", meta = (AllowPrivateAccess = "true"))
 	TArray<FVector> LashPointFrameStartLocations;
 
-	/** The position of each lash point at the start of the last physics simulation. */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Asgard|LashComponent", meta = (AllowPrivateAccess = "true"))
-	TArray<FVector> LashPointSimulationStartLocations;
-
-	/** The current position of each lash point. */
+	/**
+	* The current position of each lash point.
+	* Copied from LashPointBuffer at the end of every frame.
+	*/
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Asgard|LashComponent", meta = (AllowPrivateAccess = "true"))
 	TArray<FVector> LashPointLocations;
 
+	/** The current position of each lash point, used by the simulation. */
+	FAsgardLashPointBuffer LashPointBuffer;
+
+	/** The position of each lash point at the start of the last physics simulation. */
+	FAsgardLashPointBuffer LashPointSimulationStartBuffer;
+
 	/**
 	* If a lash segment is blocked, the component is stored here.
 	* Otherwise, it is null.
@@ -265,6 +386,48 @@ private:
 	UPROPERTY()
 	TSet<AActor*> ActorsInLash;
 
+	/** Completes the async simulation late in the frame. */
+	FAsgardLashSimulationCompletionTickFunction SimulationCompletionTickFunction;
+
+	/** Task running the current async simulation, if any. */
+	FGraphEventRef AsyncSimulationTask;
+
+	/** Whether an async simulation has been started and not yet completed. */
+	bool bAsyncSimulationPending;
+
+	/** Frame delta time of the pending async simulation. */
+	float AsyncSimulationDeltaTime;
+
+	/** Physics step time of the pending async simulation. */
+	float AsyncSimulationPhysicsStepTime;
+
+	/** Whether the end of the lash is attached to a component during the current simulation. */
+	bool bSimulationAttached;
+
+	/** Designated location of the end of the lash during the current simulation, if attached. */
+	FVector SimulationAttachedLocation;
+
+	/** Whether the current simulation stretched too far and the end of the lash should be detached once it completes. */
+	bool bSimulationDetachRequested;
+
+	/** Primitives that may collide with the lash this frame, when using cached collision candidates. */
+	TArray<FOverlapResult> CollisionCandidates;
+
+	/** Results of the current segment overlap test. Persistent to avoid reallocating every frame. */
+	TArray<FOverlapResult> SegmentOverlaps;
+
+	/** Results of every segment overlap test this frame. Persistent to avoid reallocating every frame. */
+	TArray<FOverlapResult> TotalOverlaps;
+
+	/** Results of the current sweep from the frame start location. Persistent to avoid reallocating every frame. */
+	TArray<FHitResult> HitsFromFrameStart;
+
+	/** Results of the current sweep from the previous point. Persistent to avoid reallocating every frame. */
+	TArray<FHitResult> HitsFromPrevious;
+
+	/** Results of every collision sweep this frame. Persistent to avoid reallocating every frame. */
+	TArray<FHitResult> TotalHits;
+
 	/** Actor that the end of the lash is attached to (if any). */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Asgard|LashComponent", meta = (AllowPrivateAccess = "true"))
 	AActor* AttachedToActor;
@@ -312,4 +475,37 @@ private:
 	* Adjusts the position of the lash in the case of blocking hits.
 	*/
 	void CollideWithActorsInLashSegments(float DeltaTime, float PhysicsStepTime);
+
+	/** Steps the point simulation. Only touches lash state, so it can run off the game thread. */
+	void SimulateLash(int32 NumPhysicsSteps, float PhysicsStepTime);
+
+	/** Applies deferred results of the simulation, and runs collision and detection. */
+	void FinishLashSimulation(float DeltaTime, float PhysicsStepTime);
+
+	/** Blocks until the async simulation task, if any, has finished. */
+	void WaitForAsyncSimulation();
+
+	/** Finishes the pending async simulation, if any. */
+	void CompleteAsyncSimulation();
+
+	/** Copies the simulated points out for gameplay and rendering. */
+	void UpdateLashPointLocations();
+
+	/** Initializes the query params shared by all lash collision and detection queries. */
+	void MakeCollisionQueryParams(FCollisionQueryParams& OutParams, FName TraceTag, bool bIgnoreAttachedToActor) const;
+
+	/**
+	* Gathers the primitives that may collide with the lash this frame with a single query.
+	* Returns false if the lash is moving too fast for the candidates to be useful.
+	*/
+	bool GatherCollisionCandidates(const FCollisionQueryParams& Params);
+
+	/** Appends the overlaps of a capsule spanning from start to end. */
+	void OverlapLashSegment(TArray<FOverlapResult>& OutOverlaps, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params, bool bUseCachedCandidates);
+
+	/**
+	* Sweeps a lash point from start to end, with the same results as a multi sweep.
+	* Returns whether there was a blocking hit.
+	*/
+	bool SweepLashPoint(TArray<FHitResult>& OutHits, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params, bool bUseCachedCandidates);
 };
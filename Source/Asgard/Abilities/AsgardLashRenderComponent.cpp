@@ -0,0 +1,230 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "AsgardLashRenderComponent.h"
+#include "Asgard/Abilities/AsgardLashComponent.h"
+#include "DynamicMeshBuilder.h"
+#include "MaterialShared.h"
+#include "Materials/Material.h"
+#include "PrimitiveSceneProxy.h"
+#include "SceneManagement.h"
+
+// Stat cycles
+DECLARE_CYCLE_STAT(TEXT("AsgardLash BuildTubeMesh"), STAT_ASGARD_LashBuildTubeMesh, STATGROUP_ASGARD_Lash);
+
+/**
+ *	Scene proxy that generates the tube mesh for a lash on the render thread.
+ */
+class FAsgardLashRenderSceneProxy final : public FPrimitiveSceneProxy
+{
+public:
+	SIZE_T GetTypeHash() const override
+	{
+		static size_t UniquePointer;
+		return reinterpret_cast<size_t>(&UniquePointer);
+	}
+
+	FAsgardLashRenderSceneProxy(UAsgardLashRenderComponent* Component)
+		: FPrimitiveSceneProxy(Component)
+		, Material(Component->GetMaterial(0))
+		, MaterialRelevance(Component->GetMaterialRelevance(GetScene().GetFeatureLevel()))
+		, TubeRadius(Component->TubeRadius)
+		, NumTubeSides(FMath::Clamp(Component->NumTubeSides, 3, 32))
+		, LashPoints(Component->LocalLashPoints)
+	{
+		if (!Material)
+		{
+			Material = UMaterial::GetDefaultMaterial(MD_Surface);
+		}
+	}
+
+	/** Replaces the lash points with new ones uploaded from the game thread. */
+	void SetLashPoints_RenderThread(TArray<FVector>&& NewLashPoints)
+	{
+		check(IsInRenderingThread());
+		LashPoints = MoveTemp(NewLashPoints);
+	}
+
+	virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override
+	{
+		if (LashPoints.Num() < 2)
+		{
+			return;
+		}
+
+		SCOPE_CYCLE_COUNTER(STAT_ASGARD_LashBuildTubeMesh);
+
+		// Build the tube once and share it between views
+		FDynamicMeshBuilder MeshBuilder(Views[0]->GetFeatureLevel());
+		BuildTubeMesh(MeshBuilder);
+
+		const FMaterialRenderProxy* MaterialProxy = Material->GetRenderProxy();
+		for (int32 ViewIdx = 0; ViewIdx < Views.Num(); ViewIdx++)
+		{
+			if (VisibilityMap & (1 << ViewIdx))
+			{
+				MeshBuilder.GetMesh(GetLocalToWorld(), MaterialProxy, SDPG_World, false, false, ViewIdx, Collector);
+			}
+		}
+
+		return;
+	}
+
+	virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
+	{
+		FPrimitiveViewRelevance Result;
+		Result.bDrawRelevance = IsShown(View);
+		Result.bShadowRelevance = IsShadowCast(View);
+		Result.bDynamicRelevance = true;
+		Result.bRenderInMainPass = ShouldRenderInMainPass();
+		Result.bUsesLightingChannels = GetLightingChannelMask() != GetDefaultLightingChannelMask();
+		Result.bRenderCustomDepth = ShouldRenderCustomDepth();
+		MaterialRelevance.SetPrimitiveViewRelevance(Result);
+		Result.bVelocityRelevance = IsMovable() && Result.bOpaque && Result.bRenderInMainPass;
+		return Result;
+	}
+
+	virtual uint32 GetMemoryFootprint() const override
+	{
+		return sizeof(*this) + GetAllocatedSize();
+	}
+
+	uint32 GetAllocatedSize() const
+	{
+		return FPrimitiveSceneProxy::GetAllocatedSize() + LashPoints.GetAllocatedSize();
+	}
+
+private:
+	UMaterialInterface* Material;
+	FMaterialRelevance MaterialRelevance;
+	float TubeRadius;
+	int32 NumTubeSides;
+	TArray<FVector> LashPoints;
+
+	/** Generates a ring of vertices around each lash point and joins neighbouring rings with quads. */
+	void BuildTubeMesh(FDynamicMeshBuilder& MeshBuilder) const
+	{
+		// Cache variables
+		const int32 NumPoints = LashPoints.Num();
+		const int32 NumRingVertices = NumTubeSides + 1;
+		MeshBuilder.ReserveVertices(NumPoints * NumRingVertices);
+		MeshBuilder.ReserveTriangles((NumPoints - 1) * NumTubeSides * 2);
+
+		// Parallel transport the ring orientation down the lash so the tube does not twist
+		FVector Tangent = (LashPoints[1] - LashPoints[0]).GetSafeNormal();
+		FVector RingNormal = FVector::CrossProduct(Tangent, FMath::Abs(Tangent.Z) < 0.99f ? FVector::UpVector : FVector::ForwardVector).GetSafeNormal();
+		float DistanceAlongLash = 0.0f;
+
+		for (int32 Idx = 0; Idx < NumPoints; Idx++)
+		{
+			// Use the direction between the neighbouring points as the tangent
+			const FVector& PreviousPoint = LashPoints[FMath::Max(Idx - 1, 0)];
+			const FVector& NextPoint = LashPoints[FMath::Min(Idx + 1, NumPoints - 1)];
+			const FVector NewTangent = (NextPoint - PreviousPoint).GetSafeNormal();
+			if (!NewTangent.IsNearlyZero())
+			{
+				Tangent = NewTangent;
+				const FVector ProjectedNormal = FVector::VectorPlaneProject(RingNormal, Tangent).GetSafeNormal();
+				RingNormal = ProjectedNormal.IsNearlyZero() ? RingNormal : ProjectedNormal;
+			}
+			const FVector RingBinormal = FVector::CrossProduct(Tangent, RingNormal);
+
+			if (Idx > 0)
+			{
+				DistanceAlongLash += (LashPoints[Idx] - LashPoints[Idx - 1]).Size();
+			}
+
+			// Add the ring of vertices, duplicating the first so the texture wraps cleanly
+			for (int32 SideIdx = 0; SideIdx < NumRingVertices; SideIdx++)
+			{
+				float SinAngle;
+				float CosAngle;
+				FMath::SinCos(&SinAngle, &CosAngle, (2.0f * PI * SideIdx) / NumTubeSides);
+				const FVector VertexNormal = (RingNormal * CosAngle) + (RingBinormal * SinAngle);
+				MeshBuilder.AddVertex(FDynamicMeshVertex(
+					LashPoints[Idx] + (VertexNormal * TubeRadius),
+					Tangent,
+					VertexNormal,
+					FVector2D((float)SideIdx / NumTubeSides, DistanceAlongLash / (2.0f * PI * TubeRadius)),
+					FColor::White));
+			}
+
+			// Join this ring to the previous ring
+			if (Idx > 0)
+			{
+				const int32 PreviousRingStart = (Idx - 1) * NumRingVertices;
+				const int32 RingStart = Idx * NumRingVertices;
+				for (int32 SideIdx = 0; SideIdx < NumTubeSides; SideIdx++)
+				{
+					MeshBuilder.AddTriangle(PreviousRingStart + SideIdx, PreviousRingStart + SideIdx + 1, RingStart + SideIdx);
+					MeshBuilder.AddTriangle(PreviousRingStart + SideIdx + 1, RingStart + SideIdx + 1, RingStart + SideIdx);
+				}
+			}
+		}
+
+		return;
+	}
+};
+
+
+// Sets default values for this component's properties
+UAsgardLashRenderComponent::UAsgardLashRenderComponent(const FObjectInitializer& ObjectInitializer /*= FObjectInitializer::Get()*/)
+	:Super(ObjectInitializer)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	TubeRadius = 0.5f;
+	NumTubeSides = 6;
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetGenerateOverlapEvents(false);
+}
+
+FPrimitiveSceneProxy* UAsgardLashRenderComponent::CreateSceneProxy()
+{
+	return new FAsgardLashRenderSceneProxy(this);
+}
+
+FBoxSphereBounds UAsgardLashRenderComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	if (LocalLashPoints.Num() <= 0)
+	{
+		return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.0f);
+	}
+
+	FBox LocalBounds(LocalLashPoints);
+	return FBoxSphereBounds(LocalBounds.ExpandBy(TubeRadius)).TransformBy(LocalToWorld);
+}
+
+void UAsgardLashRenderComponent::SetLashPoints(const TArray<FVector>& WorldLocations)
+{
+	// Store the points relative to this component, so the scene proxy can render them with its local to world transform
+	const FTransform& SelfTransform = GetComponentTransform();
+	LocalLashPoints.SetNumUninitialized(WorldLocations.Num(), false);
+	for (int32 Idx = 0; Idx < WorldLocations.Num(); Idx++)
+	{
+		LocalLashPoints[Idx] = SelfTransform.InverseTransformPosition(WorldLocations[Idx]);
+	}
+
+	// Bounds are sent with the transform, and the points with the dynamic data
+	UpdateBounds();
+	MarkRenderTransformDirty();
+	MarkRenderDynamicDataDirty();
+
+	return;
+}
+
+void UAsgardLashRenderComponent::SendRenderDynamicData_Concurrent()
+{
+	Super::SendRenderDynamicData_Concurrent();
+
+	if (SceneProxy)
+	{
+		FAsgardLashRenderSceneProxy* LashSceneProxy = static_cast<FAsgardLashRenderSceneProxy*>(SceneProxy);
+		TArray<FVector> LashPoints = LocalLashPoints;
+		ENQUEUE_RENDER_COMMAND(AsgardSetLashPoints)(
+			[LashSceneProxy, LashPoints = MoveTemp(LashPoints)](FRHICommandListImmediate& RHICmdList) mutable
+			{
+				LashSceneProxy->SetLashPoints_RenderThread(MoveTemp(LashPoints));
+			});
+	}
+
+	return;
+}
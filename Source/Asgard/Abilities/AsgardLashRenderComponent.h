@@ -0,0 +1,50 @@
+// Copyright © 2020 Justin Camden All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/MeshComponent.h"
+#include "AsgardLashRenderComponent.generated.h"
+
+/**
+ *	Component that renders a lash as a single tube mesh in one draw call.
+ *	Only the lash points are sent to the render thread, where the tube geometry is generated every frame.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class ASGARD_API UAsgardLashRenderComponent : public UMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UAsgardLashRenderComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	// UPrimitiveComponent
+	virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+	virtual int32 GetNumMaterials() const override { return 1; }
+	// ~UPrimitiveComponent
+
+	/** Radius of the rendered tube. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Asgard|LashRenderComponent", meta = (ClampMin = "0.01"))
+	float TubeRadius;
+
+	/** Number of sides around the rendered tube. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Asgard|LashRenderComponent", meta = (ClampMin = "3", ClampMax = "32"))
+	int32 NumTubeSides;
+
+	/** Sets the world space locations of the lash points to render. */
+	UFUNCTION(BlueprintCallable, Category = "Asgard|LashRenderComponent")
+	void SetLashPoints(const TArray<FVector>& WorldLocations);
+
+protected:
+	// UActorComponent
+	virtual void SendRenderDynamicData_Concurrent() override;
+	// ~UActorComponent
+
+private:
+	friend class FAsgardLashRenderSceneProxy;
+
+	/** Lash points in the local space of this component. */
+	TArray<FVector> LocalLashPoints;
+};
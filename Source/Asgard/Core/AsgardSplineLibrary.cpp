@@ -2,6 +2,432 @@
 
 #include "AsgardSplineLibrary.h"
 #include "Runtime/Engine/Classes/Components/SplineMeshComponent.h"
+#include "Async/ParallelFor.h"
+
+// Stat cycles
+DECLARE_CYCLE_STAT(TEXT("AsgardSplineLibrary FixSplineTwistInRange"), STAT_ASGARD_SplineLibraryFixSplineTwistInRange, STATGROUP_ASGARD_SplineLibrary);
+DECLARE_CYCLE_STAT(TEXT("AsgardSplineLibrary MatchSplineMeshes"), STAT_ASGARD_SplineLibraryMatchSplineMeshes, STATGROUP_ASGARD_SplineLibrary);
+
+// Console variable setup so we can tune parallel spline mesh evaluation from the console
+static TAutoConsoleVariable<int32> CVarAsgardSplineMeshParallelThreshold(
+	TEXT("Asgard.SplineMeshParallelThreshold"),
+	32,
+	TEXT("The number of spline mesh segments at which segment transforms are evaluated in parallel.\n")
+	TEXT("<= 0: Never evaluate in parallel"),
+	ECVF_Scalability);
+static const auto SplineMeshParallelThreshold = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.SplineMeshParallelThreshold"));
+
+namespace AsgardSplineLibrary
+{
+	// Number of offset spline samples per corrected spline segment, used when searching for the closest offset location
+	static const float OffsetSamplesPerSegment = 4.0f;
+
+	// Number of passes used to fit the offset spline tangents to the base spline
+	static const int32 NumTangentFixPasses = 3;
+
+	// Tolerances below which corrected spline points are considered unchanged
+	static const float CorrectedLocationTolerance = 0.01f;
+	static const float CorrectedDirectionTolerance = 0.001f;
+
+	/** Spline mesh settings for a single segment, evaluated before being applied to the spline mesh. */
+	struct FSplineMeshSegment
+	{
+		FVector StartLocation;
+		FVector StartTangent;
+		FVector EndLocation;
+		FVector EndTangent;
+		FVector UpDirection;
+		float StartRoll;
+		float EndRoll;
+	};
+
+	/** Evaluates the spline mesh settings for a segment. Only reads from the sampler, so it is safe to call from any thread. */
+	static void CalculateSplineMeshSegment(const FAsgardSplineSampler& Sampler, int32 SegmentIndex, float SegmentLength, float Roll, FSplineMeshSegment& OutSegment)
+	{
+		UAsgardSplineLibrary::CalculateSplineSegmentStartAndEnd(
+			Sampler,
+			OutSegment.StartLocation,
+			OutSegment.StartTangent,
+			OutSegment.EndLocation,
+			OutSegment.EndTangent,
+			SegmentIndex,
+			SegmentLength,
+			ESplineCoordinateSpace::Local);
+
+		FVector UpDirection = Sampler.GetUpVectorAtDistanceAlongSpline(SegmentIndex * SegmentLength, ESplineCoordinateSpace::World);
+		OutSegment.UpDirection = Sampler.GetOwnerTransform().InverseTransformVectorNoScale(UpDirection);
+
+		float Rotation = UAsgardSplineLibrary::CalculateSplineUpRotation(Sampler, SegmentIndex, SegmentLength);
+
+		Roll = FMath::DegreesToRadians(Roll);
+		OutSegment.StartRoll = FMath::DegreesToRadians(Roll);
+		OutSegment.EndRoll = Rotation + Roll;
+
+		return;
+	}
+
+	/** Applies evaluated settings to a spline mesh. */
+	static void ApplySplineMeshSegment(const FSplineMeshSegment& Segment, USplineMeshComponent* SplineMesh, const FVector2D& StartScale, const FVector2D& EndScale, bool bUpdateMesh)
+	{
+		SplineMesh->SetStartAndEnd(Segment.StartLocation, Segment.StartTangent, Segment.EndLocation, Segment.EndTangent, false);
+		SplineMesh->SetSplineUpDir(Segment.UpDirection, true);
+		SplineMesh->SetStartRoll(Segment.StartRoll, false);
+		SplineMesh->SetEndRoll(Segment.EndRoll, false);
+		SplineMesh->SetStartScale(StartScale, false);
+		SplineMesh->SetEndScale(EndScale, false);
+
+		if (bUpdateMesh)
+		{
+			SplineMesh->UpdateMesh();
+		}
+
+		return;
+	}
+
+	/** Places the offset spline point for a base spline point, either adding it or moving the existing point. */
+	static void PlaceOffsetSplinePoint(const USplineComponent* BaseSpline, USplineComponent* OffsetSpline, int32 Idx, float RotFromUp, float OffsetDist, bool bAddPoint)
+	{
+		ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
+		FVector UpVectorScaled = OffsetDist * (BaseSpline->GetUpVectorAtSplinePoint(Idx, CoordinateSpace));
+		FVector TanAtPoint = (BaseSpline->GetTangentAtSplinePoint(Idx, CoordinateSpace));
+		FVector OffsetVector = UpVectorScaled.RotateAngleAxis(RotFromUp, TanAtPoint.GetSafeNormal());
+		FVector PointLocation = OffsetVector + (BaseSpline->GetLocationAtSplinePoint(Idx, CoordinateSpace));
+		if (bAddPoint)
+		{
+			OffsetSpline->AddSplinePointAtIndex(PointLocation, Idx, CoordinateSpace, false);
+		}
+		else
+		{
+			OffsetSpline->SetLocationAtSplinePoint(Idx, PointLocation, CoordinateSpace, false);
+		}
+
+		OffsetSpline->SetTangentAtSplinePoint(Idx, TanAtPoint, CoordinateSpace, false);
+
+		OffsetSpline->SetSplinePointType(Idx, BaseSpline->GetSplinePointType(Idx), false);
+
+		return;
+	}
+
+	/** Scales the offset spline tangents in a range of points so its segments keep the proportions of the base spline. */
+	static void FixOffsetSplineTangents(const USplineComponent* BaseSpline, USplineComponent* OffsetSpline, int32 FirstIdx, int32 LastFixIdx)
+	{
+		ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
+		int32 LastIdx = BaseSpline->GetNumberOfSplinePoints() - 1;
+		FVector ArriveTan;
+		FVector LeaveTan;
+		FVector BaseTan;
+		int32 ArriveIndex;
+		int32 ArriveLoopingIdx;
+		int32 LeaveLoopingIdx;
+		for (int32 OuterIdx = 0; OuterIdx < NumTangentFixPasses; OuterIdx++)
+		{
+			for (int InnerIdx = FirstIdx; InnerIdx <= LastFixIdx; InnerIdx++)
+			{
+				BaseTan = BaseSpline->GetTangentAtSplinePoint(InnerIdx, CoordinateSpace);
+
+				ArriveIndex = FMath::Clamp(int32(InnerIdx - 1), 0, int32(LastIdx + 1));
+				ArriveLoopingIdx = ((InnerIdx - 1) < 0 ? LastIdx : 0);
+				ArriveTan = BaseTan * ((OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
+										(OffsetSpline->GetDistanceAlongSplineAtSplinePoint(ArriveIndex) +
+										OffsetSpline->GetDistanceAlongSplineAtSplinePoint(ArriveLoopingIdx))) /
+										(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
+										(BaseSpline->GetDistanceAlongSplineAtSplinePoint(ArriveIndex) +
+										BaseSpline->GetDistanceAlongSplineAtSplinePoint(ArriveLoopingIdx))));
+
+				LeaveLoopingIdx = (LastIdx == InnerIdx ? 1 : 0);
+				LeaveTan = BaseTan * ((OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
+										(OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx + 1) +
+										(OffsetSpline->GetSplineLength() * LeaveLoopingIdx))) /
+										(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
+										(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx + 1) +
+										(BaseSpline->GetSplineLength() * LeaveLoopingIdx))));
+
+				OffsetSpline->SetTangentsAtSplinePoint(InnerIdx, ArriveTan, LeaveTan, CoordinateSpace, false);
+			}
+			OffsetSpline->UpdateSpline();
+		}
+
+		return;
+	}
+
+	/**
+	* Resamples the corrected spline in place, only writing the points that moved.
+	* Points are compared against the values they were last set to, since the spline orthogonalizes the up vectors it returns.
+	* Outputs the range of segments touching a moved point, or an empty range if nothing moved.
+	*/
+	static void UpdateCorrectedSpline(
+		const FAsgardSplineSampler& BaseSampler,
+		const FAsgardSplineSampler& OffsetSampler,
+		USplineComponent* CorrectedSpline,
+		int32 NumSegments,
+		float SegmentLength,
+		bool bClosedLoop,
+		int32& OutFirstDirtySegment,
+		int32& OutLastDirtySegment)
+	{
+		// If the number of points changed, every segment is dirty anyway
+		int32 LastIdx = NumSegments + (bClosedLoop ? -1 : 0);
+		if (CorrectedSpline->GetNumberOfSplinePoints() != LastIdx + 1 || !BaseSampler.IsValid() || !OffsetSampler.IsValid())
+		{
+			UAsgardSplineLibrary::BuildCorrectedSpline(BaseSampler, OffsetSampler, CorrectedSpline, NumSegments, SegmentLength, bClosedLoop);
+			OutFirstDirtySegment = 0;
+			OutLastDirtySegment = NumSegments - 1;
+			return;
+		}
+
+		int32 FirstMovedIdx = INDEX_NONE;
+		int32 LastMovedIdx = INDEX_NONE;
+		int32 OffsetSampleHint = INDEX_NONE;
+		FVector Location;
+		FVector UpVector;
+		FVector Tangent;
+		ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
+		const FTransform& CorrectedTransform = CorrectedSpline->GetComponentTransform();
+		const TArray<FInterpCurvePoint<FVector>>& PositionPoints = CorrectedSpline->SplineCurves.Position.Points;
+		const TArray<FInterpCurvePoint<FQuat>>& RotationPoints = CorrectedSpline->SplineCurves.Rotation.Points;
+		for (int32 Idx = 0; Idx <= LastIdx; Idx++)
+		{
+			Location = BaseSampler.GetLocationAtDistanceAlongSpline(Idx * SegmentLength, CoordinateSpace);
+			UpVector = (OffsetSampler.FindLocationClosestToWorldLocation(Location, OffsetSampleHint) - Location).GetSafeNormal();
+			Tangent = SegmentLength * ((BaseSampler.GetTangentAtDistanceAlongSpline(Idx * SegmentLength, CoordinateSpace)).GetSafeNormal());
+
+			// Compare in local space against the stored point, the same way the setters below convert their inputs
+			const FVector StoredUpVector = RotationPoints[Idx].OutVal.RotateVector(CorrectedSpline->DefaultUpVector);
+			if (!CorrectedTransform.InverseTransformPosition(Location).Equals(PositionPoints[Idx].OutVal, CorrectedLocationTolerance)
+				|| !CorrectedTransform.InverseTransformVector(UpVector).GetSafeNormal().Equals(StoredUpVector, CorrectedDirectionTolerance)
+				|| !CorrectedTransform.InverseTransformVector(Tangent).Equals(PositionPoints[Idx].LeaveTangent, CorrectedLocationTolerance))
+			{
+				CorrectedSpline->SetLocationAtSplinePoint(Idx, Location, CoordinateSpace, false);
+				CorrectedSpline->SetUpVectorAtSplinePoint(Idx, UpVector, CoordinateSpace, false);
+				CorrectedSpline->SetTangentAtSplinePoint(Idx, Tangent, CoordinateSpace, false);
+				FirstMovedIdx = FirstMovedIdx == INDEX_NONE ? Idx : FirstMovedIdx;
+				LastMovedIdx = Idx;
+			}
+		}
+
+		if (FirstMovedIdx == INDEX_NONE)
+		{
+			OutFirstDirtySegment = 0;
+			OutLastDirtySegment = -1;
+			return;
+		}
+		CorrectedSpline->UpdateSpline();
+
+		// Each segment spans from its point to the next, so the segment ending at the first moved point is dirty too
+		OutFirstDirtySegment = FMath::Max(FirstMovedIdx - 1, 0);
+		OutLastDirtySegment = FMath::Min(LastMovedIdx, NumSegments - 1);
+		if (bClosedLoop && FirstMovedIdx == 0)
+		{
+			OutLastDirtySegment = NumSegments - 1;
+		}
+
+		return;
+	}
+}
+
+FAsgardSplineSampler::FAsgardSplineSampler()
+{
+	SampleSpacing = 1.0f;
+	SplineLength = 0.0f;
+}
+
+void FAsgardSplineSampler::Build(const USplineComponent* Spline, float InSampleSpacing)
+{
+	checkf(Spline != nullptr, TEXT("FAsgardSplineSampler::Build failed! Spline was null."));
+
+	Locations.Reset();
+	Tangents.Reset();
+	UpVectors.Reset();
+	ComponentTransform = Spline->GetComponentTransform();
+	OwnerTransform = Spline->GetOwner() ? Spline->GetOwner()->GetActorTransform() : FTransform::Identity;
+	SplineLength = Spline->GetSplineLength();
+	if (SplineLength <= 0.0f)
+	{
+		return;
+	}
+
+	// Adjust the spacing so that the last sample lands on the end of the spline
+	const int32 NumIntervals = CalculateNumIntervals(SplineLength, InSampleSpacing);
+	SampleSpacing = SplineLength / NumIntervals;
+	Locations.SetNumUninitialized(NumIntervals + 1);
+	Tangents.SetNumUninitialized(NumIntervals + 1);
+	UpVectors.SetNumUninitialized(NumIntervals + 1);
+	SampleRange(Spline, 0, NumIntervals);
+
+	return;
+}
+
+bool FAsgardSplineSampler::UpdateRange(const USplineComponent* Spline, float InSampleSpacing, int32 FirstChangedPoint, int32 LastChangedPoint)
+{
+	checkf(Spline != nullptr, TEXT("FAsgardSplineSampler::UpdateRange failed! Spline was null."));
+
+	// Moving a point also changes the auto tangents of its neighbours, and so the segments on either side of them
+	const int32 LastPoint = Spline->GetNumberOfSplinePoints() - 1;
+	const int32 FirstAffectedPoint = FirstChangedPoint - 2;
+	const int32 LastAffectedPoint = LastChangedPoint + 2;
+
+	// Samples outside the affected points only keep their distances if the spline kept its length and transform.
+	// Closed loops also wrap the affected points around the ends, so those are rebuilt in full
+	const float NewSplineLength = Spline->GetSplineLength();
+	if (!IsValid()
+		|| NewSplineLength <= 0.0f
+		|| !FMath::IsNearlyEqual(NewSplineLength, SplineLength, KINDA_SMALL_NUMBER)
+		|| CalculateNumIntervals(NewSplineLength, InSampleSpacing) + 1 != Locations.Num()
+		|| !ComponentTransform.Equals(Spline->GetComponentTransform())
+		|| (Spline->IsClosedLoop() && (FirstAffectedPoint < 0 || LastAffectedPoint > LastPoint)))
+	{
+		Build(Spline, InSampleSpacing);
+		return false;
+	}
+
+	OwnerTransform = Spline->GetOwner() ? Spline->GetOwner()->GetActorTransform() : FTransform::Identity;
+	const float FirstDistance = Spline->GetDistanceAlongSplineAtSplinePoint(FMath::Clamp(FirstAffectedPoint, 0, LastPoint));
+	const float LastDistance = Spline->GetDistanceAlongSplineAtSplinePoint(FMath::Clamp(LastAffectedPoint, 0, LastPoint));
+	const int32 LastSample = Locations.Num() - 1;
+	SampleRange(
+		Spline,
+		FMath::Clamp(FMath::FloorToInt(FirstDistance / SampleSpacing), 0, LastSample),
+		FMath::Clamp(FMath::CeilToInt(LastDistance / SampleSpacing), 0, LastSample));
+
+	return true;
+}
+
+int32 FAsgardSplineSampler::CalculateNumIntervals(float InSplineLength, float InSampleSpacing)
+{
+	InSampleSpacing = FMath::Clamp(InSampleSpacing, 0.01f, InSplineLength);
+	return FMath::Max(FMath::CeilToInt((InSplineLength / InSampleSpacing) - KINDA_SMALL_NUMBER), 1);
+}
+
+void FAsgardSplineSampler::SampleRange(const USplineComponent* Spline, int32 FirstSample, int32 LastSample)
+{
+	// Sample distances only ever increase, so walk the reparam table once instead of searching it for each sample
+	const TArray<FInterpCurvePoint<float>>& ReparamPoints = Spline->SplineCurves.ReparamTable.Points;
+	int32 ReparamIdx = 0;
+	for (int32 Idx = FirstSample; Idx <= LastSample; Idx++)
+	{
+		const float Distance = FMath::Min(Idx * SampleSpacing, SplineLength);
+		while (ReparamIdx < ReparamPoints.Num() - 2 && ReparamPoints[ReparamIdx + 1].InVal <= Distance)
+		{
+			ReparamIdx++;
+		}
+
+		float InputKey = 0.0f;
+		if (ReparamPoints.Num() > 1)
+		{
+			const FInterpCurvePoint<float>& Prev = ReparamPoints[ReparamIdx];
+			const FInterpCurvePoint<float>& Next = ReparamPoints[ReparamIdx + 1];
+			const float Diff = Next.InVal - Prev.InVal;
+			const float Alpha = Diff > 0.0f ? FMath::Clamp((Distance - Prev.InVal) / Diff, 0.0f, 1.0f) : 0.0f;
+			InputKey = FMath::Lerp(Prev.OutVal, Next.OutVal, Alpha);
+		}
+		else if (ReparamPoints.Num() == 1)
+		{
+			InputKey = ReparamPoints[0].OutVal;
+		}
+
+		Locations[Idx] = Spline->GetLocationAtSplineInputKey(InputKey, ESplineCoordinateSpace::World);
+		Tangents[Idx] = Spline->GetTangentAtSplineInputKey(InputKey, ESplineCoordinateSpace::World);
+		UpVectors[Idx] = Spline->GetUpVectorAtSplineInputKey(InputKey, ESplineCoordinateSpace::World);
+	}
+
+	return;
+}
+
+void FAsgardSplineSampler::FindSamples(float Distance, int32& OutSampleIdx, float& OutAlpha) const
+{
+	const float SampleDistance = FMath::Clamp(Distance, 0.0f, SplineLength) / SampleSpacing;
+	OutSampleIdx = FMath::Clamp(FMath::FloorToInt(SampleDistance), 0, Locations.Num() - 2);
+	OutAlpha = FMath::Clamp(SampleDistance - OutSampleIdx, 0.0f, 1.0f);
+
+	return;
+}
+
+FVector FAsgardSplineSampler::GetLocationAtDistanceAlongSpline(float Distance, ESplineCoordinateSpace::Type CoordinateSpace) const
+{
+	checkf(IsValid(), TEXT("FAsgardSplineSampler::GetLocationAtDistanceAlongSpline failed! Sampler was not built."));
+
+	int32 SampleIdx;
+	float Alpha;
+	FindSamples(Distance, SampleIdx, Alpha);
+	const FVector Location = FMath::Lerp(Locations[SampleIdx], Locations[SampleIdx + 1], Alpha);
+	return CoordinateSpace == ESplineCoordinateSpace::Local ? ComponentTransform.InverseTransformPosition(Location) : Location;
+}
+
+FVector FAsgardSplineSampler::GetTangentAtDistanceAlongSpline(float Distance, ESplineCoordinateSpace::Type CoordinateSpace) const
+{
+	checkf(IsValid(), TEXT("FAsgardSplineSampler::GetTangentAtDistanceAlongSpline failed! Sampler was not built."));
+
+	int32 SampleIdx;
+	float Alpha;
+	FindSamples(Distance, SampleIdx, Alpha);
+	const FVector Tangent = FMath::Lerp(Tangents[SampleIdx], Tangents[SampleIdx + 1], Alpha);
+	return CoordinateSpace == ESplineCoordinateSpace::Local ? ComponentTransform.InverseTransformVector(Tangent) : Tangent;
+}
+
+FVector FAsgardSplineSampler::GetUpVectorAtDistanceAlongSpline(float Distance, ESplineCoordinateSpace::Type CoordinateSpace) const
+{
+	checkf(IsValid(), TEXT("FAsgardSplineSampler::GetUpVectorAtDistanceAlongSpline failed! Sampler was not built."));
+
+	int32 SampleIdx;
+	float Alpha;
+	FindSamples(Distance, SampleIdx, Alpha);
+	const FVector UpVector = FMath::Lerp(UpVectors[SampleIdx], UpVectors[SampleIdx + 1], Alpha).GetSafeNormal();
+	return CoordinateSpace == ESplineCoordinateSpace::Local ? ComponentTransform.InverseTransformVectorNoScale(UpVector) : UpVector;
+}
+
+FVector FAsgardSplineSampler::FindLocationClosestToWorldLocation(const FVector& WorldLocation, int32& InOutSampleHint) const
+{
+	checkf(IsValid(), TEXT("FAsgardSplineSampler::FindLocationClosestToWorldLocation failed! Sampler was not built."));
+
+	// Without a hint, test every sample
+	int32 ClosestIdx = InOutSampleHint;
+	if (!Locations.IsValidIndex(ClosestIdx))
+	{
+		ClosestIdx = 0;
+		float ClosestDistSquared = FVector::DistSquared(Locations[0], WorldLocation);
+		for (int32 Idx = 1; Idx < Locations.Num(); Idx++)
+		{
+			const float DistSquared = FVector::DistSquared(Locations[Idx], WorldLocation);
+			if (DistSquared < ClosestDistSquared)
+			{
+				ClosestIdx = Idx;
+				ClosestDistSquared = DistSquared;
+			}
+		}
+	}
+
+	// Otherwise, walk from the hint while the samples get closer
+	else
+	{
+		while (ClosestIdx < Locations.Num() - 1
+			&& FVector::DistSquared(Locations[ClosestIdx + 1], WorldLocation) < FVector::DistSquared(Locations[ClosestIdx], WorldLocation))
+		{
+			ClosestIdx++;
+		}
+		while (ClosestIdx > 0
+			&& FVector::DistSquared(Locations[ClosestIdx - 1], WorldLocation) < FVector::DistSquared(Locations[ClosestIdx], WorldLocation))
+		{
+			ClosestIdx--;
+		}
+	}
+	InOutSampleHint = ClosestIdx;
+
+	// Refine the result against the intervals on either side of the closest sample
+	FVector ClosestLocation = Locations[ClosestIdx];
+	float ClosestDistSquared = FVector::DistSquared(ClosestLocation, WorldLocation);
+	for (int32 Idx = FMath::Max(ClosestIdx - 1, 0); Idx < FMath::Min(ClosestIdx + 1, Locations.Num() - 1); Idx++)
+	{
+		const FVector IntervalLocation = FMath::ClosestPointOnSegment(WorldLocation, Locations[Idx], Locations[Idx + 1]);
+		const float DistSquared = FVector::DistSquared(IntervalLocation, WorldLocation);
+		if (DistSquared < ClosestDistSquared)
+		{
+			ClosestLocation = IntervalLocation;
+			ClosestDistSquared = DistSquared;
+		}
+	}
+
+	return ClosestLocation;
+}
 
 void UAsgardSplineLibrary::CalculateSplineSegmentNumAndLength(
 	const USplineComponent* Spline,
@@ -98,6 +524,70 @@ void UAsgardSplineLibrary::MatchSplineMeshToSpline(
 	return;
 }
 
+void UAsgardSplineLibrary::BuildSplineSampler(
+	const USplineComponent* Spline,
+	FAsgardSplineSampler& OutSampler,
+	const float SampleSpacing)
+{
+	checkf(Spline != nullptr, TEXT("BuildSplineSampler failed! Spline was null."));
+
+	OutSampler.Build(Spline, SampleSpacing);
+}
+
+void UAsgardSplineLibrary::CalculateSplineSegmentStartAndEnd(
+	const FAsgardSplineSampler& Sampler,
+	FVector& StartLocation,
+	FVector& StartTangent,
+	FVector& EndLocation,
+	FVector& EndTangent,
+	const int32 SegmentIndex,
+	const float SegmentLength,
+	const ESplineCoordinateSpace::Type CoordinateSpace)
+{
+	StartLocation = Sampler.GetLocationAtDistanceAlongSpline(SegmentIndex * SegmentLength, CoordinateSpace);
+	EndLocation = Sampler.GetLocationAtDistanceAlongSpline((SegmentIndex + 1) * SegmentLength, CoordinateSpace);
+
+	FVector Tan1 = Sampler.GetTangentAtDistanceAlongSpline(SegmentIndex * SegmentLength, CoordinateSpace);
+	StartTangent = Tan1.GetSafeNormal() * SegmentLength;
+
+	FVector Tan2 = Sampler.GetTangentAtDistanceAlongSpline((SegmentIndex + 1) * SegmentLength, CoordinateSpace);
+	EndTangent = Tan2.GetSafeNormal() * SegmentLength;
+}
+
+float UAsgardSplineLibrary::CalculateSplineUpRotation(
+	const FAsgardSplineSampler& Sampler,
+	const int32 SegmentIndex,
+	const float SegmentLength,
+	const ESplineCoordinateSpace::Type CoordinateSpace)
+{
+	FVector Tan = Sampler.GetTangentAtDistanceAlongSpline((SegmentIndex + 1) * SegmentLength, CoordinateSpace);
+	FVector Crossed1 = FVector::CrossProduct(Tan.GetSafeNormal(), Sampler.GetUpVectorAtDistanceAlongSpline(SegmentIndex * SegmentLength, CoordinateSpace));
+	FVector Crossed2 = FVector::CrossProduct(Tan.GetSafeNormal(), Sampler.GetUpVectorAtDistanceAlongSpline((SegmentIndex + 1) * SegmentLength, CoordinateSpace));
+	FVector Crossed3 = FVector::CrossProduct(Crossed1, Crossed2).GetSafeNormal();
+	float Dot1 = FVector::DotProduct(Crossed1.GetSafeNormal(), Crossed2.GetSafeNormal());
+	float Dot2 = FVector::DotProduct(Crossed3.GetSafeNormal(), Tan);
+	return ((FMath::Sign(Dot2)) * (-1) * (FMath::Acos(Dot1)));
+}
+
+void UAsgardSplineLibrary::MatchSplineMeshToSpline(
+	const FAsgardSplineSampler& Sampler,
+	const int32 SegmentIndex,
+	const float SegmentLength,
+	USplineMeshComponent* SplineMesh,
+	const FVector2D& StartScale,
+	const FVector2D& EndScale,
+	float Roll,
+	bool UpdateMesh)
+{
+	checkf(SplineMesh != nullptr, TEXT("MatchSplineMeshToSpline failed! SplineMesh was null."));
+
+	AsgardSplineLibrary::FSplineMeshSegment Segment;
+	AsgardSplineLibrary::CalculateSplineMeshSegment(Sampler, SegmentIndex, SegmentLength, Roll, Segment);
+	AsgardSplineLibrary::ApplySplineMeshSegment(Segment, SplineMesh, StartScale, EndScale, UpdateMesh);
+
+	return;
+}
+
 void UAsgardSplineLibrary::BuildOffsetSpline(
 	const USplineComponent* BaseSpline, 
 	USplineComponent* OffsetSpline, 
@@ -107,64 +597,17 @@ void UAsgardSplineLibrary::BuildOffsetSpline(
 	checkf(BaseSpline != nullptr, TEXT("BuildOffsetSpline failed! BaseSpline was null."));
 	checkf(OffsetSpline != nullptr, TEXT("BuildOffsetSpline failed! OffsetSpline was null."));
 
-	ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
 	OffsetSpline->ClearSplinePoints(true);
 	int32 LastIdx = BaseSpline->GetNumberOfSplinePoints() - 1;
 
-	FVector UpVectorScaled;
-	FVector TanAtPoint;
-	FVector OffsetVector;
-	FVector PointLocation;
-
 	for (int Idx = 0; Idx <= LastIdx; Idx++)
 	{
-		UpVectorScaled = OffsetDist * (BaseSpline->GetUpVectorAtSplinePoint(Idx, CoordinateSpace));
-		TanAtPoint = (BaseSpline->GetTangentAtSplinePoint(Idx, CoordinateSpace));
-		OffsetVector = UpVectorScaled.RotateAngleAxis(RotFromUp, TanAtPoint.GetSafeNormal());
-		PointLocation = OffsetVector + (BaseSpline->GetLocationAtSplinePoint(Idx, CoordinateSpace));
-		OffsetSpline->AddSplinePointAtIndex(PointLocation, Idx, CoordinateSpace, false);
-
-		OffsetSpline->SetTangentAtSplinePoint(Idx, TanAtPoint, CoordinateSpace, false);
-
-		OffsetSpline->SetSplinePointType(Idx, BaseSpline->GetSplinePointType(Idx), false);
+		AsgardSplineLibrary::PlaceOffsetSplinePoint(BaseSpline, OffsetSpline, Idx, RotFromUp, OffsetDist, true);
 	}
 
 	OffsetSpline->UpdateSpline();
 
-	// Fix tangents
-	FVector ArriveTan;
-	FVector LeaveTan;
-	FVector BaseTan;
-	int32 ArriveIndex;
-	int32 ArriveLoopingIdx;
-	int32 LeaveLoopingIdx;
-	for (int32 OuterIdx = 0; OuterIdx <= 2; OuterIdx++)
-	{
-		for (int InnerIdx = 0; InnerIdx <= LastIdx; InnerIdx++)
-		{
-			BaseTan = BaseSpline->GetTangentAtSplinePoint(InnerIdx, CoordinateSpace);
-
-			ArriveIndex = FMath::Clamp(int32(InnerIdx - 1), 0, int32(LastIdx + 1));
-			ArriveLoopingIdx = ((InnerIdx - 1) < 0 ? LastIdx : 0);
-			ArriveTan = BaseTan * ((OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(OffsetSpline->GetDistanceAlongSplineAtSplinePoint(ArriveIndex) +
-									OffsetSpline->GetDistanceAlongSplineAtSplinePoint(ArriveLoopingIdx))) /
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(ArriveIndex) +
-									BaseSpline->GetDistanceAlongSplineAtSplinePoint(ArriveLoopingIdx))));
-
-			LeaveLoopingIdx = (LastIdx == InnerIdx ? 1 : 0);
-			LeaveTan = BaseTan * ((OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx + 1) +
-									(OffsetSpline->GetSplineLength() * LeaveLoopingIdx))) /
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx + 1) +
-									(BaseSpline->GetSplineLength() * LeaveLoopingIdx))));
-
-			OffsetSpline->SetTangentsAtSplinePoint(InnerIdx, ArriveTan, LeaveTan, CoordinateSpace, false);
-		}
-		OffsetSpline->UpdateSpline();
-	}
+	AsgardSplineLibrary::FixOffsetSplineTangents(BaseSpline, OffsetSpline, 0, LastIdx);
 }
 
 void UAsgardSplineLibrary::BuildCorrectedSpline(
@@ -180,21 +623,48 @@ void UAsgardSplineLibrary::BuildCorrectedSpline(
 	int32 NumSplineSegments;
 	float SplineSegmentLength;
 	CalculateSplineSegmentNumAndLength(BaseSpline, NumSplineSegments, SplineSegmentLength, IdealSegmentLength);
+
+	// Sample the base spline once per segment, and the offset spline more finely for the closest location search
+	FAsgardSplineSampler BaseSampler;
+	FAsgardSplineSampler OffsetSampler;
+	BaseSampler.Build(BaseSpline, SplineSegmentLength);
+	OffsetSampler.Build(OffsetSpline, SplineSegmentLength / AsgardSplineLibrary::OffsetSamplesPerSegment);
+	BuildCorrectedSpline(BaseSampler, OffsetSampler, CorrectedSpline, NumSplineSegments, SplineSegmentLength, BaseSpline->IsClosedLoop());
+}
+
+void UAsgardSplineLibrary::BuildCorrectedSpline(
+	const FAsgardSplineSampler& BaseSampler,
+	const FAsgardSplineSampler& OffsetSampler,
+	USplineComponent* CorrectedSpline,
+	const int32 NumSegments,
+	const float SegmentLength,
+	const bool bClosedLoop)
+{
+	checkf(CorrectedSpline != nullptr, TEXT("BuildCorrectedSpline failed! CorrectedSpline was null."));
+
 	CorrectedSpline->ClearSplinePoints(true);
-	int32 LastIdx = NumSplineSegments + (BaseSpline->IsClosedLoop() ? -1 : 0);
+	if (!BaseSampler.IsValid() || !OffsetSampler.IsValid())
+	{
+		CorrectedSpline->UpdateSpline();
+		return;
+	}
+
+	int32 LastIdx = NumSegments + (bClosedLoop ? -1 : 0);
+	int32 OffsetSampleHint = INDEX_NONE;
 	FVector Location;
 	FVector LocationOffset;
 	FVector Tangent;
 	ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
 	for (int32 Idx = 0; Idx <= LastIdx; Idx++)
 	{
-		Location = BaseSpline->GetLocationAtDistanceAlongSpline(Idx * SplineSegmentLength, CoordinateSpace);
+		Location = BaseSampler.GetLocationAtDistanceAlongSpline(Idx * SegmentLength, CoordinateSpace);
 		CorrectedSpline->AddSplinePointAtIndex(Location, Idx, CoordinateSpace, false);
 
-		LocationOffset = OffsetSpline->FindLocationClosestToWorldLocation(Location, CoordinateSpace);
+		// Corrected points advance steadily along the offset spline, so continue the search from the previous result
+		LocationOffset = OffsetSampler.FindLocationClosestToWorldLocation(Location, OffsetSampleHint);
 		CorrectedSpline->SetUpVectorAtSplinePoint(Idx, (LocationOffset - Location).GetSafeNormal(), CoordinateSpace, false);
 
-		Tangent = SplineSegmentLength * ((BaseSpline->GetTangentAtDistanceAlongSpline(Idx * SplineSegmentLength, CoordinateSpace)).GetSafeNormal());
+		Tangent = SegmentLength * ((BaseSampler.GetTangentAtDistanceAlongSpline(Idx * SegmentLength, CoordinateSpace)).GetSafeNormal());
 		CorrectedSpline->SetTangentAtSplinePoint(Idx, Tangent, CoordinateSpace, false);
 	}
 	CorrectedSpline->UpdateSpline();
@@ -214,81 +684,132 @@ void UAsgardSplineLibrary::FixSplineTwist(
 	checkf(OffsetSpline != nullptr, TEXT("FixSplineTwist failed! BaseSpline was null."));
 	checkf(CorrectedSpline != nullptr, TEXT("FixSplineTwist failed! BaseSpline was null."));
 
-	ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
-	OffsetSpline->ClearSplinePoints(true);
-	int32 LastIdx = BaseSpline->GetNumberOfSplinePoints() - 1;
+	BuildOffsetSpline(BaseSpline, OffsetSpline, OffsetRotFromUp, OffsetDist);
 
-	FVector UpVectorScaled;
-	FVector TanAtPoint;
-	FVector OffsetVector;
-	FVector PointLocation;
+	CalculateSplineSegmentNumAndLength(BaseSpline, OutNumSegments, OutSegmentLength, IdealSegmentLength);
+	FAsgardSplineSampler BaseSampler;
+	FAsgardSplineSampler OffsetSampler;
+	BaseSampler.Build(BaseSpline, OutSegmentLength);
+	OffsetSampler.Build(OffsetSpline, OutSegmentLength / AsgardSplineLibrary::OffsetSamplesPerSegment);
+	BuildCorrectedSpline(BaseSampler, OffsetSampler, CorrectedSpline, OutNumSegments, OutSegmentLength, BaseSpline->IsClosedLoop());
+}
 
-	for (int Idx = 0; Idx <= LastIdx; Idx++)
-	{
-		UpVectorScaled = OffsetDist * (BaseSpline->GetUpVectorAtSplinePoint(Idx, CoordinateSpace));
-		TanAtPoint = (BaseSpline->GetTangentAtSplinePoint(Idx, CoordinateSpace));
-		OffsetVector = UpVectorScaled.RotateAngleAxis(OffsetRotFromUp, TanAtPoint.GetSafeNormal());
-		PointLocation = OffsetVector + (BaseSpline->GetLocationAtSplinePoint(Idx, CoordinateSpace));
-		OffsetSpline->AddSplinePointAtIndex(PointLocation, Idx, CoordinateSpace, false);
+void UAsgardSplineLibrary::FixSplineTwistInRange(
+	int32& InOutNumSegments,
+	float& InOutSegmentLength,
+	int32& OutFirstDirtySegment,
+	int32& OutLastDirtySegment,
+	const USplineComponent* BaseSpline,
+	USplineComponent* OffsetSpline,
+	USplineComponent* CorrectedSpline,
+	FAsgardSplineSampler& InOutBaseSampler,
+	FAsgardSplineSampler& InOutOffsetSampler,
+	int32 FirstDirtyPoint,
+	int32 LastDirtyPoint,
+	const float OffsetRotFromUp,
+	const float OffsetDist,
+	const float IdealSegmentLength)
+{
+	checkf(BaseSpline != nullptr, TEXT("FixSplineTwistInRange failed! BaseSpline was null."));
+	checkf(OffsetSpline != nullptr, TEXT("FixSplineTwistInRange failed! OffsetSpline was null."));
+	checkf(CorrectedSpline != nullptr, TEXT("FixSplineTwistInRange failed! CorrectedSpline was null."));
 
-		OffsetSpline->SetTangentAtSplinePoint(Idx, TanAtPoint, CoordinateSpace, false);
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_SplineLibraryFixSplineTwistInRange);
 
-		OffsetSpline->SetSplinePointType(Idx, BaseSpline->GetSplinePointType(Idx), false);
+	// If points were added or removed, the splines no longer correspond, so rebuild everything
+	int32 LastIdx = BaseSpline->GetNumberOfSplinePoints() - 1;
+	if (OffsetSpline->GetNumberOfSplinePoints() != LastIdx + 1)
+	{
+		BuildOffsetSpline(BaseSpline, OffsetSpline, OffsetRotFromUp, OffsetDist);
+		CalculateSplineSegmentNumAndLength(BaseSpline, InOutNumSegments, InOutSegmentLength, IdealSegmentLength);
+		InOutBaseSampler.Build(BaseSpline, InOutSegmentLength);
+		InOutOffsetSampler.Build(OffsetSpline, InOutSegmentLength / AsgardSplineLibrary::OffsetSamplesPerSegment);
+		BuildCorrectedSpline(InOutBaseSampler, InOutOffsetSampler, CorrectedSpline, InOutNumSegments, InOutSegmentLength, BaseSpline->IsClosedLoop());
+		OutFirstDirtySegment = 0;
+		OutLastDirtySegment = InOutNumSegments - 1;
+		return;
 	}
 
+	// Move the offset points of the dirty base points
+	FirstDirtyPoint = FMath::Clamp(FirstDirtyPoint, 0, LastIdx);
+	LastDirtyPoint = FMath::Clamp(LastDirtyPoint, FirstDirtyPoint, LastIdx);
+	for (int32 Idx = FirstDirtyPoint; Idx <= LastDirtyPoint; Idx++)
+	{
+		AsgardSplineLibrary::PlaceOffsetSplinePoint(BaseSpline, OffsetSpline, Idx, OffsetRotFromUp, OffsetDist, false);
+	}
 	OffsetSpline->UpdateSpline();
 
-	// Fix tangents
-	FVector ArriveTan;
-	FVector LeaveTan;
-	FVector BaseTan;
-	int32 ArriveIndex;
-	int32 ArriveLoopingIdx;
-	int32 LeaveLoopingIdx;
-	for (int32 OuterIdx = 0; OuterIdx <= 2; OuterIdx++)
+	// Each tangent fix pass reads the neighbours of each point, so the change spreads one point further per pass
+	const int32 FirstOffsetPoint = FMath::Max(FirstDirtyPoint - AsgardSplineLibrary::NumTangentFixPasses, 0);
+	const int32 LastOffsetPoint = FMath::Min(LastDirtyPoint + AsgardSplineLibrary::NumTangentFixPasses, LastIdx);
+	AsgardSplineLibrary::FixOffsetSplineTangents(BaseSpline, OffsetSpline, FirstOffsetPoint, LastOffsetPoint);
+
+	// Resample the parts of both splines around the changed points, then only write the corrected points that moved
+	CalculateSplineSegmentNumAndLength(BaseSpline, InOutNumSegments, InOutSegmentLength, IdealSegmentLength);
+	InOutBaseSampler.UpdateRange(BaseSpline, InOutSegmentLength, FirstDirtyPoint, LastDirtyPoint);
+	InOutOffsetSampler.UpdateRange(OffsetSpline, InOutSegmentLength / AsgardSplineLibrary::OffsetSamplesPerSegment, FirstOffsetPoint, LastOffsetPoint);
+	AsgardSplineLibrary::UpdateCorrectedSpline(
+		InOutBaseSampler,
+		InOutOffsetSampler,
+		CorrectedSpline,
+		InOutNumSegments,
+		InOutSegmentLength,
+		BaseSpline->IsClosedLoop(),
+		OutFirstDirtySegment,
+		OutLastDirtySegment);
+}
+
+void UAsgardSplineLibrary::MatchSplineMeshesToSpline(
+	const USplineComponent* Spline,
+	const TArray<USplineMeshComponent*>& SplineMeshes,
+	const float SegmentLength,
+	const FVector2D& StartScale,
+	const FVector2D& EndScale,
+	float Roll,
+	int32 FirstSegment,
+	int32 LastSegment,
+	bool UpdateMesh)
+{
+	checkf(Spline != nullptr, TEXT("MatchSplineMeshesToSpline failed! Spline was null."));
+
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_SplineLibraryMatchSplineMeshes);
+
+	FirstSegment = FMath::Max(FirstSegment, 0);
+	LastSegment = LastSegment < 0 ? SplineMeshes.Num() - 1 : FMath::Min(LastSegment, SplineMeshes.Num() - 1);
+	const int32 NumSegments = LastSegment - FirstSegment + 1;
+	if (NumSegments <= 0)
 	{
-		for (int InnerIdx = 0; InnerIdx <= LastIdx; InnerIdx++)
-		{
-			BaseTan = BaseSpline->GetTangentAtSplinePoint(InnerIdx, CoordinateSpace);
-
-			ArriveIndex = FMath::Clamp(int32(InnerIdx - 1), 0, int32(LastIdx + 1));
-			ArriveLoopingIdx = ((InnerIdx - 1) < 0 ? LastIdx : 0);
-			ArriveTan = BaseTan * ((OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(OffsetSpline->GetDistanceAlongSplineAtSplinePoint(ArriveIndex) +
-									OffsetSpline->GetDistanceAlongSplineAtSplinePoint(ArriveLoopingIdx))) /
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(ArriveIndex) +
-									BaseSpline->GetDistanceAlongSplineAtSplinePoint(ArriveLoopingIdx))));
-
-			LeaveLoopingIdx = (LastIdx == InnerIdx ? 1 : 0);
-			LeaveTan = BaseTan * ((OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx + 1) +
-									(OffsetSpline->GetSplineLength() * LeaveLoopingIdx))) /
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx + 1) +
-									(BaseSpline->GetSplineLength() * LeaveLoopingIdx))));
-
-			OffsetSpline->SetTangentsAtSplinePoint(InnerIdx, ArriveTan, LeaveTan, CoordinateSpace, false);
-		}
-		OffsetSpline->UpdateSpline();
+		return;
 	}
 
-	CalculateSplineSegmentNumAndLength(BaseSpline, OutNumSegments, OutSegmentLength, IdealSegmentLength);
-	CorrectedSpline->ClearSplinePoints(true);
-	LastIdx = OutNumSegments + (BaseSpline->IsClosedLoop() ? -1 : 0);
-	FVector Location;
-	FVector LocationOffset;
-	FVector Tangent;
-	for (int32 Idx = 0; Idx <= LastIdx; Idx++)
+	// Sample the spline once, so segments can be evaluated concurrently without searching the spline
+	FAsgardSplineSampler Sampler;
+	Sampler.Build(Spline, SegmentLength);
+	if (!Sampler.IsValid())
 	{
-		Location = BaseSpline->GetLocationAtDistanceAlongSpline(Idx * OutSegmentLength, CoordinateSpace);
-		CorrectedSpline->AddSplinePointAtIndex(Location, Idx, CoordinateSpace, false);
+		return;
+	}
 
-		LocationOffset = OffsetSpline->FindLocationClosestToWorldLocation(Location, CoordinateSpace);
-		CorrectedSpline->SetUpVectorAtSplinePoint(Idx, (LocationOffset - Location).GetSafeNormal(), CoordinateSpace, false);
+	// Evaluate the segments in parallel
+	TArray<AsgardSplineLibrary::FSplineMeshSegment> Segments;
+	Segments.SetNumUninitialized(NumSegments);
+	const int32 ParallelThreshold = SplineMeshParallelThreshold->GetInt();
+	const bool bForceSingleThread = ParallelThreshold <= 0 || NumSegments < ParallelThreshold;
+	ParallelFor(NumSegments, [&](int32 Idx)
+		{
+			AsgardSplineLibrary::CalculateSplineMeshSegment(Sampler, FirstSegment + Idx, SegmentLength, Roll, Segments[Idx]);
+		},
+		bForceSingleThread);
 
-		Tangent = OutSegmentLength* ((BaseSpline->GetTangentAtDistanceAlongSpline(Idx * OutSegmentLength, CoordinateSpace)).GetSafeNormal());
-		CorrectedSpline->SetTangentAtSplinePoint(Idx, Tangent, CoordinateSpace, false);
+	// Apply them on the game thread
+	for (int32 Idx = 0; Idx < NumSegments; Idx++)
+	{
+		USplineMeshComponent* SplineMesh = SplineMeshes[FirstSegment + Idx];
+		if (SplineMesh)
+		{
+			AsgardSplineLibrary::ApplySplineMeshSegment(Segments[Idx], SplineMesh, StartScale, EndScale, UpdateMesh);
+		}
 	}
-	CorrectedSpline->UpdateSpline();
+
+	return;
 }
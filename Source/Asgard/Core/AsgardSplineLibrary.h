@@ -7,6 +7,90 @@
 #include "Runtime/Engine/Classes/Components/SplineComponent.h"
 #include "AsgardSplineLibrary.generated.h"
 
+// Stats group
+DECLARE_STATS_GROUP(TEXT("AsgardSplineLibrary"), STATGROUP_ASGARD_SplineLibrary, STATCAT_Advanced);
+
+/**
+ * Table of locations, tangents and up vectors sampled at uniform distances along a spline.
+ * Lookups by distance are a constant time interpolation between two samples, instead of a search of the spline's reparam table.
+ * Samples are stored in world space, and must be rebuilt whenever the spline changes.
+ */
+USTRUCT(BlueprintType)
+struct ASGARD_API FAsgardSplineSampler
+{
+	GENERATED_BODY()
+
+public:
+	FAsgardSplineSampler();
+
+	/** Samples a spline every SampleSpacing units along its length. The spacing is adjusted so the last sample lands on the end of the spline. */
+	void Build(const USplineComponent* Spline, float SampleSpacing);
+
+	/**
+	* Resamples only the samples around a range of changed spline points, including the neighbours whose auto tangents they affect.
+	* Falls back to a full Build if the spline's length, transform or number of samples changed, since every sample distance moves.
+	* Returns whether only part of the spline was resampled.
+	*/
+	bool UpdateRange(const USplineComponent* Spline, float SampleSpacing, int32 FirstChangedPoint, int32 LastChangedPoint);
+
+	/** Returns whether the sampler has been built from a spline with a non-zero length. */
+	bool IsValid() const { return Locations.Num() > 1; }
+
+	/** Returns the length of the sampled spline. */
+	float GetSplineLength() const { return SplineLength; }
+
+	/** Returns the transform of the owner of the sampled spline when it was sampled. */
+	const FTransform& GetOwnerTransform() const { return OwnerTransform; }
+
+	/** Returns the interpolated location at a distance along the spline. */
+	FVector GetLocationAtDistanceAlongSpline(float Distance, ESplineCoordinateSpace::Type CoordinateSpace) const;
+
+	/** Returns the interpolated tangent at a distance along the spline. */
+	FVector GetTangentAtDistanceAlongSpline(float Distance, ESplineCoordinateSpace::Type CoordinateSpace) const;
+
+	/** Returns the interpolated up vector at a distance along the spline. */
+	FVector GetUpVectorAtDistanceAlongSpline(float Distance, ESplineCoordinateSpace::Type CoordinateSpace) const;
+
+	/**
+	* Returns the world space location on the sampled spline closest to a world space location.
+	* InOutSampleHint should start at INDEX_NONE, and be passed back in for each subsequent query.
+	* While it is valid, the search walks from the hinted sample instead of testing every sample,
+	* so queries for locations that move steadily along the spline are resolved in constant time.
+	*/
+	FVector FindLocationClosestToWorldLocation(const FVector& WorldLocation, int32& InOutSampleHint) const;
+
+private:
+	/** World space locations of the samples. */
+	TArray<FVector> Locations;
+
+	/** World space tangents of the samples. */
+	TArray<FVector> Tangents;
+
+	/** World space up vectors of the samples. */
+	TArray<FVector> UpVectors;
+
+	/** Transform of the sampled spline component. */
+	FTransform ComponentTransform;
+
+	/** Transform of the owner of the sampled spline component. */
+	FTransform OwnerTransform;
+
+	/** Distance between samples. */
+	float SampleSpacing;
+
+	/** Length of the sampled spline. */
+	float SplineLength;
+
+	/** Finds the sample before a distance along the spline, and the alpha towards the sample after it. */
+	void FindSamples(float Distance, int32& OutSampleIdx, float& OutAlpha) const;
+
+	/** Evaluates the spline at a range of samples. The samples must already be allocated. */
+	void SampleRange(const USplineComponent* Spline, int32 FirstSample, int32 LastSample);
+
+	/** Returns the number of intervals between samples needed to sample a spline of a length at about a spacing. */
+	static int32 CalculateNumIntervals(float InSplineLength, float InSampleSpacing);
+};
+
 /**
  * Library of functions for working with splines.
  */
@@ -56,6 +140,42 @@ public:
 			float Roll = 0.0f,
 			bool UpdateMesh = false);
 
+	/** Samples a spline at uniform distances, for use as an accelerator by the other spline functions. */
+	UFUNCTION(BlueprintCallable, Category = "Asgard|SplineLibrary")
+		static void BuildSplineSampler(
+			const USplineComponent* Spline,
+			FAsgardSplineSampler& OutSampler,
+			const float SampleSpacing = 10.0f);
+
+	/** Version of CalculateSplineSegmentStartAndEnd that reads from a sampler instead of searching the spline. */
+	static void CalculateSplineSegmentStartAndEnd(
+		const FAsgardSplineSampler& Sampler,
+		FVector& StartLocation,
+		FVector& StartTangent,
+		FVector& EndLocation,
+		FVector& EndTangent,
+		const int32 SegmentIndex,
+		const float SegmentLength = 100.0f,
+		const ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::Local);
+
+	/** Version of CalculateSplineUpRotation that reads from a sampler instead of searching the spline. */
+	static float CalculateSplineUpRotation(
+		const FAsgardSplineSampler& Sampler,
+		const int32 SegmentIndex,
+		const float SegmentLength = 100.0f,
+		const ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World);
+
+	/** Version of MatchSplineMeshToSpline that reads from a sampler instead of searching the spline. */
+	static void MatchSplineMeshToSpline(
+		const FAsgardSplineSampler& Sampler,
+		const int32 SegmentIndex,
+		const float SegmentLength,
+		USplineMeshComponent* SplineMesh,
+		const FVector2D& StartScale,
+		const FVector2D& EndScale,
+		float Roll = 0.0f,
+		bool UpdateMesh = false);
+
 	/** Input a Spline to offset with offset distance and rotation from the spline's up vector at each point. */
 	UFUNCTION(BlueprintCallable, Category = "Asgard|SplineLibrary")
 		static void BuildOffsetSpline(
@@ -76,6 +196,19 @@ public:
 			USplineComponent* CorrectedSpline,
 			const float IdealSegmentLength = 100.0f);
 
+	/**
+	* Version of BuildCorrectedSpline that reads from samplers instead of searching the splines.
+	* The base sampler should be built with a spacing that divides the segment length, so each corrected point lands exactly on a sample.
+	* The offset sampler is used to find the up vectors, so a finer spacing gives more accurate up vectors.
+	*/
+	static void BuildCorrectedSpline(
+		const FAsgardSplineSampler& BaseSampler,
+		const FAsgardSplineSampler& OffsetSampler,
+		USplineComponent* CorrectedSpline,
+		const int32 NumSegments,
+		const float SegmentLength,
+		const bool bClosedLoop);
+
 	/*
 	* Builds a an offset and corrected spline using a base spline and offset spline. 
 	* Outputs the length and count of each spline segment, base on the ideal length.
@@ -91,4 +224,45 @@ public:
 			const float OffsetRotFromUp,
 			const float OffsetDist = 30.0f,
 			const float IdealSegmentLength = 100.0f);
+
+	/*
+	* Incremental version of FixSplineTwist, for when only a range of base spline points has changed since the last fix.
+	* Only the offset points within the range, and the tangents within reach of the tangent fix passes, are recomputed.
+	* The samplers should be kept between calls, and are only resampled around the changed points while the spline lengths stay the same.
+	* The corrected spline is resampled in place, and outputs the range of segments that moved, for use with MatchSplineMeshesToSpline.
+	* Falls back to a full rebuild if points have been added or removed.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Asgard|SplineLibrary")
+		static void FixSplineTwistInRange(
+			int32& InOutNumSegments,
+			float& InOutSegmentLength,
+			int32& OutFirstDirtySegment,
+			int32& OutLastDirtySegment,
+			const USplineComponent* BaseSpline,
+			USplineComponent* OffsetSpline,
+			USplineComponent* CorrectedSpline,
+			UPARAM(ref) FAsgardSplineSampler& InOutBaseSampler,
+			UPARAM(ref) FAsgardSplineSampler& InOutOffsetSampler,
+			int32 FirstDirtyPoint,
+			int32 LastDirtyPoint,
+			const float OffsetRotFromUp,
+			const float OffsetDist = 30.0f,
+			const float IdealSegmentLength = 100.0f);
+
+	/*
+	* Matches a range of spline meshes to the segments of a spline, where each spline mesh index is its segment index.
+	* Segment settings are evaluated in parallel from a sampler, then applied to the spline meshes on the game thread.
+	* A LastSegment below 0 matches every segment from FirstSegment onwards.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Asgard|SplineLibrary")
+		static void MatchSplineMeshesToSpline(
+			const USplineComponent* Spline,
+			const TArray<USplineMeshComponent*>& SplineMeshes,
+			const float SegmentLength,
+			const FVector2D& StartScale,
+			const FVector2D& EndScale,
+			float Roll = 0.0f,
+			int32 FirstSegment = 0,
+			int32 LastSegment = -1,
+			bool UpdateMesh = false);
 };
@@ -1,6 +1,27 @@
 ﻿// Copyright © 2020 Justin Camden All Rights Reserved
 
 #include "AsgardVelocityTracker.h"
+#include "Asgard/Core/AsgardVelocityTrackerSubsystem.h"
+#include "Runtime/Engine/Classes/Engine/World.h"
+
+namespace AsgardVelocityTracker
+{
+	/** Calculates the angular velocity, in degrees per second, needed to rotate between two world rotations over a duration. */
+	static FVector CalculateAngularVelocity(const FQuat& FromRotation, const FQuat& ToRotation, float Duration)
+	{
+		// Take the shortest arc between the rotations
+		FQuat DeltaRotation = ToRotation * FromRotation.Inverse();
+		if (DeltaRotation.W < 0.0f)
+		{
+			DeltaRotation = DeltaRotation * -1.0f;
+		}
+
+		FVector Axis;
+		float Angle;
+		DeltaRotation.ToAxisAndAngle(Axis, Angle);
+		return Axis * (FMath::RadiansToDegrees(Angle) / Duration);
+	}
+}
 
 // Sets default values for this component's properties
 UAsgardVelocityTracker::UAsgardVelocityTracker()
@@ -24,73 +45,213 @@ void UAsgardVelocityTracker::BeginPlay()
 	
 }
 
+// Called when the game ends
+void UAsgardVelocityTracker::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UpdateTrackingMode(false);
+	Super::EndPlay(EndPlayReason);
+}
+
 
 // Called every frame
 void UAsgardVelocityTracker::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	// Cache the location of the component
-	FVector CurrentLocation = GetComponentLocation();
+	// Cache the location and rotation of the component
+	FVector CurrentLocation;
+	FQuat CurrentRotation;
+	GetTrackedLocationAndRotation(CurrentLocation, CurrentRotation);
+
+	AddFrameSample(CurrentLocation, CurrentRotation, DeltaTime);
+	UpdateVelocity();
+
+	LastLocation = CurrentLocation;
+}
+
+void UAsgardVelocityTracker::Activate(bool bReset)
+{
+	FQuat CurrentRotation;
+	GetTrackedLocationAndRotation(LastLocation, CurrentRotation);
+	ResetFrameHistory();
+	AddFrameSample(LastLocation, CurrentRotation, 0.0f);
+	UpdateTrackingMode(true);
+	Super::Activate();
+}
+
+void UAsgardVelocityTracker::Deactivate()
+{
+	UpdateTrackingMode(false);
+	CalculatedVelocity = FVector::ZeroVector;
+	CalculatedAngularVelocity = FVector::ZeroVector;
+	FrameHistoryNum = 0;
+	Super::Deactivate();
+}
+
+void UAsgardVelocityTracker::SetUseVelocityTrackerSubsystem(bool bNewUseVelocityTrackerSubsystem)
+{
+	bUseVelocityTrackerSubsystem = bNewUseVelocityTrackerSubsystem;
+
+	// Registration is handled on activation if tracking is not active yet
+	if (IsActive())
+	{
+		UpdateTrackingMode(true);
+	}
+
+	return;
+}
+
+void UAsgardVelocityTracker::GetTrackedLocationAndRotation(FVector& OutLocation, FQuat& OutRotation) const
+{
+	const FTransform& SelfTransform = GetComponentTransform();
+	OutLocation = SelfTransform.GetLocation();
+	OutRotation = SelfTransform.GetRotation();
 
 	// Offset if necessary
 	if (OffsetComponent)
 	{
-		CurrentLocation -= OffsetComponent->GetComponentLocation();
+		OutLocation -= OffsetComponent->GetComponentLocation();
+		OutRotation = OffsetComponent->GetComponentQuat().Inverse() * OutRotation;
+	}
+
+	return;
+}
+
+void UAsgardVelocityTracker::AddFrameSample(const FVector& Location, const FQuat& Rotation, float DeltaTime)
+{
+	if (FrameHistory.Num() < 2)
+	{
+		ResetFrameHistory();
 	}
 
-	// If the velocity interval is greater than 0, average over the past few frames up to the interval duration
-	if (VelocityAverageInterval > 0.0f)
+	// If the history is full, drop the oldest frame to make room
+	const int32 HistoryCapacity = FrameHistory.Num();
+	if (FrameHistoryNum >= HistoryCapacity)
 	{
-		FVector IntervalStartLocation = LastLocation;
-		float TotalDuration = DeltaTime;
+		FrameHistoryTail = (FrameHistoryTail + 1) % HistoryCapacity;
+		FrameHistoryNum--;
+	}
 
-		if (FrameLocationHistory.Num() > 0)
+	TrackingTime += DeltaTime;
+	FFrameSample& NewSample = FrameHistory[(FrameHistoryTail + FrameHistoryNum) % HistoryCapacity];
+	NewSample.Location = Location;
+	NewSample.Rotation = Rotation;
+	NewSample.Time = TrackingTime;
+	FrameHistoryNum++;
+
+	// Drop the oldest frames while the remaining frames still span the averaging interval
+	// If the interval is <= 0, only the previous and latest frames are kept
+	const double WindowStartTime = TrackingTime - FMath::Max(VelocityAverageInterval, 0.0f);
+	while (FrameHistoryNum > 2 && GetFrameSample(1).Time <= WindowStartTime)
+	{
+		FrameHistoryTail = (FrameHistoryTail + 1) % HistoryCapacity;
+		FrameHistoryNum--;
+	}
+
+	return;
+}
+
+void UAsgardVelocityTracker::ResetFrameHistory()
+{
+	FrameHistory.SetNumUninitialized(FMath::Max(MaxHistoryFrames, 2));
+	FrameHistoryTail = 0;
+	FrameHistoryNum = 0;
+	TrackingTime = 0.0;
+
+	return;
+}
+
+void UAsgardVelocityTracker::UpdateVelocity()
+{
+	// Cache variables
+	const FFrameSample& OldestSample = GetFrameSample(0);
+	const FFrameSample& LatestSample = GetFrameSample(FrameHistoryNum - 1);
+	const float WindowDuration = (float)(LatestSample.Time - OldestSample.Time);
+
+	// Keep the previous velocity if no time has passed
+	if (FrameHistoryNum < 2 || WindowDuration <= 0.0f)
+	{
+		return;
+	}
+
+	switch (VelocityEstimator)
+	{
+	case EAsgardVelocityEstimator::ExponentialSmoothing:
+	{
+		// Blend the velocity of the latest frame into the previous estimate
+		const FFrameSample& PreviousSample = GetFrameSample(FrameHistoryNum - 2);
+		const float FrameDuration = (float)(LatestSample.Time - PreviousSample.Time);
+		if (FrameDuration > 0.0f)
 		{
-			int32 Idx = -1;
-			for (float CurrentFrameDuration : FrameDurationHistory)
-			{
-				Idx++;
-				TotalDuration += CurrentFrameDuration;
-				if (TotalDuration >= VelocityAverageInterval)
-				{
-					IntervalStartLocation = FrameLocationHistory[Idx];
-					break;
-				}
-			}
-
-			FrameLocationHistory.SetNum(Idx, false);
-			FrameDurationHistory.SetNum(Idx, false);
+			const float BlendAlpha = SmoothingTimeConstant > 0.0f ? 1.0f - FMath::Exp(-FrameDuration / SmoothingTimeConstant) : 1.0f;
+			const FVector FrameVelocity = (LatestSample.Location - PreviousSample.Location) / FrameDuration;
+			const FVector FrameAngularVelocity = AsgardVelocityTracker::CalculateAngularVelocity(PreviousSample.Rotation, LatestSample.Rotation, FrameDuration);
+			CalculatedVelocity = FMath::Lerp(CalculatedVelocity, FrameVelocity, BlendAlpha);
+			CalculatedAngularVelocity = FMath::Lerp(CalculatedAngularVelocity, FrameAngularVelocity, BlendAlpha);
+		}
+		break;
+	}
 
+	case EAsgardVelocityEstimator::LeastSquares:
+	{
+		// Fit a line through every frame in the window, measuring time relative to the latest frame to preserve precision
+		float MeanTime = 0.0f;
+		FVector MeanLocation = FVector::ZeroVector;
+		for (int32 Idx = 0; Idx < FrameHistoryNum; Idx++)
+		{
+			const FFrameSample& Sample = GetFrameSample(Idx);
+			MeanTime += (float)(Sample.Time - LatestSample.Time);
+			MeanLocation += Sample.Location - LatestSample.Location;
 		}
+		MeanTime /= FrameHistoryNum;
+		MeanLocation /= FrameHistoryNum;
 
-		FrameLocationHistory.EmplaceAt(0, CurrentLocation);
-		FrameDurationHistory.Insert(0, DeltaTime);
+		FVector Covariance = FVector::ZeroVector;
+		float Variance = 0.0f;
+		for (int32 Idx = 0; Idx < FrameHistoryNum; Idx++)
+		{
+			const FFrameSample& Sample = GetFrameSample(Idx);
+			const float TimeOffset = (float)(Sample.Time - LatestSample.Time) - MeanTime;
+			Covariance += ((Sample.Location - LatestSample.Location) - MeanLocation) * TimeOffset;
+			Variance += FMath::Square(TimeOffset);
+		}
 
-		CalculatedVelocity = (CurrentLocation - IntervalStartLocation) / TotalDuration;
+		CalculatedVelocity = Covariance / Variance;
+		CalculatedAngularVelocity = AsgardVelocityTracker::CalculateAngularVelocity(OldestSample.Rotation, LatestSample.Rotation, WindowDuration);
+		break;
 	}
 
-	else
+	default:
 	{
-		CalculatedVelocity = (CurrentLocation - LastLocation) / DeltaTime;
+		CalculatedVelocity = (LatestSample.Location - OldestSample.Location) / WindowDuration;
+		CalculatedAngularVelocity = AsgardVelocityTracker::CalculateAngularVelocity(OldestSample.Rotation, LatestSample.Rotation, WindowDuration);
+		break;
+	}
 	}
 
-	LastLocation = CurrentLocation;
+	return;
 }
 
-void UAsgardVelocityTracker::Activate(bool bReset)
+void UAsgardVelocityTracker::UpdateTrackingMode(bool bTrackingActive)
 {
-	LastLocation = GetComponentLocation();
-	SetComponentTickEnabled(true);
-	Super::Activate();
-}
+	const bool bShouldRegister = bTrackingActive && bUseVelocityTrackerSubsystem;
+	UWorld* World = GetWorld();
+	UAsgardVelocityTrackerSubsystem* TrackerSubsystem = World ? World->GetSubsystem<UAsgardVelocityTrackerSubsystem>() : nullptr;
+	if (TrackerSubsystem && bShouldRegister != bRegisteredWithVelocityTrackerSubsystem)
+	{
+		if (bShouldRegister)
+		{
+			TrackerSubsystem->RegisterTracker(this);
+		}
+		else
+		{
+			TrackerSubsystem->UnregisterTracker(this);
+		}
+		bRegisteredWithVelocityTrackerSubsystem = bShouldRegister;
+	}
 
-void UAsgardVelocityTracker::Deactivate()
-{
-	SetComponentTickEnabled(false);
-	CalculatedVelocity = FVector::ZeroVector;
-	FrameLocationHistory.Reset();
-	FrameDurationHistory.Reset();
-	Super::Deactivate();
-}
+	// Only tick if the subsystem is not updating this tracker
+	SetComponentTickEnabled(bTrackingActive && !bRegisteredWithVelocityTrackerSubsystem);
 
+	return;
+}
@@ -6,6 +6,17 @@
 #include "Components/SceneComponent.h"
 #include "AsgardVelocityTracker.generated.h"
 
+UENUM(BlueprintType)
+enum class EAsgardVelocityEstimator : uint8
+{
+	/** Change in location across the averaging window, divided by the window duration. */
+	WindowAverage,
+	/** Latest frame velocity blended exponentially into the previous estimate. */
+	ExponentialSmoothing,
+	/** Slope of a least-squares line fitted through every location in the averaging window. */
+	LeastSquares
+};
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class ASGARD_API UAsgardVelocityTracker : public USceneComponent
 {
@@ -19,6 +30,9 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
@@ -27,17 +41,58 @@ public:
 
 	virtual void Deactivate() override;
 
+	/** Returns the calculated velocity of this component, in world space. */
+	FORCEINLINE const FVector& GetCalculatedVelocity() const { return CalculatedVelocity; }
+
+	/** Returns the calculated angular velocity of this component, in degrees per second around each world axis. */
+	FORCEINLINE const FVector& GetCalculatedAngularVelocity() const { return CalculatedAngularVelocity; }
+
 	/** 
 	* DeltaLocation will be calculated by the average over this time. 
 	* If <= 0, only the latest frame will be considered.
 	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|VelocityTracker")
 	float VelocityAverageInterval = 0.05f;
 
+	/** How velocity is estimated from the location history. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|VelocityTracker")
+	EAsgardVelocityEstimator VelocityEstimator = EAsgardVelocityEstimator::WindowAverage;
+
+	/**
+	* Time constant used when VelocityEstimator is ExponentialSmoothing.
+	* Larger values produce smoother but less responsive velocities.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|VelocityTracker", meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float SmoothingTimeConstant = 0.05f;
+
+	/**
+	* Maximum number of frames kept in the history.
+	* If the averaging window spans more frames than this, the oldest frames are dropped early.
+	* Applied the next time tracking is activated.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|VelocityTracker", meta = (ClampMin = "2", UIMin = "2"))
+	int32 MaxHistoryFrames = 32;
+
 	/** If this scene component is valid, location changes will be offset by the location of said component. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|VelocityTracker")
 	USceneComponent* OffsetComponent;
 
+	/**
+	* Whether this tracker should be updated by the velocity tracker subsystem in one pass with other trackers, instead of ticking itself.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Asgard|VelocityTracker")
+	bool bUseVelocityTrackerSubsystem;
+
+	/**
+	* Setter for bUseVelocityTrackerSubsystem.
+	* Registers or unregisters the tracker with the velocity tracker subsystem as appropriate.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Asgard|VelocityTracker")
+	void SetUseVelocityTrackerSubsystem(bool bNewUseVelocityTrackerSubsystem);
+
 private:
+	friend class UAsgardVelocityTrackerSubsystem;
+
 	/** The location of the component on the last frame that tracking was active.*/
 	UPROPERTY(BlueprintReadOnly, Category = "Asgard|VelocityTracker", meta = (AllowPrivateAccess = "true"))
 	FVector LastLocation;
@@ -46,6 +101,52 @@ private:
 	UPROPERTY(BlueprintReadOnly, Category = "Asgard|VelocityTracker", meta = (AllowPrivateAccess = "true"))
 	FVector CalculatedVelocity;
 
-	TArray<FVector> FrameLocationHistory;
-	TArray<float> FrameDurationHistory;
+	/** The calculated angular velocity of this component, in degrees per second around each world axis. */
+	UPROPERTY(BlueprintReadOnly, Category = "Asgard|VelocityTracker", meta = (AllowPrivateAccess = "true"))
+	FVector CalculatedAngularVelocity;
+
+	/** A single frame in the tracking history. */
+	struct FFrameSample
+	{
+		FVector Location;
+		FQuat Rotation;
+		/** Time since tracking was activated. Kept in double precision so window durations stay exact over long sessions. */
+		double Time;
+	};
+
+	/**
+	* Fixed capacity ring buffer of recent frames, allocated once on activation.
+	* Frames are added at the head and dropped from the tail once they fall outside the averaging window.
+	*/
+	TArray<FFrameSample> FrameHistory;
+
+	/** Index of the oldest frame in the history. */
+	int32 FrameHistoryTail;
+
+	/** Number of frames currently in the history. */
+	int32 FrameHistoryNum;
+
+	/** Time since tracking was activated. */
+	double TrackingTime;
+
+	/** Returns the frame at an offset from the oldest frame in the history. */
+	FORCEINLINE const FFrameSample& GetFrameSample(int32 Offset) const { return FrameHistory[(FrameHistoryTail + Offset) % FrameHistory.Num()]; }
+
+	/** Whether the tracker is currently registered with the velocity tracker subsystem. */
+	bool bRegisteredWithVelocityTrackerSubsystem;
+
+	/** Returns the location and rotation to track this frame, offset by OffsetComponent if valid. */
+	void GetTrackedLocationAndRotation(FVector& OutLocation, FQuat& OutRotation) const;
+
+	/** Adds the latest frame to the history, and drops frames that are no longer needed. */
+	void AddFrameSample(const FVector& Location, const FQuat& Rotation, float DeltaTime);
+
+	/** Clears the history and resizes it to MaxHistoryFrames. */
+	void ResetFrameHistory();
+
+	/** Calculates the linear and angular velocity of the latest frame using the selected estimator. */
+	void UpdateVelocity();
+
+	/** Either registers with the velocity tracker subsystem or enables ticking, depending on whether tracking is active and the subsystem is used. */
+	void UpdateTrackingMode(bool bTrackingActive);
 };
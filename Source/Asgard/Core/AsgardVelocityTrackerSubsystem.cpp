@@ -0,0 +1,117 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "AsgardVelocityTrackerSubsystem.h"
+#include "Asgard/Core/AsgardVelocityTracker.h"
+#include "Async/ParallelFor.h"
+
+// Stat cycles
+DECLARE_CYCLE_STAT(TEXT("AsgardVelocityTracker Total"), STAT_ASGARD_VelocityTrackerTotal, STATGROUP_ASGARD_VelocityTracker);
+DECLARE_CYCLE_STAT(TEXT("AsgardVelocityTracker GatherTransforms"), STAT_ASGARD_VelocityTrackerGatherTransforms, STATGROUP_ASGARD_VelocityTracker);
+DECLARE_CYCLE_STAT(TEXT("AsgardVelocityTracker UpdateVelocities"), STAT_ASGARD_VelocityTrackerUpdateVelocities, STATGROUP_ASGARD_VelocityTracker);
+
+// Stat counters
+DECLARE_DWORD_COUNTER_STAT(TEXT("AsgardVelocityTracker RegisteredTrackers"), STAT_ASGARD_VelocityTrackerRegisteredTrackers, STATGROUP_ASGARD_VelocityTracker);
+
+// Number of registered trackers at which velocities are calculated across task graph workers
+static TAutoConsoleVariable<int32> CVarAsgardVelocityTrackerParallelThreshold(
+	TEXT("Asgard.VelocityTrackerParallelThreshold"),
+	128,
+	TEXT("The number of trackers registered with the velocity tracker subsystem at which velocities are calculated in parallel.\n")
+	TEXT("<= 0: Never calculate in parallel"),
+	ECVF_Scalability);
+static const auto VelocityTrackerParallelThreshold = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.VelocityTrackerParallelThreshold"));
+
+void UAsgardVelocityTrackerSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_VelocityTrackerTotal);
+
+	GatherTrackedTransforms(DeltaTime);
+	UpdateTrackedVelocities();
+
+	return;
+}
+
+bool UAsgardVelocityTrackerSubsystem::IsTickable() const
+{
+	return RegisteredTrackers.Num() > 0;
+}
+
+ETickableTickType UAsgardVelocityTrackerSubsystem::GetTickableTickType() const
+{
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		return ETickableTickType::Never;
+	}
+
+	return ETickableTickType::Conditional;
+}
+
+UWorld* UAsgardVelocityTrackerSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UAsgardVelocityTrackerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAsgardVelocityTrackerSubsystem, STATGROUP_ASGARD_VelocityTracker);
+}
+
+void UAsgardVelocityTrackerSubsystem::RegisterTracker(UAsgardVelocityTracker* Tracker)
+{
+	if (Tracker)
+	{
+		RegisteredTrackers.AddUnique(Tracker);
+	}
+
+	return;
+}
+
+void UAsgardVelocityTrackerSubsystem::UnregisterTracker(UAsgardVelocityTracker* Tracker)
+{
+	RegisteredTrackers.RemoveSingleSwap(Tracker, false);
+}
+
+void UAsgardVelocityTrackerSubsystem::GatherTrackedTransforms(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_VelocityTrackerGatherTransforms);
+
+	// Clear any trackers that have been garbage collected
+	RegisteredTrackers.RemoveAllSwap([](const UAsgardVelocityTracker* Tracker) { return Tracker == nullptr; }, false);
+
+	const int32 NumTrackers = RegisteredTrackers.Num();
+	TrackedLocations.SetNumUninitialized(NumTrackers, false);
+	TrackedRotations.SetNumUninitialized(NumTrackers, false);
+	TrackedDeltaTimes.SetNumUninitialized(NumTrackers, false);
+	for (int32 Idx = 0; Idx < NumTrackers; Idx++)
+	{
+		// Match the delta time the tracker would have received from its own tick function
+		const UAsgardVelocityTracker* Tracker = RegisteredTrackers[Idx];
+		const AActor* TrackerOwner = Tracker->GetOwner();
+		Tracker->GetTrackedLocationAndRotation(TrackedLocations[Idx], TrackedRotations[Idx]);
+		TrackedDeltaTimes[Idx] = TrackerOwner ? DeltaTime * TrackerOwner->CustomTimeDilation : DeltaTime;
+	}
+
+	SET_DWORD_STAT(STAT_ASGARD_VelocityTrackerRegisteredTrackers, NumTrackers);
+
+	return;
+}
+
+void UAsgardVelocityTrackerSubsystem::UpdateTrackedVelocities()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_VelocityTrackerUpdateVelocities);
+
+	// Each tracker only touches its own history, so trackers can safely be updated in parallel
+	const int32 NumTrackers = RegisteredTrackers.Num();
+	const int32 ParallelThreshold = VelocityTrackerParallelThreshold->GetInt();
+	const bool bForceSingleThread = ParallelThreshold <= 0 || NumTrackers < ParallelThreshold;
+	ParallelFor(NumTrackers, [this](int32 Idx)
+		{
+			UAsgardVelocityTracker* Tracker = RegisteredTrackers[Idx];
+			Tracker->AddFrameSample(TrackedLocations[Idx], TrackedRotations[Idx], TrackedDeltaTimes[Idx]);
+			Tracker->UpdateVelocity();
+			Tracker->LastLocation = TrackedLocations[Idx];
+		},
+		bForceSingleThread);
+
+	return;
+}
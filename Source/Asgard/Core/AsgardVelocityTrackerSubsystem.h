@@ -0,0 +1,61 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "AsgardVelocityTrackerSubsystem.generated.h"
+
+// Forward declarations
+class UAsgardVelocityTracker;
+
+// Stats group
+DECLARE_STATS_GROUP(TEXT("AsgardVelocityTracker"), STATGROUP_ASGARD_VelocityTracker, STATCAT_Advanced);
+
+/**
+ *	System for updating every registered velocity tracker in a single pass after physics.
+ *	Tracked transforms are read into contiguous arrays once per frame, then every velocity is calculated in one loop,
+ *	split across task graph workers when enough trackers are registered.
+ */
+UCLASS()
+class ASGARD_API UAsgardVelocityTrackerSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual bool IsTickableInEditor() const override { return false; }
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	// ~FTickableGameObject
+
+	/** Adds a tracker to the update pass. */
+	void RegisterTracker(UAsgardVelocityTracker* Tracker);
+
+	/** Removes a tracker from the update pass. */
+	void UnregisterTracker(UAsgardVelocityTracker* Tracker);
+
+private:
+	/** Trackers currently registered with the update pass. */
+	UPROPERTY()
+	TArray<UAsgardVelocityTracker*> RegisteredTrackers;
+
+	/** Tracked location of each registered tracker this frame. Persistent to avoid reallocating every frame. */
+	TArray<FVector> TrackedLocations;
+
+	/** Tracked rotation of each registered tracker this frame. Persistent to avoid reallocating every frame. */
+	TArray<FQuat> TrackedRotations;
+
+	/** Delta time of each registered tracker this frame, after the time dilation of its owner. */
+	TArray<float> TrackedDeltaTimes;
+
+	/** Reads the tracked transform of every registered tracker. */
+	void GatherTrackedTransforms(float DeltaTime);
+
+	/** Calculates the velocity of every registered tracker from the gathered transforms. */
+	void UpdateTrackedVelocities();
+};
@@ -2,6 +2,9 @@
 
 #include "AsgardPeripheralSensor.h"
 
+// Stat cycles
+DECLARE_CYCLE_STAT(TEXT("AsgardPeripheralSensor SelectTrackedPoints"), STAT_ASGARD_PeripheralSensorSelectTrackedPoints, STATGROUP_ASGARD_SphereSensor);
+
 UAsgardPeripheralSensor::UAsgardPeripheralSensor(const FObjectInitializer& ObjectInitializer /*= FObjectInitializer::Get()*/)
 	:Super(ObjectInitializer)
 {
@@ -26,106 +29,153 @@ void UAsgardPeripheralSensor::TickComponent(float DeltaTime, ELevelTick TickType
 	// If components are detected
 	if (GetDetectedComponents().Num() > 0)
 	{
-		// Cache variables
-		TMap<FVector, float> DistancesByDirection;
-		const FTransform& SelfTransform = GetComponentTransform();
-		FVector SelfLocation = SelfTransform.GetLocation();
-		FVector SelfForward = SelfTransform.GetUnitAxis(EAxis::X);
-		float MinForwardAngle = FMath::DegreesToRadians(Min3DAngleFromSensor);
-
-		// For each detected component
-		for (UPrimitiveComponent* DetectedComponent : GetDetectedComponents())
-		{
-			if (DetectedComponent)
-			{
-				// Get the closest point and distance
-				FVector OutPointOnBody;
-				float DistanceFromSelf = DetectedComponent->GetClosestPointOnCollision(SelfLocation, OutPointOnBody);
+		SCOPE_CYCLE_COUNTER(STAT_ASGARD_PeripheralSensorSelectTrackedPoints);
+		GatherCandidatePoints();
+		FilterCandidatePoints(GetComponentTransform());
+		SelectTrackedPoints();
+	}
 
-				// If the point is far enough away
-				if (DistanceFromSelf > MinDistanceFromSensor)
-				{
-					// If the point is angled enough away from the center of the Sensor
-					OutPointOnBody = (OutPointOnBody - SelfLocation).GetSafeNormal();
-					float AngleFromForward = FMath::Acos(FMath::Abs(FVector::DotProduct(OutPointOnBody, SelfForward)));
-					if (AngleFromForward > MinForwardAngle)
-					{
-						// Add to potential points and distances
-						auto ExistingEntry = DistancesByDirection.Find(OutPointOnBody);
-						if (ExistingEntry != nullptr)
-						{
-							if (*ExistingEntry < DistanceFromSelf)
-							{
-								*ExistingEntry = DistanceFromSelf;
-							}
-						}
-						else
-						{
-							DistancesByDirection.Add(OutPointOnBody, DistanceFromSelf);
-						}
-					}
-				}
-			}
+	return;
+}
+
+void UAsgardPeripheralSensor::GatherCandidatePoints()
+{
+	const FVector SelfLocation = GetComponentLocation();
+
+	// Batch the closest point queries first so the filtering below runs over contiguous arrays
+	CandidatePoints.Reset();
+	CandidateDistances.Reset();
+	for (UPrimitiveComponent* DetectedComponent : GetDetectedComponents())
+	{
+		if (DetectedComponent)
+		{
+			FVector OutPointOnBody;
+			CandidateDistances.Add(DetectedComponent->GetClosestPointOnCollision(SelfLocation, OutPointOnBody));
+			CandidatePoints.Add(OutPointOnBody);
 		}
+	}
+
+	return;
+}
+
+void UAsgardPeripheralSensor::FilterCandidatePoints(const FTransform& SelfTransform)
+{
+	// Cache variables
+	const FVector SelfLocation = SelfTransform.GetLocation();
+	const FVector SelfForward = SelfTransform.GetUnitAxis(EAxis::X);
+
+	// Acos(Abs(Dot)) > MinAngle is equivalent to Abs(Dot) < Cos(MinAngle), which avoids an Acos per point
+	const float MaxForwardCos = FMath::Cos(FMath::DegreesToRadians(Min3DAngleFromSensor));
 
-		// If there is at least one potential point
-		if (DistancesByDirection.Num() > 0)
+	// Filter the points in place, keeping those far enough away and angled enough away from the center of the Sensor
+	const int32 NumPoints = CandidatePoints.Num();
+	CandidateDirectionsY.SetNumUninitialized(NumPoints, false);
+	CandidateDirectionsZ.SetNumUninitialized(NumPoints, false);
+	CandidateIndicesByDirection.Reset();
+	int32 NumCandidates = 0;
+	for (int32 Idx = 0; Idx < NumPoints; Idx++)
+	{
+		const float DistanceFromSelf = CandidateDistances[Idx];
+		const FVector Direction = (CandidatePoints[Idx] - SelfLocation).GetSafeNormal();
+		if (DistanceFromSelf > MinDistanceFromSensor
+			&& FMath::Abs(FVector::DotProduct(Direction, SelfForward)) < MaxForwardCos)
 		{
-			// Sort the points by distance
-			DistancesByDirection.ValueSort([](const float A, const float B) {
-				return A < B;
-				});
-
-			// Cache variables
-			TArray<FVector> TrackedPoints;
-			TrackedPoints.Reserve(MaxTrackedPoints);
-			float MinAngleFromPoint = FMath::DegreesToRadians(Min2DAngleBetweenTrackedPoints);
-
-			// For each potential point
-			for (auto& DistanceByPoint : DistancesByDirection)
+			// Points in the same direction are only considered once, at the furthest distance
+			int32* ExistingIdx = CandidateIndicesByDirection.Find(Direction);
+			if (ExistingIdx != nullptr)
 			{
-				// Project and normalize the point
-				FVector ProjectedPointNormalized = DistanceByPoint.Key;
-				ProjectedPointNormalized = SelfTransform.InverseTransformVectorNoScale(ProjectedPointNormalized);
-				ProjectedPointNormalized.X = 0.0f;
-				ProjectedPointNormalized = ProjectedPointNormalized.GetSafeNormal();
-				
-				// Check the angle to the point against the angle from
-				bool bTooCloseToTrackedPoint = false;
-				for (FVector& CurrPoint : TrackedPoints)
+				if (CandidateDistances[*ExistingIdx] < DistanceFromSelf)
 				{
-					// If the angle is too close to a currently tracked point, abort the loop
-					if (FMath::Acos(FVector::DotProduct(CurrPoint, ProjectedPointNormalized)) < MinAngleFromPoint)
-					{
-						bTooCloseToTrackedPoint = true;
-						break;
-					}
+					CandidateDistances[*ExistingIdx] = DistanceFromSelf;
 				}
+				continue;
+			}
+			CandidateIndicesByDirection.Add(Direction, NumCandidates);
 
-				// If the angle was far enough away from any currently tracked points, add it to the list of tracked points
-				if (!bTooCloseToTrackedPoint)
-				{
-					TrackedPoints.Emplace(ProjectedPointNormalized);
+			// Project and normalize the direction across the Sensor plane
+			const FVector LocalDirection = SelfTransform.InverseTransformVectorNoScale(Direction);
+			const float SizeSquared2D = FMath::Square(LocalDirection.Y) + FMath::Square(LocalDirection.Z);
+			const float InvSize2D = SizeSquared2D > SMALL_NUMBER ? FMath::InvSqrt(SizeSquared2D) : 0.0f;
 
-					// If we have reached the limited of tracked points, break the loop
-					if (MaxTrackedPoints > 0 && TrackedPoints.Num() >= MaxTrackedPoints)
-					{
-						break;
-					}
-				}
+			CandidateDistances[NumCandidates] = DistanceFromSelf;
+			CandidateDirectionsY[NumCandidates] = LocalDirection.Y * InvSize2D;
+			CandidateDirectionsZ[NumCandidates] = LocalDirection.Z * InvSize2D;
+			NumCandidates++;
+		}
+	}
+
+	CandidateDistances.SetNum(NumCandidates, false);
+	CandidateDirectionsY.SetNum(NumCandidates, false);
+	CandidateDirectionsZ.SetNum(NumCandidates, false);
+
+	return;
+}
+
+void UAsgardPeripheralSensor::SelectTrackedPoints()
+{
+	const int32 NumCandidates = CandidateDistances.Num();
+	if (NumCandidates <= 0)
+	{
+		return;
+	}
+
+	// Build a heap of candidates by distance, so only the candidates actually visited are ever ordered
+	CandidateOrder.SetNumUninitialized(NumCandidates, false);
+	for (int32 Idx = 0; Idx < NumCandidates; Idx++)
+	{
+		CandidateOrder[Idx] = Idx;
+	}
+	const auto ByDistance = [this](const int32 A, const int32 B) {
+		return CandidateDistances[A] < CandidateDistances[B];
+	};
+	CandidateOrder.Heapify(ByDistance);
+
+	// Cache variables
+	// Acos(Dot) < MinAngle is equivalent to Dot > Cos(MinAngle)
+	const float MaxCosBetweenPoints = FMath::Cos(FMath::DegreesToRadians(Min2DAngleBetweenTrackedPoints));
+	TArray<float, TInlineAllocator<8>> TrackedPointsY;
+	TArray<float, TInlineAllocator<8>> TrackedPointsZ;
+
+	// Visit candidates nearest first until enough points are tracked
+	while (CandidateOrder.Num() > 0)
+	{
+		int32 CandidateIdx;
+		CandidateOrder.HeapPop(CandidateIdx, ByDistance, false);
+		const float CandidateY = CandidateDirectionsY[CandidateIdx];
+		const float CandidateZ = CandidateDirectionsZ[CandidateIdx];
+
+		// If the angle is too close to a currently tracked point, skip the candidate
+		bool bTooCloseToTrackedPoint = false;
+		for (int32 TrackedIdx = 0; TrackedIdx < TrackedPointsY.Num(); TrackedIdx++)
+		{
+			if ((TrackedPointsY[TrackedIdx] * CandidateY) + (TrackedPointsZ[TrackedIdx] * CandidateZ) > MaxCosBetweenPoints)
+			{
+				bTooCloseToTrackedPoint = true;
+				break;
 			}
+		}
+
+		if (!bTooCloseToTrackedPoint)
+		{
+			TrackedPointsY.Add(CandidateY);
+			TrackedPointsZ.Add(CandidateZ);
 
-			// Calculate the roll angle to each tracked point
-			for (FVector& TrackedPoint : TrackedPoints)
+			// If we have reached the limit of tracked points, break the loop
+			if (MaxTrackedPoints > 0 && TrackedPointsY.Num() >= MaxTrackedPoints)
 			{
-				float ValueToAdd = FMath::RadiansToDegrees(FMath::Atan2(TrackedPoint.Y, TrackedPoint.Z));
-				RollAnglesToNearestTrackedPoints.Add(ValueToAdd);
+				break;
 			}
-			RollAnglesToNearestTrackedPoints.Sort([](const float A, const float B) {
-				return A < B;
-				});
 		}
 	}
 
+	// Calculate the roll angle to each tracked point
+	for (int32 TrackedIdx = 0; TrackedIdx < TrackedPointsY.Num(); TrackedIdx++)
+	{
+		RollAnglesToNearestTrackedPoints.Add(FMath::RadiansToDegrees(FMath::Atan2(TrackedPointsY[TrackedIdx], TrackedPointsZ[TrackedIdx])));
+	}
+	RollAnglesToNearestTrackedPoints.Sort([](const float A, const float B) {
+		return A < B;
+		});
+
 	return;
 }
@@ -56,4 +56,51 @@ private:
 	*/
 	UPROPERTY(BlueprintReadOnly, Category = "Asgard|PeripheralSensor", meta = (AllowPrivateAccess = "true"))
 	TArray<float> RollAnglesToNearestTrackedPoints;
+
+	/**
+	* Closest points on each detected component, gathered in one batch before filtering.
+	*/
+	TArray<FVector> CandidatePoints;
+
+	/**
+	* Distance to each candidate point.
+	*/
+	TArray<float> CandidateDistances;
+
+	/**
+	* Y component of the direction to each candidate point, projected onto the Sensor plane and normalized.
+	*/
+	TArray<float> CandidateDirectionsY;
+
+	/**
+	* Z component of the direction to each candidate point, projected onto the Sensor plane and normalized.
+	*/
+	TArray<float> CandidateDirectionsZ;
+
+	/**
+	* Index of the candidate for each direction, used to consider points in the same direction only once.
+	*/
+	TMap<FVector, int32> CandidateIndicesByDirection;
+
+	/**
+	* Heap of candidate indices ordered by distance, used to select the nearest points without sorting every candidate.
+	*/
+	TArray<int32> CandidateOrder;
+
+	/**
+	* Gathers the closest point on each detected component.
+	*/
+	void GatherCandidatePoints();
+
+	/**
+	* Filters out candidate points outside the Sensor's periphery and projects the rest across the Sensor plane.
+	*/
+	void FilterCandidatePoints(const FTransform& SelfTransform);
+
+	/**
+	* Selects the nearest candidate points that are far enough apart and calculates the roll angle to each.
+	*/
+	void SelectTrackedPoints();
+
+	friend class FAsgardPeripheralSensorSelectionTest;
 };
@@ -1,6 +1,7 @@
 ﻿// Copyright © 2020 Justin Camden All Rights Reserved
 
 #include "AsgardSphereSensor.h"
+#include "Asgard/Sensor/AsgardSphereSensorSubsystem.h"
 #include "Runtime/Engine/Classes/Engine/World.h"
 
 // Stat cycles
@@ -17,6 +18,15 @@ static TAutoConsoleVariable<int32> CVarAsgardSphereSensorDrawDebug(
 	ECVF_Scalability | ECVF_RenderThreadSafe);
 static const auto SphereSensorDrawDebug = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.SphereSensorDrawDebug"));
 
+// Force adaptive rate sensors to perform an overlap test every tick
+static TAutoConsoleVariable<int32> CVarAsgardSphereSensorForceFullRate(
+	TEXT("Asgard.SphereSensorForceFullRate"),
+	0,
+	TEXT("Whether to force SphereSensors using adaptive query rates to perform an overlap test every tick.\n")
+	TEXT("0: Disabled, 1: Enabled"),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+static const auto SphereSensorForceFullRate = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.SphereSensorForceFullRate"));
+
 // Macros for debug builds
 #if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
 #include "DrawDebugHelpers.h"
@@ -36,6 +46,10 @@ UAsgardSphereSensor::UAsgardSphereSensor(const FObjectInitializer & ObjectInitia
 	DetectionChannel = ECC_Visibility;
 	bAutoIgnoreOwner = true;
 	bUseAsyncOverlapTests = true;
+	AdaptiveQueryMinRate = 4.0f;
+	AdaptiveQueryMaxRate = 30.0f;
+	AdaptiveQueryMinRateSpeed = 5.0f;
+	AdaptiveQueryFullRateSpeed = 150.0f;
 }
 
 
@@ -44,6 +58,55 @@ void UAsgardSphereSensor::BeginPlay()
 {
 	Super::BeginPlay();
 	AsyncOverlapTestDelegate.BindUObject(this, &UAsgardSphereSensor::OnAsyncOverlapTestCompleted);
+	LastTickLocation = GetComponentLocation();
+	LastOverlapTestLocation = LastTickLocation;
+	TimeSinceLastOverlapTest = BIG_NUMBER;
+	SetUseBatchedOverlapTests(bUseBatchedOverlapTests);
+}
+
+// Called when the game ends
+void UAsgardSphereSensor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UWorld* World = GetWorld();
+	if (World && bRegisteredForBatchedOverlapTests)
+	{
+		UAsgardSphereSensorSubsystem* SensorSubsystem = World->GetSubsystem<UAsgardSphereSensorSubsystem>();
+		if (SensorSubsystem)
+		{
+			SensorSubsystem->UnregisterSensor(this);
+		}
+		bRegisteredForBatchedOverlapTests = false;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UAsgardSphereSensor::SetUseBatchedOverlapTests(bool bNewUseBatchedOverlapTests)
+{
+	bUseBatchedOverlapTests = bNewUseBatchedOverlapTests;
+
+	// Registration is handled in BeginPlay if the game has not started yet
+	UWorld* World = GetWorld();
+	if (!World || !HasBegunPlay())
+	{
+		return;
+	}
+
+	UAsgardSphereSensorSubsystem* SensorSubsystem = World->GetSubsystem<UAsgardSphereSensorSubsystem>();
+	if (SensorSubsystem && bUseBatchedOverlapTests != bRegisteredForBatchedOverlapTests)
+	{
+		if (bUseBatchedOverlapTests)
+		{
+			SensorSubsystem->RegisterSensor(this);
+		}
+		else
+		{
+			SensorSubsystem->UnregisterSensor(this);
+		}
+		bRegisteredForBatchedOverlapTests = bUseBatchedOverlapTests;
+	}
+
+	return;
 }
 
 
@@ -52,28 +115,45 @@ void UAsgardSphereSensor::TickComponent(float DeltaTime, ELevelTick TickType, FA
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
+	// Sensors using adaptive query rates skip overlap tests while moving slowly
+	bOverlapTestPending = UpdateOverlapTestRate(DeltaTime);
+	if (!bOverlapTestPending)
+	{
+		return;
+	}
+
+	// If the sphere sensor subsystem is answering overlap tests for this sensor, there is nothing else to do
+	if (bRegisteredForBatchedOverlapTests && UAsgardSphereSensorSubsystem::IsBatchingEnabled())
+	{
+		return;
+	}
+
 	UWorld* World = GetWorld();
 	if (World)
 	{
 		SCOPE_CYCLE_COUNTER(STAT_ASGARD_SphereSensorOverlapTest);
+		SCOPE_CYCLE_COUNTER(STAT_ASGARD_SphereSensorBatchPerSensorOverlapTests);
+		INC_DWORD_STAT(STAT_ASGARD_SphereSensorBatchPerSensorQueries);
 
 		// Overlap test
 		TArray<FOverlapResult> OutOverlaps;
-		const FTransform& SelfTransform = GetComponentTransform();
-		const FCollisionShape CollisionShape = FCollisionShape::MakeSphere(Radius);
+		FVector QueryLocation;
+		FQuat QueryRotation;
+		FCollisionShape CollisionShape;
+		BeginOverlapTest(QueryLocation, QueryRotation, CollisionShape);
 		FCollisionQueryParams Params;
 		Params.AddIgnoredActors(IgnoredActors);
 		if (bAutoIgnoreOwner)
 		{
-			Params.AddIgnoredActors(TArray<AActor*> {GetOwner()});
+			Params.AddIgnoredActor(GetOwner());
 		}
 		Params.TraceTag = FName("AsgardSphereSensorOverlapTest");
 
 		if (bUseAsyncOverlapTests)
 		{
 			AsyncOverlapTestHandle = World->AsyncOverlapByChannel(
-				SelfTransform.GetLocation(), 
-				SelfTransform.GetRotation(), 
+				QueryLocation, 
+				QueryRotation, 
 				DetectionChannel, 
 				CollisionShape, 
 				Params, 
@@ -85,8 +165,8 @@ void UAsgardSphereSensor::TickComponent(float DeltaTime, ELevelTick TickType, FA
 			FCollisionResponseParams ResponseParams;
 			bool bBlockingHits = World->OverlapMultiByChannel(
 				OutOverlaps,
-				SelfTransform.GetLocation(),
-				SelfTransform.GetRotation(),
+				QueryLocation,
+				QueryRotation,
 				DetectionChannel,
 				CollisionShape,
 				Params,
@@ -111,127 +191,63 @@ void UAsgardSphereSensor::ProcessOverlaps(TArray<FOverlapResult>& Overlaps, bool
 {
 	SCOPE_CYCLE_COUNTER(STAT_ASGARD_SphereSensorProcessOverlaps);
 
-	// If we detect nothing, clear the list of detected components
-	if (DetectedComponents.Num() && (Overlaps.Num() <= 0 || (!bBlockingHits && bDetectBlockingHitsOnly)))
-	{
-		for (UPrimitiveComponent* LostComponent : DetectedComponents)
-		{
-			OnComponentLost.Broadcast(LostComponent);
-		}
-		for (AActor* LostActor : DetectedActors)
-		{
-			OnActorLost.Broadcast(LostActor);
-		}
-		DetectedComponents.Reset();
-		DetectedActors.Reset();
+	// Begin a new detection generation
+	// Every component and actor seen during this update will be stamped with it, and anything left unstamped is lost
+	DetectionGeneration++;
 
-	}
-	// Otherwise, process the results normally
-	else
+	// If we only detect blocking hits and there were none, nothing is stamped and everything will be lost
+	if (bBlockingHits || !bDetectBlockingHitsOnly)
 	{
-		TSet<AActor*> LostActors = DetectedActors;
-		TSet<UPrimitiveComponent*> LostComponents = DetectedComponents;
-
-		// If we only detect blocking hits, filter on whether the component is valid and a blocking hit
-		if (!bDetectBlockingHitsOnly)
+		for (FOverlapResult& Overlap : Overlaps)
 		{
-			for (FOverlapResult& Overlap : Overlaps)
+			// If we only detect blocking hits, filter on whether the component is valid and a blocking hit
+			// Otherwise, only filter on whether the component is valid
+			UPrimitiveComponent* DetectedComponent = Overlap.Component.Get();
+			if (DetectedComponent && (!bDetectBlockingHitsOnly || Overlap.bBlockingHit))
 			{
-				UPrimitiveComponent* DetectedComponent = Overlap.Component.Get();
-				if (DetectedComponent)
+				// If the component is valid, the actor should be valid
+				AActor* DetectedActor = Overlap.Actor.Get();
+
+				// Add the actor to the detected list and stamp it
+				bool bActorAlreadyDetected = false;
+				StampDetection(DetectedActorGenerations, DetectedActors.Add(DetectedActor, &bActorAlreadyDetected).AsInteger());
+
+				// Add the component to the detected list and stamp it
+				bool bComponentAlreadyDetected = false;
+				StampDetection(DetectedComponentGenerations, DetectedComponents.Add(DetectedComponent, &bComponentAlreadyDetected).AsInteger());
+
+				// If it's a new actor, broadcast the on detected event for it and its detected component
+				if (!bActorAlreadyDetected)
 				{
-					// If the component is valid, the actor should be valid
-					AActor* DetectedActor = Overlap.Actor.Get();
-
-					// Add the actor to the detected list
-					bool bAlreadyDetected = false;
-					DetectedActors.Add(DetectedActor, &bAlreadyDetected);
-
-					// If it's a new actor, broadcast the on detected event for it and its detected component
-					if (!bAlreadyDetected)
-					{
-						DetectedComponents.Add(DetectedComponent);
-						OnActorDetected.Broadcast(DetectedActor, DetectedComponent);
-						OnComponentDetected.Broadcast(DetectedComponent);
-					}
-
-					// If the actor is already detected, check if the component is as well
-					else
-					{
-						// Remove detected actor from lost list if appropriate
-						LostActors.Remove(DetectedActor);
-						DetectedComponents.Add(DetectedComponent, &bAlreadyDetected);
-
-						// If so, broadcast the appropriate event
-						if (!bAlreadyDetected)
-						{
-							OnComponentDetected.Broadcast(DetectedComponent);
-						}
-						else
-						{
-							// Remove detected component from lost list if appropriate
-							LostComponents.Remove(DetectedComponent);
-						}
-					}
+					OnActorDetected.Broadcast(DetectedActor, DetectedComponent);
+					OnComponentDetected.Broadcast(DetectedComponent);
 				}
-			}
-		}
 
-		// Otherwise, only filter on whether the component is valid
-		else
-		{
-			for (FOverlapResult& Overlap : Overlaps)
-			{
-				UPrimitiveComponent* DetectedComponent = Overlap.Component.Get();
-				if (DetectedComponent && Overlap.bBlockingHit)
+				// Otherwise, if it's a new component, broadcast the on detected event for it alone
+				else if (!bComponentAlreadyDetected)
 				{
-					// If the component is valid, the actor should be valid
-					AActor* DetectedActor = Overlap.Actor.Get();
-
-					// Add the actor to the detected list
-					bool bAlreadyDetected = false;
-					DetectedActors.Add(DetectedActor, &bAlreadyDetected);
-
-					// If it's a new actor, broadcast the on detected event for it and its detected component
-					if (!bAlreadyDetected)
-					{
-						DetectedComponents.Add(DetectedComponent);
-						OnActorDetected.Broadcast(DetectedActor, DetectedComponent);
-						OnComponentDetected.Broadcast(DetectedComponent);
-					}
-
-					// If the actor is already detected, check if the component is as well
-					else
-					{
-						// Remove detected actor from lost list if appropriate
-						LostActors.Remove(DetectedActor);
-						DetectedComponents.Add(DetectedComponent, &bAlreadyDetected);
-
-						// If so, broadcast the appropriate event
-						if (!bAlreadyDetected)
-						{
-							OnComponentDetected.Broadcast(DetectedComponent);
-						}
-						else
-						{
-							// Remove detected component from lost list if appropriate
-							LostComponents.Remove(DetectedComponent);
-						}
-					}
+					OnComponentDetected.Broadcast(DetectedComponent);
 				}
 			}
 		}
+	}
 
-
-		// Clear components and actors that are no longer detected
-		for (UPrimitiveComponent* LostComponent : LostComponents)
+	// Sweep components and actors that were not seen during this update
+	for (auto It = DetectedComponents.CreateIterator(); It; ++It)
+	{
+		if (DetectedComponentGenerations[It.GetId().AsInteger()] != DetectionGeneration)
 		{
-			DetectedComponents.Remove(LostComponent);
+			UPrimitiveComponent* LostComponent = *It;
+			It.RemoveCurrent();
 			OnComponentLost.Broadcast(LostComponent);
 		}
-		for (AActor* LostActor : LostActors)
+	}
+	for (auto It = DetectedActors.CreateIterator(); It; ++It)
+	{
+		if (DetectedActorGenerations[It.GetId().AsInteger()] != DetectionGeneration)
 		{
-			DetectedActors.Remove(LostActor);
+			AActor* LostActor = *It;
+			It.RemoveCurrent();
 			OnActorLost.Broadcast(LostActor);
 		}
 	}
@@ -240,3 +256,64 @@ void UAsgardSphereSensor::ProcessOverlaps(TArray<FOverlapResult>& Overlaps, bool
 
 	return;
 }
+
+void UAsgardSphereSensor::StampDetection(TArray<uint32>& Generations, int32 ElementIdx)
+{
+	// Element indices are stable for as long as the element remains in the set, so the table only grows to the set's high water mark
+	if (ElementIdx >= Generations.Num())
+	{
+		Generations.SetNumZeroed(ElementIdx + 1, false);
+	}
+	Generations[ElementIdx] = DetectionGeneration;
+
+	return;
+}
+
+bool UAsgardSphereSensor::UpdateOverlapTestRate(float DeltaTime)
+{
+	const FVector CurrentLocation = GetComponentLocation();
+	TimeSinceLastOverlapTest += DeltaTime;
+
+	// Calculate speed with a finite difference over the last tick, as in UAsgardVelocityTracker
+	const float Speed = DeltaTime > 0.0f ? FVector::Dist(CurrentLocation, LastTickLocation) / DeltaTime : 0.0f;
+	LastTickLocation = CurrentLocation;
+
+	// Stay tick-exact while moving fast, or if adaptive rates are disabled
+	if (!bUseAdaptiveQueryRate || SphereSensorForceFullRate->GetInt() || Speed >= AdaptiveQueryFullRateSpeed)
+	{
+		return true;
+	}
+
+	// Otherwise, scale the rate from the minimum while still to the maximum just below full rate
+	const float SpeedAlpha = FMath::Clamp((Speed - AdaptiveQueryMinRateSpeed) / FMath::Max(AdaptiveQueryFullRateSpeed - AdaptiveQueryMinRateSpeed, KINDA_SMALL_NUMBER), 0.0f, 1.0f);
+	const float QueryRate = FMath::Lerp(AdaptiveQueryMinRate, AdaptiveQueryMaxRate, SpeedAlpha);
+
+	return TimeSinceLastOverlapTest * QueryRate >= 1.0f;
+}
+
+void UAsgardSphereSensor::BeginOverlapTest(FVector& OutLocation, FQuat& OutRotation, FCollisionShape& OutShape)
+{
+	const FTransform& SelfTransform = GetComponentTransform();
+	OutLocation = SelfTransform.GetLocation();
+	OutRotation = SelfTransform.GetRotation();
+	OutShape = FCollisionShape::MakeSphere(Radius);
+
+	// If sweeping, stretch into a capsule spanning from the location of the last overlap test to the current location
+	if (bUseAdaptiveQueryRate && bSweepAdaptiveQueries)
+	{
+		const FVector SweepDelta = OutLocation - LastOverlapTestLocation;
+		const float SweepLength = SweepDelta.Size();
+		if (SweepLength > KINDA_SMALL_NUMBER)
+		{
+			OutShape = FCollisionShape::MakeCapsule(Radius, Radius + (SweepLength * 0.5f));
+			OutRotation = FRotationMatrix::MakeFromZ(SweepDelta).ToQuat();
+			OutLocation = LastOverlapTestLocation + (SweepDelta * 0.5f);
+		}
+	}
+
+	LastOverlapTestLocation = SelfTransform.GetLocation();
+	TimeSinceLastOverlapTest = 0.0f;
+	bOverlapTestPending = false;
+
+	return;
+}
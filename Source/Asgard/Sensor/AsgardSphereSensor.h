@@ -31,6 +31,9 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
@@ -98,6 +101,52 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SphereSensor")
 	bool bUseAsyncOverlapTests;
 
+	/**
+	* Whether overlap tests should be answered by the sphere sensor subsystem in one batched pass with other sensors.
+	* If enabled, overlap tests will be one frame out of date, and bUseAsyncOverlapTests will be ignored.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Asgard|SphereSensor")
+	bool bUseBatchedOverlapTests;
+
+	/**
+	* Whether to scale how often overlap tests are performed with the speed of the sensor.
+	* If enabled, the sensor performs an overlap test every tick while moving fast, and drops to AdaptiveQueryMinRate while still.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SphereSensor|AdaptiveRate")
+	bool bUseAdaptiveQueryRate;
+
+	/**
+	* Overlap tests per second while the sensor is at or below AdaptiveQueryMinRateSpeed.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SphereSensor|AdaptiveRate", meta = (EditCondition = "bUseAdaptiveQueryRate", ClampMin = "0.1", UIMin = "0.1"))
+	float AdaptiveQueryMinRate;
+
+	/**
+	* Overlap tests per second while the sensor is just below AdaptiveQueryFullRateSpeed.
+	* The rate is interpolated between AdaptiveQueryMinRate and this value as speed increases.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SphereSensor|AdaptiveRate", meta = (EditCondition = "bUseAdaptiveQueryRate", ClampMin = "0.1", UIMin = "0.1"))
+	float AdaptiveQueryMaxRate;
+
+	/**
+	* Speed at or below which the sensor is considered still and uses AdaptiveQueryMinRate.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SphereSensor|AdaptiveRate", meta = (EditCondition = "bUseAdaptiveQueryRate", ClampMin = "0.0", UIMin = "0.0"))
+	float AdaptiveQueryMinRateSpeed;
+
+	/**
+	* Speed at or above which the sensor performs an overlap test every tick.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SphereSensor|AdaptiveRate", meta = (EditCondition = "bUseAdaptiveQueryRate", ClampMin = "0.0", UIMin = "0.0"))
+	float AdaptiveQueryFullRateSpeed;
+
+	/**
+	* Whether to stretch the sensor into a capsule covering the path travelled since the previous overlap test.
+	* Prevents objects passed through between overlap tests from being missed.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SphereSensor|AdaptiveRate", meta = (EditCondition = "bUseAdaptiveQueryRate"))
+	bool bSweepAdaptiveQueries;
+
 #if WITH_EDITORONLY_DATA
 	/**
 	* Whether to debug draw the sphere sensor.
@@ -118,7 +167,16 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Asgard|SphereSensor")
 	const TSet<AActor*>& GetDetectedActors() const { return DetectedActors; }
 
+	/**
+	* Setter for bUseBatchedOverlapTests.
+	* Registers or unregisters the sensor with the sphere sensor subsystem as appropriate.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Asgard|SphereSensor")
+	void SetUseBatchedOverlapTests(bool bNewUseBatchedOverlapTests);
+
 private:
+	friend class UAsgardSphereSensorSubsystem;
+
 	/**
 	* List of detected components.
 	*/
@@ -131,6 +189,21 @@ private:
 	UPROPERTY()
 	TSet<AActor*> DetectedActors;
 
+	/**
+	* The generation of the most recent call to ProcessOverlaps.
+	*/
+	uint32 DetectionGeneration;
+
+	/**
+	* The generation each detected component was last seen in, indexed by its element id in DetectedComponents.
+	*/
+	TArray<uint32> DetectedComponentGenerations;
+
+	/**
+	* The generation each detected actor was last seen in, indexed by its element id in DetectedActors.
+	*/
+	TArray<uint32> DetectedActorGenerations;
+
 	/**
 	* Handle for async Overlap, if enabled.
 	*/
@@ -141,6 +214,31 @@ private:
 	*/
 	FOverlapDelegate AsyncOverlapTestDelegate;
 
+	/**
+	* Whether the sensor is currently registered with the sphere sensor subsystem.
+	*/
+	bool bRegisteredForBatchedOverlapTests;
+
+	/**
+	* Whether an overlap test is due this frame.
+	*/
+	bool bOverlapTestPending;
+
+	/**
+	* Time elapsed since the last overlap test.
+	*/
+	float TimeSinceLastOverlapTest;
+
+	/**
+	* Location of the sensor on the previous tick, used to calculate its speed.
+	*/
+	FVector LastTickLocation;
+
+	/**
+	* Location of the sensor during the last overlap test, used for swept adaptive queries.
+	*/
+	FVector LastOverlapTestLocation;
+
 	/**
 	* Called when the async Overlap completes.
 	*/
@@ -150,4 +248,21 @@ private:
 	* Processes overlaps and updates state accordingly.
 	*/
 	void ProcessOverlaps(TArray<FOverlapResult>& Overlaps, bool bBlockingHits);
+
+	/**
+	* Stamps the detection at an element index with the current generation.
+	*/
+	void StampDetection(TArray<uint32>& Generations, int32 ElementIdx);
+
+	/**
+	* Updates the speed of the sensor and returns whether an overlap test is due this frame.
+	*/
+	bool UpdateOverlapTestRate(float DeltaTime);
+
+	/**
+	* Calculates the shape to use for the overlap test this frame, and marks the test as performed.
+	*/
+	void BeginOverlapTest(FVector& OutLocation, FQuat& OutRotation, FCollisionShape& OutShape);
+
+	friend class FAsgardSphereSensorProcessOverlapsTest;
 };
@@ -0,0 +1,273 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "AsgardSphereSensorSubsystem.h"
+#include "Asgard/Sensor/AsgardSphereSensor.h"
+#include "Runtime/Engine/Classes/Engine/World.h"
+
+// Stat cycles
+DECLARE_CYCLE_STAT(TEXT("AsgardSphereSensorBatch Total"), STAT_ASGARD_SphereSensorBatchTotal, STATGROUP_ASGARD_SphereSensorBatch);
+DECLARE_CYCLE_STAT(TEXT("AsgardSphereSensorBatch Clustering"), STAT_ASGARD_SphereSensorBatchClustering, STATGROUP_ASGARD_SphereSensorBatch);
+DECLARE_CYCLE_STAT(TEXT("AsgardSphereSensorBatch BroadPhase"), STAT_ASGARD_SphereSensorBatchBroadPhase, STATGROUP_ASGARD_SphereSensorBatch);
+DECLARE_CYCLE_STAT(TEXT("AsgardSphereSensorBatch NarrowPhase"), STAT_ASGARD_SphereSensorBatchNarrowPhase, STATGROUP_ASGARD_SphereSensorBatch);
+DEFINE_STAT(STAT_ASGARD_SphereSensorBatchPerSensorOverlapTests);
+
+// Stat counters
+DECLARE_DWORD_COUNTER_STAT(TEXT("AsgardSphereSensorBatch BatchedSensors"), STAT_ASGARD_SphereSensorBatchBatchedSensors, STATGROUP_ASGARD_SphereSensorBatch);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AsgardSphereSensorBatch BatchedQueries"), STAT_ASGARD_SphereSensorBatchBatchedQueries, STATGROUP_ASGARD_SphereSensorBatch);
+DEFINE_STAT(STAT_ASGARD_SphereSensorBatchPerSensorQueries);
+
+// Console variable setup so we can enable and disable batching from the console
+static TAutoConsoleVariable<int32> CVarAsgardSphereSensorBatching(
+	TEXT("Asgard.SphereSensorBatching"),
+	1,
+	TEXT("Whether sensors using batched overlap tests are answered by the sphere sensor subsystem.\n")
+	TEXT("0: Disabled, sensors perform their own overlap tests, 1: Enabled"),
+	ECVF_Scalability);
+static const auto SphereSensorBatching = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.SphereSensorBatching"));
+
+// Largest half extent of the box enclosing a cluster of batched sensors
+static TAutoConsoleVariable<float> CVarAsgardSphereSensorBatchMaxClusterExtent(
+	TEXT("Asgard.SphereSensorBatchMaxClusterExtent"),
+	100.0f,
+	TEXT("The maximum half extent of the box enclosing a cluster of batched sensors.\n")
+	TEXT("Sensors further apart than this will use separate broad-phase queries."),
+	ECVF_Scalability);
+static const auto SphereSensorBatchMaxClusterExtent = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.SphereSensorBatchMaxClusterExtent"));
+
+void UAsgardSphereSensorSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_SphereSensorBatchTotal);
+
+	UWorld* World = GetWorld();
+	if (World && IsBatchingEnabled())
+	{
+		GatherSensorQueries();
+		BuildSensorClusters();
+		for (const FSensorCluster& Cluster : SensorClusters)
+		{
+			ProcessSensorCluster(*World, Cluster);
+		}
+	}
+
+	return;
+}
+
+bool UAsgardSphereSensorSubsystem::IsTickable() const
+{
+	return RegisteredSensors.Num() > 0;
+}
+
+ETickableTickType UAsgardSphereSensorSubsystem::GetTickableTickType() const
+{
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		return ETickableTickType::Never;
+	}
+
+	return ETickableTickType::Conditional;
+}
+
+UWorld* UAsgardSphereSensorSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UAsgardSphereSensorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAsgardSphereSensorSubsystem, STATGROUP_ASGARD_SphereSensorBatch);
+}
+
+void UAsgardSphereSensorSubsystem::RegisterSensor(UAsgardSphereSensor* Sensor)
+{
+	if (Sensor)
+	{
+		RegisteredSensors.AddUnique(Sensor);
+	}
+
+	return;
+}
+
+void UAsgardSphereSensorSubsystem::UnregisterSensor(UAsgardSphereSensor* Sensor)
+{
+	RegisteredSensors.RemoveSingleSwap(Sensor, false);
+}
+
+bool UAsgardSphereSensorSubsystem::IsBatchingEnabled()
+{
+	return SphereSensorBatching->GetInt() != 0;
+}
+
+uint32 UAsgardSphereSensorSubsystem::CalculateGroupKey(const UAsgardSphereSensor& Sensor)
+{
+	uint32 Key = GetTypeHash((uint8)Sensor.DetectionChannel);
+	Key = HashCombine(Key, GetTypeHash(Sensor.bAutoIgnoreOwner ? Sensor.GetOwner() : nullptr));
+
+	// Combine ignored actors in an order independent way so that equal sets produce equal keys
+	uint32 IgnoredActorsKey = 0;
+	for (const AActor* IgnoredActor : Sensor.IgnoredActors)
+	{
+		IgnoredActorsKey += GetTypeHash(IgnoredActor);
+	}
+
+	return HashCombine(Key, IgnoredActorsKey);
+}
+
+bool UAsgardSphereSensorSubsystem::HaveMatchingFilters(const UAsgardSphereSensor& A, const UAsgardSphereSensor& B)
+{
+	if (A.DetectionChannel != B.DetectionChannel
+		|| (A.bAutoIgnoreOwner ? A.GetOwner() : nullptr) != (B.bAutoIgnoreOwner ? B.GetOwner() : nullptr)
+		|| A.IgnoredActors.Num() != B.IgnoredActors.Num())
+	{
+		return false;
+	}
+
+	for (const AActor* IgnoredActor : A.IgnoredActors)
+	{
+		if (!B.IgnoredActors.Contains(IgnoredActor))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void UAsgardSphereSensorSubsystem::GatherSensorQueries()
+{
+	// Clear any sensors that have been garbage collected
+	RegisteredSensors.RemoveAllSwap([](const UAsgardSphereSensor* Sensor) { return Sensor == nullptr; }, false);
+
+	SensorQueries.Reset();
+	for (UAsgardSphereSensor* Sensor : RegisteredSensors)
+	{
+		if (Sensor->IsComponentTickEnabled() && Sensor->bOverlapTestPending)
+		{
+			FSensorQuery& Query = SensorQueries.AddDefaulted_GetRef();
+			Query.Sensor = Sensor;
+			Sensor->BeginOverlapTest(Query.Location, Query.Rotation, Query.Shape);
+			Query.BoundingRadius = Query.Shape.IsCapsule() ? Query.Shape.GetCapsuleHalfHeight() : Query.Shape.GetSphereRadius();
+			Query.GroupKey = CalculateGroupKey(*Sensor);
+		}
+	}
+
+	// Sort so that sensors that may share a query are adjacent
+	SensorQueries.Sort([](const FSensorQuery& A, const FSensorQuery& B) {
+		return A.GroupKey < B.GroupKey;
+		});
+
+	SET_DWORD_STAT(STAT_ASGARD_SphereSensorBatchBatchedSensors, SensorQueries.Num());
+
+	return;
+}
+
+void UAsgardSphereSensorSubsystem::BuildSensorClusters()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_SphereSensorBatchClustering);
+
+	SensorClusters.Reset();
+	const float MaxClusterExtent = SphereSensorBatchMaxClusterExtent->GetFloat();
+	int32 GroupFirstCluster = 0;
+
+	for (int32 QueryIdx = 0; QueryIdx < SensorQueries.Num(); QueryIdx++)
+	{
+		const FSensorQuery& Query = SensorQueries[QueryIdx];
+		const FBox QueryBounds = FBox::BuildAABB(Query.Location, FVector(Query.BoundingRadius));
+
+		// Clusters can only be shared within a group, so start searching from the first cluster of the current group
+		if (QueryIdx > 0 && Query.GroupKey != SensorQueries[QueryIdx - 1].GroupKey)
+		{
+			GroupFirstCluster = SensorClusters.Num();
+		}
+
+		// Join the first cluster that stays small enough and filters identically
+		bool bJoinedCluster = false;
+		for (int32 ClusterIdx = GroupFirstCluster; ClusterIdx < SensorClusters.Num(); ClusterIdx++)
+		{
+			FSensorCluster& Cluster = SensorClusters[ClusterIdx];
+			const FBox MergedBounds = Cluster.Bounds + QueryBounds;
+			if (MergedBounds.GetExtent().GetMax() <= MaxClusterExtent
+				&& HaveMatchingFilters(*SensorQueries[Cluster.QueryIndices[0]].Sensor, *Query.Sensor))
+			{
+				Cluster.Bounds = MergedBounds;
+				Cluster.QueryIndices.Add(QueryIdx);
+				bJoinedCluster = true;
+				break;
+			}
+		}
+
+		// Otherwise, start a new cluster
+		if (!bJoinedCluster)
+		{
+			FSensorCluster& NewCluster = SensorClusters.AddDefaulted_GetRef();
+			NewCluster.Bounds = QueryBounds;
+			NewCluster.QueryIndices.Add(QueryIdx);
+		}
+	}
+
+	return;
+}
+
+void UAsgardSphereSensorSubsystem::ProcessSensorCluster(UWorld& World, const FSensorCluster& Cluster)
+{
+	// Broad phase
+	// All sensors in the cluster filter identically, so the first one provides the query settings
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ASGARD_SphereSensorBatchBroadPhase);
+		INC_DWORD_STAT(STAT_ASGARD_SphereSensorBatchBatchedQueries);
+
+		const UAsgardSphereSensor& ClusterSensor = *SensorQueries[Cluster.QueryIndices[0]].Sensor;
+		FCollisionQueryParams Params;
+		Params.AddIgnoredActors(ClusterSensor.IgnoredActors);
+		if (ClusterSensor.bAutoIgnoreOwner && ClusterSensor.GetOwner())
+		{
+			Params.AddIgnoredActor(ClusterSensor.GetOwner());
+		}
+		Params.TraceTag = FName("AsgardSphereSensorBatchedOverlapTest");
+
+		CandidateOverlaps.Reset();
+		World.OverlapMultiByChannel(
+			CandidateOverlaps,
+			Cluster.Bounds.GetCenter(),
+			FQuat::Identity,
+			ClusterSensor.DetectionChannel,
+			FCollisionShape::MakeBox(Cluster.Bounds.GetExtent()),
+			Params,
+			FCollisionResponseParams::DefaultResponseParam);
+	}
+
+	// Narrow phase
+	// Test each candidate against each sensor shape, then pass the results to the sensor
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_SphereSensorBatchNarrowPhase);
+	for (int32 QueryIdx : Cluster.QueryIndices)
+	{
+		const FSensorQuery& Query = SensorQueries[QueryIdx];
+
+		// Sensors may be destroyed by delegates broadcast earlier in the pass
+		if (!IsValid(Query.Sensor))
+		{
+			continue;
+		}
+
+		bool bBlockingHits = false;
+		SensorOverlaps.Reset();
+		for (const FOverlapResult& CandidateOverlap : CandidateOverlaps)
+		{
+			UPrimitiveComponent* CandidateComponent = CandidateOverlap.Component.Get();
+			if (CandidateComponent)
+			{
+				// Reject by bounds before performing the more expensive shape test
+				const FBoxSphereBounds& CandidateBounds = CandidateComponent->Bounds;
+				if (FVector::DistSquared(CandidateBounds.Origin, Query.Location) <= FMath::Square(CandidateBounds.SphereRadius + Query.BoundingRadius)
+					&& CandidateComponent->OverlapComponent(Query.Location, Query.Rotation, Query.Shape))
+				{
+					SensorOverlaps.Add(CandidateOverlap);
+					bBlockingHits |= CandidateOverlap.bBlockingHit;
+				}
+			}
+		}
+
+		Query.Sensor->ProcessOverlaps(SensorOverlaps, bBlockingHits);
+	}
+
+	return;
+}
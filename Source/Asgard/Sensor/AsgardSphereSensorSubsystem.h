@@ -0,0 +1,102 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "WorldCollision.h"
+#include "AsgardSphereSensorSubsystem.generated.h"
+
+// Forward declarations
+class UAsgardSphereSensor;
+
+// Stats group
+DECLARE_STATS_GROUP(TEXT("AsgardSphereSensorBatch"), STATGROUP_ASGARD_SphereSensorBatch, STATCAT_Advanced);
+
+// Stats shared with sensors that still perform their own overlap tests, so both costs can be compared in one group
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AsgardSphereSensorBatch PerSensorOverlapTests"), STAT_ASGARD_SphereSensorBatchPerSensorOverlapTests, STATGROUP_ASGARD_SphereSensorBatch, ASGARD_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("AsgardSphereSensorBatch PerSensorQueries"), STAT_ASGARD_SphereSensorBatchPerSensorQueries, STATGROUP_ASGARD_SphereSensorBatch, ASGARD_API);
+
+/**
+ *	System for answering the overlap tests of every registered sphere sensor in a single batched pass.
+ *	Sensors sharing a detection channel and ignore set are clustered by proximity, each cluster is resolved with one broad-phase query,
+ *	and the candidates are then tested against each sensor sphere locally before being passed back to the sensors.
+ */
+UCLASS()
+class ASGARD_API UAsgardSphereSensorSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual bool IsTickableInEditor() const override { return false; }
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	// ~FTickableGameObject
+
+	/** Adds a sensor to the batched pass. */
+	void RegisterSensor(UAsgardSphereSensor* Sensor);
+
+	/** Removes a sensor from the batched pass. */
+	void UnregisterSensor(UAsgardSphereSensor* Sensor);
+
+	/**
+	* Returns whether batched overlap tests are enabled.
+	* If disabled, registered sensors fall back to performing their own overlap tests.
+	*/
+	static bool IsBatchingEnabled();
+
+private:
+	/** Overlap test requested by a single sensor for this frame. */
+	struct FSensorQuery
+	{
+		UAsgardSphereSensor* Sensor;
+		FVector Location;
+		FQuat Rotation;
+		FCollisionShape Shape;
+		float BoundingRadius;
+		uint32 GroupKey;
+	};
+
+	/** Group of nearby sensors that share a detection channel and ignore set, and therefore a broad-phase query. */
+	struct FSensorCluster
+	{
+		FBox Bounds;
+		TArray<int32, TInlineAllocator<8>> QueryIndices;
+	};
+
+	/** Sensors currently registered with the batched pass. */
+	UPROPERTY()
+	TArray<UAsgardSphereSensor*> RegisteredSensors;
+
+	/** Queries gathered from the registered sensors, sorted by group key. Persistent to avoid reallocating every frame. */
+	TArray<FSensorQuery> SensorQueries;
+
+	/** Clusters built from the sensor queries. Persistent to avoid reallocating every frame. */
+	TArray<FSensorCluster> SensorClusters;
+
+	/** Results of the current broad-phase query. */
+	TArray<FOverlapResult> CandidateOverlaps;
+
+	/** Results of the current sensor after narrow-phase filtering. */
+	TArray<FOverlapResult> SensorOverlaps;
+
+	/** Calculates a key shared by sensors that can use the same broad-phase query. */
+	static uint32 CalculateGroupKey(const UAsgardSphereSensor& Sensor);
+
+	/** Returns whether two sensors filter overlaps in exactly the same way. */
+	static bool HaveMatchingFilters(const UAsgardSphereSensor& A, const UAsgardSphereSensor& B);
+
+	/** Gathers the queries for all registered sensors that are due an overlap test this frame. */
+	void GatherSensorQueries();
+
+	/** Groups the gathered queries into clusters that can share a broad-phase query. */
+	void BuildSensorClusters();
+
+	/** Performs the broad-phase query for a cluster and passes the filtered results to each of its sensors. */
+	void ProcessSensorCluster(UWorld& World, const FSensorCluster& Cluster);
+};
@@ -0,0 +1,170 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "Asgard/Sensor/AsgardPeripheralSensor.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AsgardPeripheralSensorTest
+{
+	/**
+	* Original map based implementation of tracked point selection, used as the reference for the batched implementation.
+	*/
+	static void CalculateReferenceRollAngles(const UAsgardPeripheralSensor& Sensor, const FTransform& SelfTransform, const TArray<FVector>& ClosestPoints, const TArray<float>& Distances, TArray<float>& OutRollAngles)
+	{
+		OutRollAngles.Reset();
+
+		// Cache variables
+		TMap<FVector, float> DistancesByDirection;
+		FVector SelfLocation = SelfTransform.GetLocation();
+		FVector SelfForward = SelfTransform.GetUnitAxis(EAxis::X);
+		float MinForwardAngle = FMath::DegreesToRadians(Sensor.Min3DAngleFromSensor);
+
+		// For each closest point
+		for (int32 Idx = 0; Idx < ClosestPoints.Num(); Idx++)
+		{
+			// If the point is far enough away
+			float DistanceFromSelf = Distances[Idx];
+			if (DistanceFromSelf > Sensor.MinDistanceFromSensor)
+			{
+				// If the point is angled enough away from the center of the Sensor
+				FVector Direction = (ClosestPoints[Idx] - SelfLocation).GetSafeNormal();
+				float AngleFromForward = FMath::Acos(FMath::Abs(FVector::DotProduct(Direction, SelfForward)));
+				if (AngleFromForward > MinForwardAngle)
+				{
+					// Add to potential points and distances
+					auto ExistingEntry = DistancesByDirection.Find(Direction);
+					if (ExistingEntry != nullptr)
+					{
+						if (*ExistingEntry < DistanceFromSelf)
+						{
+							*ExistingEntry = DistanceFromSelf;
+						}
+					}
+					else
+					{
+						DistancesByDirection.Add(Direction, DistanceFromSelf);
+					}
+				}
+			}
+		}
+
+		// If there is at least one potential point
+		if (DistancesByDirection.Num() > 0)
+		{
+			// Sort the points by distance
+			DistancesByDirection.ValueSort([](const float A, const float B) {
+				return A < B;
+				});
+
+			// Cache variables
+			TArray<FVector> TrackedPoints;
+			float MinAngleFromPoint = FMath::DegreesToRadians(Sensor.Min2DAngleBetweenTrackedPoints);
+
+			// For each potential point
+			for (auto& DistanceByPoint : DistancesByDirection)
+			{
+				// Project and normalize the point
+				FVector ProjectedPointNormalized = SelfTransform.InverseTransformVectorNoScale(DistanceByPoint.Key);
+				ProjectedPointNormalized.X = 0.0f;
+				ProjectedPointNormalized = ProjectedPointNormalized.GetSafeNormal();
+
+				// If the angle is too close to a currently tracked point, skip the point
+				bool bTooCloseToTrackedPoint = false;
+				for (FVector& CurrPoint : TrackedPoints)
+				{
+					if (FMath::Acos(FVector::DotProduct(CurrPoint, ProjectedPointNormalized)) < MinAngleFromPoint)
+					{
+						bTooCloseToTrackedPoint = true;
+						break;
+					}
+				}
+
+				if (!bTooCloseToTrackedPoint)
+				{
+					TrackedPoints.Emplace(ProjectedPointNormalized);
+
+					// If we have reached the limit of tracked points, break the loop
+					if (Sensor.MaxTrackedPoints > 0 && TrackedPoints.Num() >= Sensor.MaxTrackedPoints)
+					{
+						break;
+					}
+				}
+			}
+
+			// Calculate the roll angle to each tracked point
+			for (FVector& TrackedPoint : TrackedPoints)
+			{
+				OutRollAngles.Add(FMath::RadiansToDegrees(FMath::Atan2(TrackedPoint.Y, TrackedPoint.Z)));
+			}
+			OutRollAngles.Sort([](const float A, const float B) {
+				return A < B;
+				});
+		}
+
+		return;
+	}
+}
+
+/**
+* Checks the batched tracked point selection against the reference implementation on random points, including duplicate directions.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardPeripheralSensorSelectionTest, "Asgard.Sensor.PeripheralSensorSelection", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAsgardPeripheralSensorSelectionTest::RunTest(const FString& Parameters)
+{
+	UAsgardPeripheralSensor* Sensor = NewObject<UAsgardPeripheralSensor>(GetTransientPackage());
+	FRandomStream RandomStream(0x5E4503);
+	TArray<float> ReferenceRollAngles;
+
+	const int32 NumIterations = 200;
+	for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+	{
+		Sensor->MaxTrackedPoints = RandomStream.RandRange(0, 6);
+		Sensor->Min3DAngleFromSensor = RandomStream.FRandRange(10.0f, 60.0f);
+		Sensor->Min2DAngleBetweenTrackedPoints = RandomStream.FRandRange(10.0f, 90.0f);
+		Sensor->MinDistanceFromSensor = RandomStream.FRandRange(0.0f, 10.0f);
+
+		const FTransform SelfTransform(FRotator(RandomStream.FRandRange(-90.0f, 90.0f), RandomStream.FRandRange(-180.0f, 180.0f), RandomStream.FRandRange(-180.0f, 180.0f)),
+			RandomStream.VRand() * RandomStream.FRandRange(0.0f, 1000.0f));
+
+		// Random points around the Sensor, with some repeated in the same direction at another distance
+		TArray<FVector> ClosestPoints;
+		TArray<float> Distances;
+		const int32 NumPoints = RandomStream.RandRange(0, 24);
+		for (int32 Idx = 0; Idx < NumPoints; Idx++)
+		{
+			const float Distance = RandomStream.FRandRange(0.0f, 100.0f);
+			ClosestPoints.Add(SelfTransform.GetLocation() + (RandomStream.VRand() * Distance));
+			Distances.Add(Distance);
+
+			if (RandomStream.FRand() < 0.25f)
+			{
+				ClosestPoints.Add(ClosestPoints.Last());
+				Distances.Add(RandomStream.FRandRange(0.0f, 100.0f));
+			}
+		}
+
+		AsgardPeripheralSensorTest::CalculateReferenceRollAngles(*Sensor, SelfTransform, ClosestPoints, Distances, ReferenceRollAngles);
+
+		Sensor->CandidatePoints = ClosestPoints;
+		Sensor->CandidateDistances = Distances;
+		Sensor->RollAnglesToNearestTrackedPoints.Reset();
+		Sensor->FilterCandidatePoints(SelfTransform);
+		Sensor->SelectTrackedPoints();
+
+		const TArray<float>& RollAngles = Sensor->RollAnglesToNearestTrackedPoints;
+		if (!TestEqual(FString::Printf(TEXT("Iteration %d tracked point count"), Iteration), RollAngles.Num(), ReferenceRollAngles.Num()))
+		{
+			continue;
+		}
+		for (int32 Idx = 0; Idx < RollAngles.Num(); Idx++)
+		{
+			TestEqual(FString::Printf(TEXT("Iteration %d roll angle %d"), Iteration, Idx), RollAngles[Idx], ReferenceRollAngles[Idx], 0.01f);
+		}
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,171 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "Asgard/Sensor/AsgardSphereSensor.h"
+#include "Components/SphereComponent.h"
+#include "GameFramework/Actor.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AsgardSphereSensorTest
+{
+	/**
+	* Original implementation of overlap processing, which copies the detected sets into lost sets on every update.
+	* Events are not bound during the test, so they are left out.
+	*/
+	static void ProcessReferenceOverlaps(const TArray<FOverlapResult>& Overlaps, bool bBlockingHits, bool bDetectBlockingHitsOnly, TSet<AActor*>& DetectedActors, TSet<UPrimitiveComponent*>& DetectedComponents)
+	{
+		// If we detect nothing, clear the list of detected components
+		if (DetectedComponents.Num() && (Overlaps.Num() <= 0 || (!bBlockingHits && bDetectBlockingHitsOnly)))
+		{
+			DetectedComponents.Reset();
+			DetectedActors.Reset();
+		}
+		// Otherwise, process the results normally
+		else
+		{
+			TSet<AActor*> LostActors = DetectedActors;
+			TSet<UPrimitiveComponent*> LostComponents = DetectedComponents;
+
+			for (const FOverlapResult& Overlap : Overlaps)
+			{
+				UPrimitiveComponent* DetectedComponent = Overlap.Component.Get();
+				if (DetectedComponent && (!bDetectBlockingHitsOnly || Overlap.bBlockingHit))
+				{
+					// If the component is valid, the actor should be valid
+					AActor* DetectedActor = Overlap.Actor.Get();
+
+					// Add the actor to the detected list
+					bool bAlreadyDetected = false;
+					DetectedActors.Add(DetectedActor, &bAlreadyDetected);
+					if (!bAlreadyDetected)
+					{
+						DetectedComponents.Add(DetectedComponent);
+					}
+
+					// If the actor is already detected, check if the component is as well
+					else
+					{
+						LostActors.Remove(DetectedActor);
+						DetectedComponents.Add(DetectedComponent, &bAlreadyDetected);
+						if (bAlreadyDetected)
+						{
+							LostComponents.Remove(DetectedComponent);
+						}
+					}
+				}
+			}
+
+			// Clear components and actors that are no longer detected
+			for (UPrimitiveComponent* LostComponent : LostComponents)
+			{
+				DetectedComponents.Remove(LostComponent);
+			}
+			for (AActor* LostActor : LostActors)
+			{
+				DetectedActors.Remove(LostActor);
+			}
+		}
+
+		return;
+	}
+
+	/**
+	* Fills overlaps with a random subset of components, as an overlap test around a moving sensor would.
+	*/
+	static void MakeRandomOverlaps(FRandomStream& RandomStream, const TArray<UPrimitiveComponent*>& Components, float KeepChance, TArray<FOverlapResult>& OutOverlaps)
+	{
+		OutOverlaps.Reset();
+		for (UPrimitiveComponent* Component : Components)
+		{
+			if (RandomStream.FRand() < KeepChance)
+			{
+				FOverlapResult& Overlap = OutOverlaps.AddDefaulted_GetRef();
+				Overlap.Actor = Component->GetOwner();
+				Overlap.Component = Component;
+				Overlap.bBlockingHit = RandomStream.FRand() < 0.75f;
+			}
+		}
+	}
+}
+
+/**
+* Checks generation stamped overlap processing against the reference implementation on random overlaps, and times both.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardSphereSensorProcessOverlapsTest, "Asgard.Sensor.SphereSensorProcessOverlaps", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAsgardSphereSensorProcessOverlapsTest::RunTest(const FString& Parameters)
+{
+	// Actors with a few components each, as the sensor would find around a hand
+	const int32 NumActors = 16;
+	const int32 NumComponentsPerActor = 4;
+	TArray<UPrimitiveComponent*> Components;
+	for (int32 ActorIdx = 0; ActorIdx < NumActors; ActorIdx++)
+	{
+		AActor* Actor = NewObject<AActor>(GetTransientPackage());
+		for (int32 ComponentIdx = 0; ComponentIdx < NumComponentsPerActor; ComponentIdx++)
+		{
+			Components.Add(NewObject<USphereComponent>(Actor));
+		}
+	}
+
+	UAsgardSphereSensor* Sensor = NewObject<UAsgardSphereSensor>(GetTransientPackage());
+	FRandomStream RandomStream(0x5E4502);
+	TArray<FOverlapResult> Overlaps;
+
+	// Check that both implementations detect the same actors and components on every update
+	const int32 NumIterations = 500;
+	for (int32 PassIdx = 0; PassIdx < 2; PassIdx++)
+	{
+		Sensor->bDetectBlockingHitsOnly = PassIdx > 0;
+		TSet<AActor*> ReferenceActors = Sensor->DetectedActors;
+		TSet<UPrimitiveComponent*> ReferenceComponents = Sensor->DetectedComponents;
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			AsgardSphereSensorTest::MakeRandomOverlaps(RandomStream, Components, RandomStream.FRand(), Overlaps);
+			const bool bBlockingHits = RandomStream.FRand() < 0.9f;
+
+			AsgardSphereSensorTest::ProcessReferenceOverlaps(Overlaps, bBlockingHits, Sensor->bDetectBlockingHitsOnly, ReferenceActors, ReferenceComponents);
+			Sensor->ProcessOverlaps(Overlaps, bBlockingHits);
+
+			const FString Context = FString::Printf(TEXT("Pass %d iteration %d"), PassIdx, Iteration);
+			TestEqual(Context + TEXT(" detected actor count"), Sensor->DetectedActors.Num(), ReferenceActors.Num());
+			TestEqual(Context + TEXT(" detected component count"), Sensor->DetectedComponents.Num(), ReferenceComponents.Num());
+			TestTrue(Context + TEXT(" detected actors match"), Sensor->DetectedActors.Difference(ReferenceActors).Num() == 0);
+			TestTrue(Context + TEXT(" detected components match"), Sensor->DetectedComponents.Difference(ReferenceComponents).Num() == 0);
+		}
+	}
+
+	// Time both implementations on the same steady stream of overlaps, with a little churn between updates
+	const int32 NumTimedUpdates = 20000;
+	TArray<TArray<FOverlapResult>> TimedOverlaps;
+	TimedOverlaps.SetNum(8);
+	for (TArray<FOverlapResult>& UpdateOverlaps : TimedOverlaps)
+	{
+		AsgardSphereSensorTest::MakeRandomOverlaps(RandomStream, Components, 0.9f, UpdateOverlaps);
+	}
+	Sensor->bDetectBlockingHitsOnly = false;
+
+	TSet<AActor*> ReferenceActors;
+	TSet<UPrimitiveComponent*> ReferenceComponents;
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 UpdateIdx = 0; UpdateIdx < NumTimedUpdates; UpdateIdx++)
+	{
+		AsgardSphereSensorTest::ProcessReferenceOverlaps(TimedOverlaps[UpdateIdx % TimedOverlaps.Num()], true, false, ReferenceActors, ReferenceComponents);
+	}
+	const double ReferenceTime = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 UpdateIdx = 0; UpdateIdx < NumTimedUpdates; UpdateIdx++)
+	{
+		Sensor->ProcessOverlaps(TimedOverlaps[UpdateIdx % TimedOverlaps.Num()], true);
+	}
+	const double StampedTime = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("%d updates of %d components: reference %.3f ms, generation stamped %.3f ms"),
+		NumTimedUpdates, Components.Num(), ReferenceTime * 1000.0, StampedTime * 1000.0));
+
+	return true;
+}
+
+#endif
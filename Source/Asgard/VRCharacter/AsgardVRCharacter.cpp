@@ -6,6 +6,7 @@
 #include "Asgard/Core/AsgardInputBindings.h"
 #include "Asgard/Core/AsgardCollisionProfiles.h"
 #include "Asgard/Core/AsgardTraceChannels.h"
+#include "Asgard/Abilities/AsgardLashRenderComponent.h"
 #include "NavigationSystem/Public/NavigationSystem.h"
 #include "Runtime/Engine/Public/EngineUtils.h"
 #include "Runtime/Engine/Public/TimerManager.h"
@@ -19,6 +20,16 @@ DEFINE_LOG_CATEGORY_STATIC(LogAsgardVRCharacter, Log, All);
 DECLARE_CYCLE_STAT(TEXT("AsgardVRCharacter PrecisionTeleportLocation"), STAT_ASGARD_VRCharacterPrecisionTeleportLocation, STATGROUP_ASGARD_VRCharacter);
 DECLARE_CYCLE_STAT(TEXT("AsgardVRCharacter SmoothTeleportToLocation"), STAT_ASGARD_VRCharacterSmoothTeleportToLocation, STATGROUP_ASGARD_VRCharacter);
 DECLARE_CYCLE_STAT(TEXT("AsgardVRCharacter SmoothTeleportToRotation"), STAT_ASGARD_VRCharacterSmoothTeleportToRotation, STATGROUP_ASGARD_VRCharacter);
+DECLARE_CYCLE_STAT(TEXT("AsgardVRCharacter TeleportInDirection"), STAT_ASGARD_VRCharacterTeleportInDirection, STATGROUP_ASGARD_VRCharacter);
+DECLARE_CYCLE_STAT(TEXT("AsgardVRCharacter FallbackTeleportLocation"), STAT_ASGARD_VRCharacterFallbackTeleportLocation, STATGROUP_ASGARD_VRCharacter);
+
+// Stat counters
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AsgardVRCharacter TeleportQueryMicroseconds"), STAT_ASGARD_VRCharacterTeleportQueryMicroseconds, STATGROUP_ASGARD_VRCharacter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AsgardVRCharacter TeleportQueriesOverBudget"), STAT_ASGARD_VRCharacterTeleportQueriesOverBudget, STATGROUP_ASGARD_VRCharacter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AsgardVRCharacter TeleportFallbackCandidates"), STAT_ASGARD_VRCharacterTeleportFallbackCandidates, STATGROUP_ASGARD_VRCharacter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AsgardVRCharacter TeleportCacheHits"), STAT_ASGARD_VRCharacterTeleportCacheHits, STATGROUP_ASGARD_VRCharacter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AsgardVRCharacter TeleportCacheMisses"), STAT_ASGARD_VRCharacterTeleportCacheMisses, STATGROUP_ASGARD_VRCharacter);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AsgardVRCharacter TeleportCacheHitRate"), STAT_ASGARD_VRCharacterTeleportCacheHitRate, STATGROUP_ASGARD_VRCharacter);
 
 // Console variable setup so we can enable and disable debugging from the console
 // Draw teleport debug
@@ -38,6 +49,34 @@ static TAutoConsoleVariable<float> CVarAsgardTeleportDebugLifetime(
 	ECVF_Scalability | ECVF_RenderThreadSafe);
 static const auto TeleportDebugLifetime = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.TeleportDebugLifetime"));
 
+// Async precision teleport preview
+static TAutoConsoleVariable<int32> CVarAsgardPrecisionTeleportAsyncPreview(
+	TEXT("Asgard.PrecisionTeleportAsyncPreview"),
+	1,
+	TEXT("Whether characters with bUseAsyncPrecisionTeleportPreview update their Precision Teleport preview asynchronously.\n")
+	TEXT("0: Disabled, 1: Enabled"),
+	ECVF_Scalability);
+static const auto PrecisionTeleportAsyncPreview = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.PrecisionTeleportAsyncPreview"));
+
+// Teleport query budget
+static TAutoConsoleVariable<float> CVarAsgardTeleportQueryBudget(
+	TEXT("Asgard.TeleportQueryBudget"),
+	1000.0f,
+	TEXT("Time budget of a teleport in direction query, in microseconds.\n")
+	TEXT("Once exceeded, the remaining fallback candidates are not traced.\n")
+	TEXT("<= 0: Unlimited"),
+	ECVF_Scalability);
+static const auto TeleportQueryBudget = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.TeleportQueryBudget"));
+
+// Coarse fallback trace frequency
+static TAutoConsoleVariable<float> CVarAsgardTeleportFallbackCoarseSimFrequency(
+	TEXT("Asgard.TeleportFallbackCoarseSimFrequency"),
+	5.0f,
+	TEXT("Simulation frequency of the coarse trace used to skip fallback teleport arcs that cannot hit anything.\n")
+	TEXT("<= 0: Disabled, every fallback arc is traced in full"),
+	ECVF_Scalability);
+static const auto TeleportFallbackCoarseSimFrequency = IConsoleManager::Get().FindConsoleVariable(TEXT("Asgard.TeleportFallbackCoarseSimFrequency"));
+
 // Macros for debug builds
 #if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
 #include "DrawDebugHelpers.h"
@@ -45,15 +84,22 @@ static const auto TeleportDebugLifetime = IConsoleManager::Get().FindConsoleVari
 #define TELEPORT_LINE(_Loc, _Dest, _Color)				if (TeleportDrawDebug->GetInt()) { DrawDebugLine(GetWorld(), _Loc, _Dest, _Color, false,  -1.0f, 0, 3.0f); }
 #define TELEPORT_LOC_DURATION(_Loc, _Radius, _Color)	if (TeleportDrawDebug->GetInt()) { DrawDebugSphere(GetWorld(), _Loc, _Radius, 16, _Color, false, TeleportDebugLifetime->GetFloat(), 0, 3.0f); }
 #define TELEPORT_LINE_DURATION(_Loc, _Dest, _Color)		if (TeleportDrawDebug->GetInt()) { DrawDebugLine(GetWorld(), _Loc, _Dest, _Color, false, TeleportDebugLifetime->GetFloat(), 0, 3.0f); }
-#define TELEPORT_TRACE_DEBUG_TYPE(_Params)				if (TeleportDrawDebug->GetInt()) { _Params.DrawDebugType = EDrawDebugTrace::ForOneFrame; }
 #else
 #define TELEPORT_LOC(_Loc, _Radius, _Color)				/* nothing */
 #define TELEPORT_LINE(_Loc, _Dest, _Color)				/* nothing */
 #define TELEPORT_LOC_DURATION(_Loc, _Radius, _Color)	/* nothing */
 #define TELEPORT_LINE_DURATION(_Loc, _Dest, _Color)		/* nothing */
-#define TELEPORT_TRACE_DEBUG_TYPE()						/* nothing */
 #endif
 
+namespace AsgardVRCharacter
+{
+	// Simulation frequency of teleport arcs, matching the default of PredictProjectilePath
+	static const float TeleportTraceSimFrequency = 15.0f;
+
+	// Number of steps past the previous hit that the async Precision Teleport preview sweeps
+	static const int32 PrecisionTeleportSweepStepMargin = 3;
+}
+
 AAsgardVRCharacter::AAsgardVRCharacter(const FObjectInitializer& ObjectInitializer)
 :Super(ObjectInitializer.SetDefaultSubobjectClass<UAsgardVRMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
@@ -61,6 +107,14 @@ AAsgardVRCharacter::AAsgardVRCharacter(const FObjectInitializer& ObjectInitializ
 
 	// Navigation settings
 	NavQueryExtent = FVector(150.f, 150.f, 150.f);
+	bUseTeleportDestinationCache = true;
+	TeleportDestinationCacheMaxEntries = 256;
+	TeleportDestinationCacheOriginTolerance = 10.0f;
+	TeleportCacheOriginNodeRef = INVALID_NAVNODEREF;
+	TeleportCacheLookups = 0;
+	TeleportCacheHits = 0;
+	PrecisionTeleportPathTestGoalNodeRef = INVALID_NAVNODEREF;
+	QueuedPrecisionTeleportPathTestGoalNodeRef = INVALID_NAVNODEREF;
 	PathfindingNavAgentProperties = GetCharacterMovement()->NavAgentProps;
 
 	// Teleport settings
@@ -68,6 +122,12 @@ AAsgardVRCharacter::AAsgardVRCharacter(const FObjectInitializer& ObjectInitializ
 	TeleportTraceRadius = 4.0f;
 	TeleportTraceMaxSimTime = 3.0f;
 	PrecisionTeleportTraceMagnitude = 1000.0f;
+	PrecisionTeleportPathQueryId = INVALID_NAVQUERYID;
+	PrecisionTeleportPreviewGeneration = 0;
+	PrecisionTeleportResultGeneration = 0;
+	PrecisionTeleportPathTestGeneration = 0;
+	QueuedPrecisionTeleportPathTestGeneration = 0;
+	PrecisionTeleportLastHitStep = INDEX_NONE;
 	PrecisionTeleportDedicatedOrientationMode = EAsgardBinaryHand::RightHand;
 	PrecisionTeleportInferred1OrientationMode = EAsgardBinaryHand::RightHand;
 	PrecisionTeleportInferred2OrientationMode = EAsgardBinaryHand::LeftHand;
@@ -134,9 +194,30 @@ void AAsgardVRCharacter::BeginPlay()
 	// Cache the navdata
 	CacheNavData();
 
+	// Clear the teleport destination cache whenever the navmesh is rebuilt
+	UNavigationSystemV1* const NavSys = UNavigationSystemV1::GetCurrent(GetWorld());
+	if (NavSys)
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.AddUniqueDynamic(this, &AAsgardVRCharacter::OnNavigationGenerationFinished);
+	}
+
 	Super::BeginPlay();
 }
 
+void AAsgardVRCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Drop any async work still in flight, so its results are never applied
+	CancelAsyncPrecisionTeleportPreview();
+
+	UNavigationSystemV1* const NavSys = UNavigationSystemV1::GetCurrent(GetWorld());
+	if (NavSys)
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.RemoveDynamic(this, &AAsgardVRCharacter::OnNavigationGenerationFinished);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void AAsgardVRCharacter::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
@@ -805,44 +886,24 @@ bool AAsgardVRCharacter::TraceForTeleportLocation(
 	// Profile this function since it is a potentially expensive operation
 	SCOPE_CYCLE_COUNTER(STAT_ASGARD_VRCharacterPrecisionTeleportLocation);
 
-	// Initialize trace parameters
-	FPredictProjectilePathParams TeleportTraceParams = FPredictProjectilePathParams(
-		TeleportTraceRadius, 
-		TraceOrigin, 
-		TraceVelocity, 
-		TeleportTraceMaxSimTime, 
-		TraceChannel,
-		this);
-	TELEPORT_TRACE_DEBUG_TYPE(TeleportTraceParams);
-
 	// Perform the trace
-	FPredictProjectilePathResult TraceResult;
-	bool bTraceHit = UGameplayStatics::PredictProjectilePath(this, TeleportTraceParams, TraceResult);
-	
-	// Update path points
-	if (OptionalOutTracePathPoints != nullptr)
-	{
-		OptionalOutTracePathPoints->Empty();
-		for (const FPredictProjectilePathPointData& PathPoint : TraceResult.PathData)
-		{
-			OptionalOutTracePathPoints->Add(PathPoint.Location);
-		}
-	}
-
+	// The path points are written straight into the out array, so a persistent buffer is refilled without reallocating
+	FHitResult TraceHit;
+	const bool bTraceHit = TraceTeleportArc(TraceOrigin, TraceVelocity, TraceChannel, AsgardVRCharacter::TeleportTraceSimFrequency, TraceHit, OptionalOutTracePathPoints);
 
 	// Return result
 	if (bTraceHit)
 	{
 		if (OptionalOutImpactPoint != nullptr)
 		{
-			*OptionalOutImpactPoint = TraceResult.HitResult.ImpactPoint;
+			*OptionalOutImpactPoint = TraceHit.ImpactPoint;
 		}
 
-		TELEPORT_LOC(TraceResult.HitResult.ImpactPoint, 20.0f, FColor::Yellow);
+		TELEPORT_LOC(TraceHit.ImpactPoint, 20.0f, FColor::Yellow);
 
-		if (ProjectPointToVRNavigation(TraceResult.HitResult.ImpactPoint, OutTeleportLocation, true))
+		if (ProjectPointToVRNavigation(TraceHit.ImpactPoint, OutTeleportLocation, true))
 		{
-			if (!bRequiresNavmeshPath || DoesPathToPointExistVR(OutTeleportLocation))
+			if (!bRequiresNavmeshPath || DoesCachedPathToPointExistVR(OutTeleportLocation))
 			{
 				TELEPORT_LOC(OutTeleportLocation, 25.0f, FColor::Cyan);
 				TELEPORT_LINE(TraceOrigin, OutTeleportLocation, FColor::Green);
@@ -851,7 +912,7 @@ bool AAsgardVRCharacter::TraceForTeleportLocation(
 			else
 			{
 				TELEPORT_LOC(OutTeleportLocation, 25.0f, FColor::Magenta);
-				TELEPORT_LINE(TraceOrigin, TraceResult.HitResult.ImpactPoint, FColor::Red);
+				TELEPORT_LINE(TraceOrigin, TraceHit.ImpactPoint, FColor::Red);
 			}
 		}
 	}
@@ -859,6 +920,127 @@ bool AAsgardVRCharacter::TraceForTeleportLocation(
 	return false;
 }
 
+bool AAsgardVRCharacter::TraceTeleportArc(
+	const FVector& TraceOrigin,
+	const FVector& TraceVelocity,
+	TEnumAsByte<ECollisionChannel> TraceChannel,
+	float SimFrequency,
+	FHitResult& OutHit,
+	TArray<FVector>* OptionalOutTracePathPoints,
+	float ExtraRadius) const
+{
+	if (OptionalOutTracePathPoints != nullptr)
+	{
+		OptionalOutTracePathPoints->Reset();
+	}
+
+	UWorld* World = GetWorld();
+	if (!World || SimFrequency <= 0.0f)
+	{
+		return false;
+	}
+
+	// Cache variables
+	const float GravityZ = World->GetGravityZ();
+	const float StepTime = 1.0f / SimFrequency;
+	const int32 NumSteps = FMath::CeilToInt(TeleportTraceMaxSimTime * SimFrequency);
+	const FCollisionShape TraceShape = FCollisionShape::MakeSphere(TeleportTraceRadius + ExtraRadius);
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(AsgardTeleportArcTrace), false, this);
+	FVector Location = TraceOrigin;
+	FVector Velocity = TraceVelocity;
+
+	if (OptionalOutTracePathPoints != nullptr)
+	{
+		OptionalOutTracePathPoints->Add(Location);
+	}
+
+	// Sweep each step of the arc, integrating the same way as PredictProjectilePath
+	for (int32 StepIdx = 0; StepIdx < NumSteps; StepIdx++)
+	{
+		const float SubstepTime = FMath::Min(StepTime, TeleportTraceMaxSimTime - (StepIdx * StepTime));
+		const FVector OldVelocity = Velocity;
+		Velocity.Z += GravityZ * SubstepTime;
+		const FVector NextLocation = Location + ((OldVelocity + Velocity) * (0.5f * SubstepTime));
+		const bool bStepHit = World->SweepSingleByChannel(OutHit, Location, NextLocation, FQuat::Identity, TraceChannel, TraceShape, TraceParams);
+		if (OptionalOutTracePathPoints != nullptr)
+		{
+			OptionalOutTracePathPoints->Add(bStepHit ? OutHit.Location : NextLocation);
+		}
+		if (bStepHit)
+		{
+			TELEPORT_LINE(Location, OutHit.Location, FColor::Orange);
+			return true;
+		}
+		TELEPORT_LINE(Location, NextLocation, FColor::Silver);
+		Location = NextLocation;
+	}
+
+	return false;
+}
+
+int32 AAsgardVRCharacter::GetMaxTeleportArcPoints() const
+{
+	// The start of the arc, plus the end of every step
+	return FMath::CeilToInt(TeleportTraceMaxSimTime * AsgardVRCharacter::TeleportTraceSimFrequency) + 1;
+}
+
+bool AAsgardVRCharacter::TraceForFallbackTeleportLocation(
+	const FVector& TraceOrigin,
+	const FVector& Direction,
+	float FirstMagnitude,
+	float MagnitudeInterval,
+	int32 NumCandidates,
+	bool bRequiresNavmeshPath,
+	TEnumAsByte<ECollisionChannel> TraceChannel,
+	double QueryStartTime,
+	FVector& OutTeleportLocation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_VRCharacterFallbackTeleportLocation);
+
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return false;
+	}
+
+	// Cache variables
+	// The arc steps are chords of the same parabola, and a chord strays at most |g| * StepTime^2 / 8 from it.
+	// Padding the coarse sweeps by the stray of both step sizes makes them cover every full sweep, so a coarse miss means a full miss
+	const float QueryBudgetSeconds = TeleportQueryBudget->GetFloat() / 1000000.0f;
+	const float CoarseSimFrequency = TeleportFallbackCoarseSimFrequency->GetFloat();
+	const bool bUseCoarsePass = CoarseSimFrequency > 0.0f && CoarseSimFrequency < AsgardVRCharacter::TeleportTraceSimFrequency;
+	const float CoarseStepTime = bUseCoarsePass ? 1.0f / CoarseSimFrequency : 0.0f;
+	const float FineStepTime = 1.0f / AsgardVRCharacter::TeleportTraceSimFrequency;
+	const float CoarseExtraRadius = (FMath::Abs(World->GetGravityZ()) * ((CoarseStepTime * CoarseStepTime) + (FineStepTime * FineStepTime)) / 8.0f) + KINDA_SMALL_NUMBER;
+
+	for (int32 CandidateIdx = 0; CandidateIdx < NumCandidates; CandidateIdx++)
+	{
+		// Stop once the budget is used up
+		if (QueryBudgetSeconds > 0.0f && FPlatformTime::Seconds() - QueryStartTime > QueryBudgetSeconds)
+		{
+			return false;
+		}
+
+		const FVector CandidateVelocity = Direction * (FirstMagnitude - (CandidateIdx * MagnitudeInterval));
+
+		// The first fallback usually succeeds, so trace it in full straight away.
+		// Skip later fallbacks whose coarse arc hits nothing, since their full arc cannot hit anything either
+		FHitResult CoarseHit;
+		if (bUseCoarsePass && CandidateIdx > 0 && !TraceTeleportArc(TraceOrigin, CandidateVelocity, TraceChannel, CoarseSimFrequency, CoarseHit, nullptr, CoarseExtraRadius))
+		{
+			continue;
+		}
+
+		INC_DWORD_STAT(STAT_ASGARD_VRCharacterTeleportFallbackCandidates);
+		if (TraceForTeleportLocation(TraceOrigin, CandidateVelocity, bRequiresNavmeshPath, TraceChannel, OutTeleportLocation))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void AAsgardVRCharacter::TeleportTurn()
 {
 	// If can teleport turn
@@ -1008,15 +1190,38 @@ bool AAsgardVRCharacter::TeleportInDirection(
 	int32 MaxRetries, 
 	float FallbackMagnitudeInterval)
 {
-	// Trace in the indicated direction, retrying if appropriate
-	bool bTraceSuccessful;
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_VRCharacterTeleportInDirection);
+	const double QueryStartTime = FPlatformTime::Seconds();
+
+	// Trace the initial magnitude in full first, since it usually succeeds
+	const FVector TraceOrigin = GetVRLocation();
 	FVector TeleportGoal;
-	do
+	bool bTraceSuccessful = TraceForTeleportLocation(TraceOrigin, Direction * InitialMagnitude, bRequiresNavMeshPath, TraceChannel, TeleportGoal);
+
+	// Otherwise, evaluate the fallbacks
+	if (!bTraceSuccessful && MaxRetries > 0)
 	{
-		bTraceSuccessful = TraceForTeleportLocation(GetVRLocation(), Direction * InitialMagnitude, bRequiresNavMeshPath, TraceChannel, TeleportGoal);
-		MaxRetries -= 1;
-		InitialMagnitude -= FallbackMagnitudeInterval;
-	} while (!bTraceSuccessful && MaxRetries > -1);
+		bTraceSuccessful = TraceForFallbackTeleportLocation(
+			TraceOrigin,
+			Direction,
+			InitialMagnitude - FallbackMagnitudeInterval,
+			FallbackMagnitudeInterval,
+			MaxRetries,
+			bRequiresNavMeshPath,
+			TraceChannel,
+			QueryStartTime,
+			TeleportGoal);
+	}
+
+	// Record the query time against the budget
+	const float QueryMicroseconds = (float)((FPlatformTime::Seconds() - QueryStartTime) * 1000000.0);
+	SET_FLOAT_STAT(STAT_ASGARD_VRCharacterTeleportQueryMicroseconds, QueryMicroseconds);
+	const float QueryBudget = TeleportQueryBudget->GetFloat();
+	if (QueryBudget > 0.0f && QueryMicroseconds > QueryBudget)
+	{
+		INC_DWORD_STAT(STAT_ASGARD_VRCharacterTeleportQueriesOverBudget);
+		UE_LOG(LogAsgardVRCharacter, Verbose, TEXT("TeleportInDirection took %.1f us, over its budget of %.1f us."), QueryMicroseconds, QueryBudget);
+	}
 
 	// If trace was successful
 	if (bTraceSuccessful)
@@ -1157,6 +1362,127 @@ bool AAsgardVRCharacter::DoesPathToPointExistVR(const FVector& GoalLocation)
 	return false;
 }
 
+bool AAsgardVRCharacter::DoesCachedPathToPointExistVR(const FVector& GoalLocation)
+{
+	const NavNodeRef GoalNodeRef = bUseTeleportDestinationCache ? FindPathfindingNodeRef(GoalLocation) : INVALID_NAVNODEREF;
+	if (IsTeleportDestinationKnownReachable(GoalNodeRef))
+	{
+		return true;
+	}
+
+	if (DoesPathToPointExistVR(GoalLocation))
+	{
+		AddReachableTeleportDestination(GoalNodeRef);
+		return true;
+	}
+
+	return false;
+}
+
+NavNodeRef AAsgardVRCharacter::FindPathfindingNodeRef(const FVector& Location) const
+{
+	UNavigationSystemV1* const NavSys = UNavigationSystemV1::GetCurrent(GetWorld());
+	if (NavSys && PathfindingNavData)
+	{
+		FNavLocation PathfindingNavLoc;
+		if (NavSys->ProjectPointToNavigation(Location, PathfindingNavLoc, (NavQueryExtent.IsNearlyZero() ? INVALID_NAVEXTENT : NavQueryExtent), PathfindingNavData, UNavigationQueryFilter::GetQueryFilter(*PathfindingNavData, this, NavQueryFilter)))
+		{
+			return PathfindingNavLoc.NodeRef;
+		}
+	}
+
+	return INVALID_NAVNODEREF;
+}
+
+bool AAsgardVRCharacter::IsTeleportDestinationKnownReachable(NavNodeRef GoalNodeRef)
+{
+	if (!bUseTeleportDestinationCache || GoalNodeRef == INVALID_NAVNODEREF)
+	{
+		return false;
+	}
+
+	UpdateTeleportDestinationCacheOrigin();
+	const bool bKnownReachable = TeleportCacheOriginNodeRef != INVALID_NAVNODEREF
+		&& TeleportReachableNodeRefs.Contains(TeleportCacheOriginNodeRef)
+		&& TeleportReachableNodeRefs.Contains(GoalNodeRef);
+	RecordTeleportDestinationCacheLookup(bKnownReachable);
+
+	return bKnownReachable;
+}
+
+void AAsgardVRCharacter::AddReachableTeleportDestination(NavNodeRef GoalNodeRef)
+{
+	if (!bUseTeleportDestinationCache || GoalNodeRef == INVALID_NAVNODEREF || TeleportCacheOriginNodeRef == INVALID_NAVNODEREF)
+	{
+		return;
+	}
+
+	if (TeleportReachableNodeRefs.Num() >= TeleportDestinationCacheMaxEntries)
+	{
+		TeleportReachableNodeRefs.Reset();
+	}
+	TeleportReachableNodeRefs.Add(TeleportCacheOriginNodeRef);
+	TeleportReachableNodeRefs.Add(GoalNodeRef);
+
+	return;
+}
+
+void AAsgardVRCharacter::UpdateTeleportDestinationCacheOrigin()
+{
+	// Only find the polygon again if the character has moved
+	FVector OriginLocation = GetVRLocation();
+	OriginLocation.Z -= GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+	if (TeleportCacheOriginNodeRef != INVALID_NAVNODEREF
+		&& FVector::DistSquared(OriginLocation, TeleportCacheOriginLocation) <= FMath::Square(TeleportDestinationCacheOriginTolerance))
+	{
+		return;
+	}
+
+	TeleportCacheOriginLocation = OriginLocation;
+	TeleportCacheOriginNodeRef = FindPathfindingNodeRef(OriginLocation);
+
+	// If the character moved somewhere not known to be reachable, such as by falling or flying, nothing cached is known to be reachable from it
+	if (!TeleportReachableNodeRefs.Contains(TeleportCacheOriginNodeRef))
+	{
+		TeleportReachableNodeRefs.Reset();
+	}
+
+	return;
+}
+
+void AAsgardVRCharacter::RecordTeleportDestinationCacheLookup(bool bHit)
+{
+	TeleportCacheLookups++;
+	if (bHit)
+	{
+		TeleportCacheHits++;
+		INC_DWORD_STAT(STAT_ASGARD_VRCharacterTeleportCacheHits);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_ASGARD_VRCharacterTeleportCacheMisses);
+	}
+	SET_FLOAT_STAT(STAT_ASGARD_VRCharacterTeleportCacheHitRate, (100.0f * TeleportCacheHits) / TeleportCacheLookups);
+
+	return;
+}
+
+void AAsgardVRCharacter::ClearTeleportDestinationCache()
+{
+	TeleportReachableNodeRefs.Reset();
+	TeleportCacheOriginNodeRef = INVALID_NAVNODEREF;
+
+	return;
+}
+
+void AAsgardVRCharacter::OnNavigationGenerationFinished(ANavigationData* NavData)
+{
+	// Polygon refs are not stable across rebuilds
+	ClearTeleportDestinationCache();
+
+	return;
+}
+
 void AAsgardVRCharacter::UpdateSmoothWalk()
 {
 	// If we can walk
@@ -1568,6 +1894,16 @@ void AAsgardVRCharacter::UpdatePrecisionTeleport(float DeltaSeconds)
 			}
 		}
 
+		// If previewing asynchronously, apply the results from the previous update and start the next sweeps
+		if (bIsPrecisionTeleportPreviewAsync)
+		{
+			ApplyPrecisionTeleportSweepResults();
+			StartPrecisionTeleportSweeps(
+				PrecisionTeleportOrientationComponent->GetComponentLocation(),
+				PrecisionTeleportTraceDirection * PrecisionTeleportTraceMagnitude);
+			return;
+		}
+
 		// Perform the teleport trace
 		bIsPrecisionTeleportLocationValid = TraceForTeleportLocation(
 			PrecisionTeleportOrientationComponent->GetComponentLocation(),
@@ -1577,6 +1913,7 @@ void AAsgardVRCharacter::UpdatePrecisionTeleport(float DeltaSeconds)
 			PrecisionTeleportLocation,
 			&PrecisionTeleportImpactPoint,
 			&PrecisionTeleportTracePath);
+		UpdateTeleportArcRenderComponent();
 
 		return;
 	}
@@ -1622,6 +1959,9 @@ void AAsgardVRCharacter::StartPrecisionTeleport()
 	bIsPrecisionTeleportLocationValid = false;
 	PrecisionTeleportTraceDirection = PrecisionTeleportOrientationComponent->GetForwardVector();
 	bIsPrecisionTeleportActive = true;
+	CancelAsyncPrecisionTeleportPreview();
+	bIsPrecisionTeleportPreviewAsync = bUseAsyncPrecisionTeleportPreview && PrecisionTeleportAsyncPreview->GetInt();
+	ReserveTeleportArcBuffers();
 	
 	return;
 }
@@ -1629,14 +1969,305 @@ void AAsgardVRCharacter::StartPrecisionTeleport()
 void AAsgardVRCharacter::StopPrecisionTeleport()
 {
 	bIsPrecisionTeleportActive = false;
+	CancelAsyncPrecisionTeleportPreview();
+	if (TeleportArcRenderComponent)
+	{
+		TeleportArcRenderComponent->SetLashPoints(TArray<FVector>());
+	}
 	if (bIsPrecisionTeleportLocationValid && CanTeleport())
 	{
+		// Async previews may be out of date, so validate the location synchronously before committing to it
+		if (bIsPrecisionTeleportPreviewAsync)
+		{
+			bIsPrecisionTeleportLocationValid = TraceForTeleportLocation(
+				PrecisionTeleportOrientationComponent->GetComponentLocation(),
+				PrecisionTeleportTraceDirection * PrecisionTeleportTraceMagnitude,
+				bPrecisionTeleportLocationRequiresNavmeshPath,
+				PrecisionTeleportTraceChannel,
+				PrecisionTeleportLocation,
+				&PrecisionTeleportImpactPoint);
+			if (!bIsPrecisionTeleportLocationValid)
+			{
+				return;
+			}
+		}
+
 		TeleportToLocation(PrecisionTeleportLocation, TeleportToLocationDefaultMode);
 	}
 
 	return;
 }
 
+void AAsgardVRCharacter::StartPrecisionTeleportSweeps(const FVector& TraceOrigin, const FVector& TraceVelocity)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	// Cache variables
+	const float GravityZ = World->GetGravityZ();
+	const float StepTime = 1.0f / AsgardVRCharacter::TeleportTraceSimFrequency;
+	const int32 NumSteps = FMath::CeilToInt(TeleportTraceMaxSimTime * AsgardVRCharacter::TeleportTraceSimFrequency);
+	const FCollisionShape TraceShape = FCollisionShape::MakeSphere(TeleportTraceRadius);
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(AsgardPrecisionTeleportAsyncSweep), false, this);
+	FVector Location = TraceOrigin;
+	FVector Velocity = TraceVelocity;
+
+	// The arc moves little between updates, so only sweep a few steps past where it hit last time.
+	// If none of those hit, the whole arc is swept on the next update
+	const int32 NumStepsToSweep = PrecisionTeleportLastHitStep == INDEX_NONE ? NumSteps : FMath::Min(PrecisionTeleportLastHitStep + 1 + AsgardVRCharacter::PrecisionTeleportSweepStepMargin, NumSteps);
+
+	// Tag the sweeps, so results from an earlier request are never mistaken for these
+	PrecisionTeleportPreviewGeneration++;
+
+	// Start a sweep for each step of the arc, integrating the same way as TraceTeleportArc
+	PrecisionTeleportSweepHandles.Reset();
+	PrecisionTeleportSweepPoints.Reset();
+	PrecisionTeleportSweepPoints.Add(Location);
+	for (int32 StepIdx = 0; StepIdx < NumSteps; StepIdx++)
+	{
+		const float SubstepTime = FMath::Min(StepTime, TeleportTraceMaxSimTime - (StepIdx * StepTime));
+		const FVector OldVelocity = Velocity;
+		Velocity.Z += GravityZ * SubstepTime;
+		const FVector NextLocation = Location + ((OldVelocity + Velocity) * (0.5f * SubstepTime));
+		if (StepIdx < NumStepsToSweep)
+		{
+			PrecisionTeleportSweepHandles.Add(World->AsyncSweepByChannel(
+				EAsyncTraceType::Single,
+				Location,
+				NextLocation,
+				FQuat::Identity,
+				PrecisionTeleportTraceChannel,
+				TraceShape,
+				TraceParams,
+				FCollisionResponseParams::DefaultResponseParam,
+				nullptr,
+				PrecisionTeleportPreviewGeneration));
+		}
+		PrecisionTeleportSweepPoints.Add(NextLocation);
+		Location = NextLocation;
+	}
+
+	return;
+}
+
+void AAsgardVRCharacter::ApplyPrecisionTeleportSweepResults()
+{
+	UWorld* World = GetWorld();
+	if (!World || PrecisionTeleportSweepHandles.Num() <= 0)
+	{
+		return;
+	}
+
+	// Find the first step of the arc that hit something
+	FHitResult ArcHit;
+	bool bArcHit = false;
+	int32 NumSweptSteps = 0;
+	for (const FTraceHandle& SweepHandle : PrecisionTeleportSweepHandles)
+	{
+		FTraceDatum SweepDatum;
+		if (!World->QueryTraceData(SweepHandle, SweepDatum) || SweepDatum.UserData != PrecisionTeleportPreviewGeneration)
+		{
+			// Results are missing, so keep the previous result rather than guessing
+			PrecisionTeleportSweepHandles.Reset();
+			return;
+		}
+
+		NumSweptSteps++;
+		if (SweepDatum.OutHits.Num() > 0 && SweepDatum.OutHits[0].bBlockingHit)
+		{
+			ArcHit = SweepDatum.OutHits[0];
+			bArcHit = true;
+			break;
+		}
+	}
+	PrecisionTeleportSweepHandles.Reset();
+
+	// If the async sweeps stopped short of the end of the arc without hitting, they cannot tell where it lands.
+	// Keep the previous result, and sweep the whole arc asynchronously from the next sweeps instead of stalling this frame
+	if (!bArcHit && NumSweptSteps < PrecisionTeleportSweepPoints.Num() - 1)
+	{
+		PrecisionTeleportLastHitStep = INDEX_NONE;
+		return;
+	}
+
+	// This result replaces the previous one, so path tests asked for before it no longer apply
+	PrecisionTeleportResultGeneration++;
+	PrecisionTeleportLastHitStep = bArcHit ? NumSweptSteps - 1 : INDEX_NONE;
+
+	// Update path points
+	PrecisionTeleportTracePath.Reset();
+	PrecisionTeleportTracePath.Append(PrecisionTeleportSweepPoints.GetData(), bArcHit ? NumSweptSteps : PrecisionTeleportSweepPoints.Num());
+	if (bArcHit)
+	{
+		PrecisionTeleportTracePath.Add(ArcHit.Location);
+	}
+	UpdateTeleportArcRenderComponent();
+	if (!bArcHit)
+	{
+		bIsPrecisionTeleportLocationValid = false;
+		return;
+	}
+
+	// Validate the location found
+	PrecisionTeleportImpactPoint = ArcHit.ImpactPoint;
+	TELEPORT_LOC(ArcHit.ImpactPoint, 20.0f, FColor::Yellow);
+	FVector CandidateLocation;
+	if (!ProjectPointToVRNavigation(ArcHit.ImpactPoint, CandidateLocation, true))
+	{
+		bIsPrecisionTeleportLocationValid = false;
+		return;
+	}
+
+	// Path tests run on the pathfinding navmesh, so identify the candidate by its polygon there
+	const NavNodeRef CandidateNodeRef = bPrecisionTeleportLocationRequiresNavmeshPath ? FindPathfindingNodeRef(CandidateLocation) : INVALID_NAVNODEREF;
+
+	if (bPrecisionTeleportLocationRequiresNavmeshPath && !IsTeleportDestinationKnownReachable(CandidateNodeRef))
+	{
+		StartPrecisionTeleportPathTest(CandidateLocation, CandidateNodeRef);
+		return;
+	}
+
+	PrecisionTeleportLocation = CandidateLocation;
+	bIsPrecisionTeleportLocationValid = true;
+	TELEPORT_LOC(PrecisionTeleportLocation, 25.0f, FColor::Cyan);
+
+	return;
+}
+
+void AAsgardVRCharacter::StartPrecisionTeleportPathTest(const FVector& GoalLocation, NavNodeRef GoalNodeRef)
+{
+	// If the running test is already for this polygon, it still answers the latest result
+	if (PrecisionTeleportPathQueryId != INVALID_NAVQUERYID && GoalNodeRef != INVALID_NAVNODEREF && GoalNodeRef == PrecisionTeleportPathTestGoalNodeRef)
+	{
+		bPrecisionTeleportPathTestQueued = false;
+		PrecisionTeleportPathTestGoal = GoalLocation;
+		PrecisionTeleportPathTestGeneration = PrecisionTeleportResultGeneration;
+		return;
+	}
+
+	// Only run one path test at a time, keeping the latest candidate queued
+	if (PrecisionTeleportPathQueryId != INVALID_NAVQUERYID)
+	{
+		bPrecisionTeleportPathTestQueued = true;
+		QueuedPrecisionTeleportPathTestGoal = GoalLocation;
+		QueuedPrecisionTeleportPathTestGoalNodeRef = GoalNodeRef;
+		QueuedPrecisionTeleportPathTestGeneration = PrecisionTeleportResultGeneration;
+		return;
+	}
+
+	UNavigationSystemV1* const NavSys = UNavigationSystemV1::GetCurrent(GetWorld());
+	if (!NavSys || !PathfindingNavData)
+	{
+		bIsPrecisionTeleportLocationValid = false;
+		return;
+	}
+
+	FPathFindingQuery QuerySettings;
+	QuerySettings.StartLocation = GetVRLocation();
+	QuerySettings.StartLocation.Z -= GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+	QuerySettings.EndLocation = GoalLocation;
+	QuerySettings.bAllowPartialPaths = false;
+	QuerySettings.NavData = PathfindingNavData;
+	QuerySettings.NavAgentProperties = PathfindingNavAgentProperties;
+	QuerySettings.QueryFilter = UNavigationQueryFilter::GetQueryFilter(*PathfindingNavData, NavQueryFilter);
+	PrecisionTeleportPathTestGoal = GoalLocation;
+	PrecisionTeleportPathTestGoalNodeRef = GoalNodeRef;
+	PrecisionTeleportPathTestGeneration = PrecisionTeleportResultGeneration;
+	PrecisionTeleportPathQueryId = NavSys->FindPathAsync(
+		PathfindingNavAgentProperties,
+		QuerySettings,
+		FNavPathQueryDelegate::CreateUObject(this, &AAsgardVRCharacter::OnPrecisionTeleportPathTestCompleted));
+
+	return;
+}
+
+void AAsgardVRCharacter::OnPrecisionTeleportPathTestCompleted(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	if (QueryId != PrecisionTeleportPathQueryId)
+	{
+		return;
+	}
+	PrecisionTeleportPathQueryId = INVALID_NAVQUERYID;
+
+	if (bIsPrecisionTeleportActive)
+	{
+		// Reachability does not change with the arc, so cache it even if the arc has moved on
+		const bool bPathFound = Result == ENavigationQueryResult::Success && Path.IsValid() && !Path->IsPartial();
+		if (bPathFound)
+		{
+			AddReachableTeleportDestination(PrecisionTeleportPathTestGoalNodeRef);
+		}
+
+		// Only update the location if no sweep result has replaced the one that asked for this test
+		if (PrecisionTeleportPathTestGeneration == PrecisionTeleportResultGeneration)
+		{
+			bIsPrecisionTeleportLocationValid = bPathFound;
+			if (bIsPrecisionTeleportLocationValid)
+			{
+				PrecisionTeleportLocation = PrecisionTeleportPathTestGoal;
+				TELEPORT_LOC(PrecisionTeleportLocation, 25.0f, FColor::Cyan);
+			}
+		}
+
+		// Start the queued test, if any, unless a newer result has made it stale too
+		if (bPrecisionTeleportPathTestQueued)
+		{
+			bPrecisionTeleportPathTestQueued = false;
+			if (QueuedPrecisionTeleportPathTestGeneration == PrecisionTeleportResultGeneration)
+			{
+				StartPrecisionTeleportPathTest(QueuedPrecisionTeleportPathTestGoal, QueuedPrecisionTeleportPathTestGoalNodeRef);
+			}
+		}
+	}
+
+	return;
+}
+
+void AAsgardVRCharacter::CancelAsyncPrecisionTeleportPreview()
+{
+	// Sweeps cannot be cancelled, but moving to a new generation means their results are ignored
+	PrecisionTeleportSweepHandles.Reset();
+	PrecisionTeleportPreviewGeneration++;
+	PrecisionTeleportResultGeneration++;
+	PrecisionTeleportLastHitStep = INDEX_NONE;
+	bPrecisionTeleportPathTestQueued = false;
+	if (PrecisionTeleportPathQueryId != INVALID_NAVQUERYID)
+	{
+		UNavigationSystemV1* const NavSys = UNavigationSystemV1::GetCurrent(GetWorld());
+		if (NavSys)
+		{
+			NavSys->AbortAsyncFindPathRequest(PrecisionTeleportPathQueryId);
+		}
+		PrecisionTeleportPathQueryId = INVALID_NAVQUERYID;
+	}
+
+	return;
+}
+
+void AAsgardVRCharacter::ReserveTeleportArcBuffers()
+{
+	// Reserve only grows the buffers, so this is free once they have been sized
+	const int32 MaxArcPoints = GetMaxTeleportArcPoints();
+	PrecisionTeleportTracePath.Reserve(MaxArcPoints);
+	PrecisionTeleportSweepPoints.Reserve(MaxArcPoints);
+	PrecisionTeleportSweepHandles.Reserve(MaxArcPoints - 1);
+
+	return;
+}
+
+void AAsgardVRCharacter::UpdateTeleportArcRenderComponent()
+{
+	if (TeleportArcRenderComponent)
+	{
+		TeleportArcRenderComponent->SetLashPoints(PrecisionTeleportTracePath);
+	}
+
+	return;
+}
+
 const FVector AAsgardVRCharacter::CalculateCircularInputVector(FVector RawInputVector, float DeadZone, float MaxZone) const
 {
 	checkf(DeadZone < 1.0f && DeadZone >= 0.0f, 
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Asgard/Core/AsgardOptionsTypes.h"
 #include "VRCharacter.h"
+#include "NavigationData.h"
 #include "AsgardVRCharacter.generated.h"
 
 // Delegates
@@ -43,6 +44,7 @@ enum class EAsgard2DAxis : uint8
 
 // Forward declarations
 class UAsgardVRMovementComponent;
+class UAsgardLashRenderComponent;
 
 
 /** Base class for the player avatar. */
@@ -55,6 +57,7 @@ public:
 	// Overrides
 	AAsgardVRCharacter(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Tick(float DeltaSeconds) override;
 
 	// ---------------------------------------------------------
@@ -157,6 +160,22 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AsgardVRCharacter|Movement")
 	FVector NavQueryExtent;
 
+	/**
+	* Whether to cache teleport destination checks by polygon of the pathfinding navmesh.
+	* Polygons found to be reachable from the character's polygon skip the navmesh path test.
+	* The cache is cleared when the navmesh is rebuilt, or when the character moves to a polygon not known to be reachable.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AsgardVRCharacter|Movement|TeleportCache")
+	bool bUseTeleportDestinationCache;
+
+	/** The maximum number of polygons remembered by the teleport destination cache before it is cleared. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AsgardVRCharacter|Movement|TeleportCache", meta = (ClampMin = "1"))
+	int32 TeleportDestinationCacheMaxEntries;
+
+	/** How far the character can move before its navmesh polygon is found again for the teleport destination cache. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AsgardVRCharacter|Movement|TeleportCache", meta = (ClampMin = "0.0"))
+	float TeleportDestinationCacheOriginTolerance;
+
 
 	// ---------------------------------------------------------
 	//	Universal teleport settings
@@ -255,6 +274,22 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AsgardVRCharacter|Movement|PrecisionTeleport")
 	TEnumAsByte<ECollisionChannel> PrecisionTeleportTraceChannel;
 
+	/**
+	* Whether to update the Precision Teleport preview asynchronously.
+	* If enabled, the arc is swept with async traces and the navmesh path is tested with an async path query,
+	* so the preview is one frame or more out of date but never stalls the frame. The last valid location is kept while results are pending.
+	* The location is always validated synchronously when the teleport is committed.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AsgardVRCharacter|Movement|PrecisionTeleport")
+	bool bUseAsyncPrecisionTeleportPreview;
+
+	/**
+	* Optional component used to render the Precision Teleport arc.
+	* If set, the arc is sent straight to it whenever the trace path updates, and cleared when the Precision Teleport stops.
+	*/
+	UPROPERTY(BlueprintReadWrite, Category = "AsgardVRCharacter|Movement|PrecisionTeleport")
+	UAsgardLashRenderComponent* TeleportArcRenderComponent;
+
 
 	// ---------------------------------------------------------
 	//	Teleport turn settings
@@ -573,6 +608,31 @@ private:
 	/**  Checks to see if a path exists to a specified point, according to the navigation settings on this actor. */
 	bool DoesPathToPointExistVR(const FVector& GoalLocation);
 
+	/** Version of DoesPathToPointExistVR that consults the teleport destination cache first, and records the result in it. */
+	bool DoesCachedPathToPointExistVR(const FVector& GoalLocation);
+
+	/** Returns the polygon of the pathfinding navmesh a location projects to, or INVALID_NAVNODEREF if it does not project. */
+	NavNodeRef FindPathfindingNodeRef(const FVector& Location) const;
+
+	/** Returns whether a pathfinding navmesh polygon is known to be reachable from the character's current polygon. */
+	bool IsTeleportDestinationKnownReachable(NavNodeRef GoalNodeRef);
+
+	/** Records that a pathfinding navmesh polygon is reachable from the character's current polygon. */
+	void AddReachableTeleportDestination(NavNodeRef GoalNodeRef);
+
+	/** Finds the character's navmesh polygon again if it has moved, clearing reachable polygons if it moved somewhere unknown. */
+	void UpdateTeleportDestinationCacheOrigin();
+
+	/** Updates the teleport destination cache hit rate stat. */
+	void RecordTeleportDestinationCacheLookup(bool bHit);
+
+	/** Clears the teleport destination cache. */
+	void ClearTeleportDestinationCache();
+
+	/** Called when navmesh generation finishes, to clear the teleport destination cache. */
+	UFUNCTION()
+	void OnNavigationGenerationFinished(ANavigationData* NavData);
+
 	/** Updates walking input depending on current settings and player input. */
 	void UpdateSmoothWalk();
 
@@ -615,6 +675,41 @@ private:
 		FVector* OptionalOutImpactPoint = nullptr,
 		TArray<FVector>* OptionalOutTracePathPoints = nullptr);
 
+	/**
+	* Simulates a teleport arc with sphere sweeps at the given frequency, stopping at the first blocking hit.
+	* Returns true if the arc hit something within TeleportTraceMaxSimTime.
+	* If provided, the path points are written into OptionalOutTracePathPoints without freeing its allocation.
+	* ExtraRadius is added to TeleportTraceRadius for the sweeps.
+	*/
+	bool TraceTeleportArc(
+		const FVector& TraceOrigin,
+		const FVector& TraceVelocity,
+		TEnumAsByte<ECollisionChannel> TraceChannel,
+		float SimFrequency,
+		FHitResult& OutHit,
+		TArray<FVector>* OptionalOutTracePathPoints = nullptr,
+		float ExtraRadius = 0.0f) const;
+
+	/** Returns the maximum number of points in a teleport arc traced within TeleportTraceMaxSimTime. */
+	int32 GetMaxTeleportArcPoints() const;
+
+	/**
+	* Evaluates the fallback arcs of a teleport in direction in fallback order, returning the first one that succeeds.
+	* Every fallback after the first is traced coarsely with a padded radius before it is traced in full.
+	* The padding covers the gap between the coarse and the full arc, so a coarse miss means the full trace would miss too and the fallback is skipped.
+	* Stops once the query budget is used up.
+	*/
+	bool TraceForFallbackTeleportLocation(
+		const FVector& TraceOrigin,
+		const FVector& Direction,
+		float FirstMagnitude,
+		float MagnitudeInterval,
+		int32 NumCandidates,
+		bool bRequiresNavmeshPath,
+		TEnumAsByte<ECollisionChannel> TraceChannel,
+		double QueryStartTime,
+		FVector& OutTeleportLocation);
+
 	/**
 	* Attempts to teleport to the target location, using the given teleport mode.
 	* Returns whether the initial request succeeeded.
@@ -655,6 +750,33 @@ private:
 	/** Updates a Precision Teleport trace for a teleport location. */
 	void UpdatePrecisionTeleport(float DeltaSeconds);
 
+	/**
+	* Starts async sweeps along the steps of the Precision Teleport arc. Results are read on the next update.
+	* Once the arc has hit something, only the steps up to a few past the previous hit are swept.
+	*/
+	void StartPrecisionTeleportSweeps(const FVector& TraceOrigin, const FVector& TraceVelocity);
+
+	/**
+	* Reads the results of the async sweeps started on the previous update, and validates the location they found.
+	* If the sweeps stopped short of the end of the arc without hitting anything, the previous result is kept and the next sweeps cover the whole arc.
+	*/
+	void ApplyPrecisionTeleportSweepResults();
+
+	/** Starts an async navmesh path test to a Precision Teleport candidate location, or queues it if a test is already running. */
+	void StartPrecisionTeleportPathTest(const FVector& GoalLocation, NavNodeRef GoalNodeRef);
+
+	/** Called when the async navmesh path test for a Precision Teleport candidate location completes. */
+	void OnPrecisionTeleportPathTestCompleted(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	/** Cancels any outstanding async work of the Precision Teleport preview. */
+	void CancelAsyncPrecisionTeleportPreview();
+
+	/** Sizes the Precision Teleport arc buffers to hold the longest possible arc, so previewing does not reallocate them. */
+	void ReserveTeleportArcBuffers();
+
+	/** Sends the Precision Teleport trace path to the TeleportArcRenderComponent, if any. */
+	void UpdateTeleportArcRenderComponent();
+
 	/** 
 	* Retrieves the orientated forward and right vector, flattened onto the X and Y axis according to the orientation mode. 
 	* @param OrientationComponent If this is null, function will returns the VR forward and Right vectors.
@@ -808,7 +930,10 @@ private:
 	UPROPERTY(BlueprintReadOnly, Category = "AsgardVRCharacter|Movement|PrecisionTeleport", meta = (AllowPrivateAccess = "true"))
 	FVector PrecisionTeleportImpactPoint;
 
-	/** The most recent trace path returned by a Precision Teleport trace.  */
+	/**
+	* The most recent trace path returned by a Precision Teleport trace.
+	* Persistent and sized to GetMaxTeleportArcPoints, so it is refilled in place every update.
+	*/
 	UPROPERTY(BlueprintReadOnly, Category = "AsgardVRCharacter|Movement|PrecisionTeleport", meta = (AllowPrivateAccess = "true"))
 	TArray<FVector> PrecisionTeleportTracePath;
 	
@@ -816,6 +941,65 @@ private:
 	UPROPERTY(BlueprintReadOnly, Category = "AsgardVRCharacter|Movement|PrecisionTeleport", meta = (AllowPrivateAccess = "true"))
 	FVector PrecisionTeleportTraceDirection;
 
+	/** Whether the active Precision Teleport is being previewed asynchronously. */
+	bool bIsPrecisionTeleportPreviewAsync;
+
+	/** Handles of the async sweeps along the steps of the Precision Teleport arc, in order. */
+	TArray<FTraceHandle> PrecisionTeleportSweepHandles;
+
+	/** Points along the whole Precision Teleport arc, including steps that were not swept asynchronously. */
+	TArray<FVector> PrecisionTeleportSweepPoints;
+
+	/** Step of the Precision Teleport arc that hit something on the previous update, or INDEX_NONE if it hit nothing. */
+	int32 PrecisionTeleportLastHitStep;
+
+	/** Generation of the latest async sweeps, passed as their user data so results of earlier sweeps are ignored. */
+	uint32 PrecisionTeleportPreviewGeneration;
+
+	/** Generation of the latest applied sweep result. Path tests only update the location if no newer result was applied. */
+	uint32 PrecisionTeleportResultGeneration;
+
+	/** Result generation that last asked for the running path test. */
+	uint32 PrecisionTeleportPathTestGeneration;
+
+	/** Id of the running async path test, if any. */
+	uint32 PrecisionTeleportPathQueryId;
+
+	/** Location being tested by the running async path test. */
+	FVector PrecisionTeleportPathTestGoal;
+
+	/** Navmesh polygon of the location being tested by the running async path test. */
+	NavNodeRef PrecisionTeleportPathTestGoalNodeRef;
+
+	/** Whether a path test is queued to start once the running one completes. */
+	bool bPrecisionTeleportPathTestQueued;
+
+	/** Location of the queued path test. */
+	FVector QueuedPrecisionTeleportPathTestGoal;
+
+	/** Navmesh polygon of the location of the queued path test. */
+	NavNodeRef QueuedPrecisionTeleportPathTestGoalNodeRef;
+
+	/** Result generation that asked for the queued path test. */
+	uint32 QueuedPrecisionTeleportPathTestGeneration;
+
+
+	// ---------------------------------------------------------
+	//	Teleport destination cache state
+
+	/** Pathfinding navmesh polygons known to be reachable from each other, including the character's current polygon. */
+	TSet<NavNodeRef> TeleportReachableNodeRefs;
+
+	/** The character's pathfinding navmesh polygon, when it was last found. */
+	NavNodeRef TeleportCacheOriginNodeRef;
+
+	/** The character's location, when its navmesh polygon was last found. */
+	FVector TeleportCacheOriginLocation;
+
+	/** Number of teleport destination cache lookups, and how many of them hit. */
+	uint32 TeleportCacheLookups;
+	uint32 TeleportCacheHits;
+
 
 	// ---------------------------------------------------------
 	//	Teleport turn state